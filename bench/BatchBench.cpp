@@ -0,0 +1,242 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkInputs.h"
+
+#include "../src/BatchCoder.h"
+#include "../src/Decoder.h"
+#include "../src/Encoder.h"
+
+/**
+*   \brief Splits a comma separated list
+*   \param str list to split
+*   \return items of the list
+*/
+std::vector<std::string> splitList(const std::string& str)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(str);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty()) items.push_back(item);
+	}
+
+	return items;
+}
+
+/**
+*   \brief Prints one line of results
+*   \param input name of the input
+*   \param recordSize size of every record in bytes
+*   \param mode name of the way the records were processed
+*   \param records uncoded records
+*   \param coded encoded records
+*   \param encodeResult time of encoding all records
+*   \param decodeResult time of decoding all records
+*/
+void report(const std::string& input, uint64_t recordSize, const char* mode, const std::vector<std::string>& records, const std::vector<std::string>& coded,
+	const BenchmarkResult& encodeResult, const BenchmarkResult& decodeResult)
+{
+	uint64_t uncodedSize = 0;
+	uint64_t codedSize = 0;
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		uncodedSize += records[i].size();
+		codedSize += coded[i].size();
+	}
+
+	std::cout << std::left << std::setw(8) << input << std::right << std::setw(8) << recordSize << std::setw(8) << records.size() << "  "
+		<< std::left << std::setw(11) << mode << std::right << std::fixed << std::setprecision(4)
+		<< std::setw(8) << static_cast<double>(codedSize) / uncodedSize << std::setprecision(2)
+		<< std::setw(13) << Benchmark::getThroughput(uncodedSize, encodeResult.m_medianTime)
+		<< std::setw(12) << records.size() / encodeResult.m_medianTime
+		<< std::setw(13) << Benchmark::getThroughput(uncodedSize, decodeResult.m_medianTime)
+		<< std::setw(12) << records.size() / decodeResult.m_medianTime << "\n";
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string textFile = BWTED_TEST_FILE;
+	std::vector<std::string> inputs = { "text", "records", "dna" };
+	std::vector<std::string> sizes = { "1024", "4096", "16384", "51200" };
+	uint64_t count = 1000;    //number of records of every batch
+	int level = BWT_MTF_RLE_Huffman_Coder::DEFAULT_LEVEL;
+	unsigned threadCount = 1; //a single thread gives stable numbers
+	std::string modelFile;    //shared entropy model, none by default
+	Benchmark benchmark;
+	benchmark.setRepetitionCount(3);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-i" && i < argc - 1)
+		{
+			textFile = argv[++i];
+		}
+		else if (arg == "--inputs" && i < argc - 1)
+		{
+			inputs = splitList(argv[++i]);
+		}
+		else if (arg == "--sizes" && i < argc - 1)
+		{
+			sizes = splitList(argv[++i]);
+		}
+		else if (arg == "--count" && i < argc - 1)
+		{
+			count = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg.size() == 2 && arg[0] == '-' && arg[1] >= '1' && arg[1] <= '9')
+		{
+			level = arg[1] - '0';
+		}
+		else if (arg == "--model" && i < argc - 1)
+		{
+			modelFile = argv[++i];
+		}
+		else if (arg == "--threads" && i < argc - 1)
+		{
+			threadCount = std::atoi(argv[++i]);
+		}
+		else if (arg == "--warmup" && i < argc - 1)
+		{
+			benchmark.setWarmupCount(std::atoi(argv[++i]));
+		}
+		else if (arg == "--repetitions" && i < argc - 1)
+		{
+			benchmark.setRepetitionCount(std::atoi(argv[++i]));
+		}
+		else
+		{
+			std::cout << "bwted_batch [-i <textFile>] [--inputs <list>] [--sizes <list>] [--count <records>] [-1 ... -9] [--model <modelFile>] [--threads <count>] [--warmup <count>] [--repetitions <count>]\n";
+			std::cout << "-i <textFile>: file used for the text input. Default: " << BWTED_TEST_FILE << "\n";
+			std::cout << "--inputs <list>: comma separated inputs, any of zeros, runs, periodic, random, text, dna, records. Default: text,records,dna.\n";
+			std::cout << "--sizes <list>: comma separated record sizes in bytes. Default: 1024,4096,16384,51200.\n";
+			std::cout << "--count <records>: number of records of every batch. Default: 1000.\n";
+			std::cout << "-1 ... -9: compression level of the coder. Default: -5.\n";
+			std::cout << "--model <modelFile>: shared entropy model written by bwted --train, used by both modes. Default: none.\n";
+			std::cout << "--threads <count>: number of threads of the coder. Default: 1.\n";
+			std::cout << "--warmup <count>: number of runs before the measured ones. Default: 1.\n";
+			std::cout << "--repetitions <count>: number of measured runs, the median is reported. Default: 3.\n";
+			return (arg == "-h") ? 0 : -1;
+		}
+	}
+
+	BenchmarkInputs generator(textFile);
+	BWT_MTF_RLE_Huffman_Coder coder;
+	coder.setLevel(level);
+	coder.setThreadCount(threadCount);
+
+	if (!modelFile.empty())
+	{
+		std::ifstream modelStream(modelFile, std::ifstream::in | std::ifstream::binary);
+		std::shared_ptr<EntropyModel> model = std::make_shared<EntropyModel>();
+
+		if (!modelStream.is_open() || !model->read(modelStream))
+		{
+			std::cout << "The model file \"" << modelFile << "\" couldn't be read!\n";
+			return -1;
+		}
+
+		coder.setModel(model);
+	}
+
+	//the batch coder is set up once, like in a server which compresses every request with it
+	BatchCoder batchCoder(coder);
+
+	std::cout << "input   record   count  mode          ratio  encode MB/s  encode rec/s  decode MB/s  decode rec/s\n";
+
+	for (const std::string& input : inputs)
+	{
+		for (const std::string& sizeStr : sizes)
+		{
+			uint64_t size = std::strtoull(sizeStr.c_str(), nullptr, 10);
+			std::string data;
+
+			//the records are consecutive pieces of one input, so that they differ like the messages of a real workload
+			if (size == 0 || count == 0 || !generator.generate(input, size * count, data))
+			{
+				std::cout << "The input \"" << input << "\" of size \"" << sizeStr << "\" couldn't be generated!\n";
+				return -1;
+			}
+
+			std::vector<std::string> records;
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				records.push_back(data.substr(i * size, size));
+			}
+
+			bool success = true;
+
+			//every record on its own with the push API, each encoder and decoder is set up for a single record
+			std::vector<std::string> coded(records.size());
+			std::vector<std::string> decoded(records.size());
+
+			BenchmarkResult encodeResult = benchmark.measure([&]()
+			{
+				for (size_t i = 0; i < records.size(); ++i)
+				{
+					coded[i].clear();
+					Encoder encoder(coder, [&coded, i](const char* data, size_t size) { coded[i].append(data, size); return true; });
+					success = encoder.write(records[i].data(), records[i].size()) && encoder.finish() && success;
+				}
+			});
+
+			BenchmarkResult decodeResult = benchmark.measure([&]()
+			{
+				for (size_t i = 0; i < coded.size(); ++i)
+				{
+					decoded[i].clear();
+					Decoder decoder(coder, [&decoded, i](const char* data, size_t size) { decoded[i].append(data, size); return true; });
+					success = decoder.write(coded[i].data(), coded[i].size()) && decoder.finish() && success;
+				}
+			});
+
+			if (!success || decoded != records)
+			{
+				std::cout << "The round trip of the input \"" << input << "\" with records of " << size << " bytes failed!\n";
+				return -1;
+			}
+
+			report(input, size, "per-record", records, coded, encodeResult, decodeResult);
+
+			//all records in one call of the batch coder
+			std::vector<std::string> batchCoded;
+			std::vector<std::string> batchDecoded;
+
+			encodeResult = benchmark.measure([&]()
+			{
+				Log log;
+				success = batchCoder.encode(log, records, batchCoded) && success;
+			});
+
+			decodeResult = benchmark.measure([&]()
+			{
+				Log log;
+				success = batchCoder.decode(log, batchCoded, batchDecoded) && success;
+			});
+
+			//the batch coder must write the same streams, so that they can be decoded by any decoder
+			if (!success || batchCoded != coded || batchDecoded != records)
+			{
+				std::cout << "The batch round trip of the input \"" << input << "\" with records of " << size << " bytes failed!\n";
+				return -1;
+			}
+
+			report(input, size, "batch", records, batchCoded, encodeResult, decodeResult);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,36 @@
+#include "Benchmark.h"
+
+void Benchmark::setWarmupCount(unsigned warmupCount)
+{
+	m_warmupCount = warmupCount;
+}
+
+unsigned Benchmark::getWarmupCount() const
+{
+	return m_warmupCount;
+}
+
+void Benchmark::setRepetitionCount(unsigned repetitionCount)
+{
+	m_repetitionCount = std::max(repetitionCount, 1u);
+}
+
+unsigned Benchmark::getRepetitionCount() const
+{
+	return m_repetitionCount;
+}
+
+void Benchmark::setCounters(PerfCounters* counters)
+{
+	m_counters = counters;
+}
+
+double Benchmark::getThroughput(uint64_t size, double time)
+{
+	return (time > 0.0) ? size / time / 1e6 : 0.0;
+}
+
+double Benchmark::getTimePerByte(uint64_t size, double time)
+{
+	return (size > 0) ? time * 1e9 / size : 0.0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "PerfCounters.h"
+
+/**
+*   result of measuring a single operation
+*/
+struct BenchmarkResult
+{
+	double m_medianTime = 0.0; //!< median time of one repetition in seconds
+	double m_minTime = 0.0;    //!< shortest time of one repetition in seconds
+	CounterValues m_counters;  //!< average values of the hardware counters per repetition, not valid without counters
+};
+
+/**
+*   Measures the time of an operation over several repetitions after a warmup
+*/
+class Benchmark
+{
+private:
+
+	unsigned m_warmupCount = 1;         //!< number of runs which aren't measured
+	unsigned m_repetitionCount = 5;     //!< number of measured runs
+	PerfCounters* m_counters = nullptr; //!< hardware counters read around every measured run, nullptr if they aren't read
+
+public:
+
+	/**
+	*   \brief Sets the number of runs before the measured ones, which fill the caches and let the CPU raise its clock
+	*   \param warmupCount number of runs which aren't measured
+	*/
+	void setWarmupCount(unsigned warmupCount);
+
+	/**
+	*   \brief Gets the number of runs before the measured ones
+	*   \return number of runs which aren't measured
+	*/
+	unsigned getWarmupCount() const;
+
+	/**
+	*   \brief Sets the number of measured runs
+	*   \param repetitionCount number of measured runs, at least 1
+	*/
+	void setRepetitionCount(unsigned repetitionCount);
+
+	/**
+	*   \brief Gets the number of measured runs
+	*   \return number of measured runs
+	*/
+	unsigned getRepetitionCount() const;
+
+	/**
+	*   \brief Sets the hardware counters read around every measured run
+	*   \param counters opened counters, nullptr to not read any
+	*/
+	void setCounters(PerfCounters* counters);
+
+	/**
+	*   \brief Measures an operation
+	*   \param operation callable without parameters, its result is discarded
+	*   \return median and shortest time of one run and the average values of the counters
+	*/
+	template <typename Operation>
+	BenchmarkResult measure(Operation operation) const
+	{
+		for (unsigned i = 0; i < m_warmupCount; ++i)
+		{
+			operation();
+		}
+
+		BenchmarkResult result;
+		std::array<unsigned, COUNTER_COUNT> counterRuns = {}; //number of runs in which every counter was valid
+
+		std::vector<double> times;
+		for (unsigned i = 0; i < m_repetitionCount; ++i)
+		{
+			//the timed region lies inside the counted one, so that the syscalls which control the counters aren't timed
+			if (m_counters != nullptr) m_counters->start();
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			operation();
+			times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+			if (m_counters != nullptr)
+			{
+				CounterValues values;
+				m_counters->stop(values);
+
+				for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+				{
+					if (!values.m_valid[counter]) continue;
+
+					result.m_counters.m_values[counter] += values.m_values[counter];
+					counterRuns[counter]++;
+				}
+			}
+		}
+
+		for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+		{
+			result.m_counters.m_valid[counter] = counterRuns[counter] > 0;
+			if (counterRuns[counter] > 0) result.m_counters.m_values[counter] /= counterRuns[counter];
+		}
+
+		std::sort(times.begin(), times.end());
+
+		result.m_medianTime = times[times.size() / 2];
+		result.m_minTime = times.front();
+
+		return result;
+	}
+
+	/**
+	*   \brief Computes the throughput
+	*   \param size number of processed bytes
+	*   \param time time in seconds
+	*   \return throughput in MB/s
+	*/
+	static double getThroughput(uint64_t size, double time);
+
+	/**
+	*   \brief Computes the time per byte
+	*   \param size number of processed bytes
+	*   \param time time in seconds
+	*   \return time in nanoseconds per byte
+	*/
+	static double getTimePerByte(uint64_t size, double time);
+};
@@ -0,0 +1,151 @@
+#include "BenchmarkBaseline.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <iterator>
+
+bool BenchmarkBaseline::parseResult(const std::string& str, size_t& position, CorpusResult& result)
+{
+	auto skipSpace = [&str, &position]()
+	{
+		while (position < str.size() && std::isspace(static_cast<unsigned char>(str[position]))) position++;
+	};
+
+	//reads a string without escape sequences, the writer never produces them
+	auto readString = [&str, &position](std::string& value)
+	{
+		if (position >= str.size() || str[position] != '"') return false;
+
+		size_t end = str.find('"', position + 1);
+		if (end == std::string::npos) return false;
+
+		value = str.substr(position + 1, end - position - 1);
+		position = end + 1;
+
+		return true;
+	};
+
+	if (position >= str.size() || str[position] != '{') return false;
+	position++;
+
+	while (true)
+	{
+		skipSpace();
+		if (position >= str.size()) return false;
+
+		if (str[position] == '}')
+		{
+			position++;
+			return true;
+		}
+
+		if (str[position] == ',')
+		{
+			position++;
+			continue;
+		}
+
+		std::string key;
+		if (!readString(key)) return false;
+
+		skipSpace();
+		if (position >= str.size() || str[position] != ':') return false;
+		position++;
+		skipSpace();
+
+		if (key == "name")
+		{
+			if (!readString(result.m_name)) return false;
+			continue;
+		}
+
+		const char* start = str.c_str() + position;
+		char* end = nullptr;
+		double value = std::strtod(start, &end);
+		if (end == start) return false;
+		position += end - start;
+
+		if (key == "uncodedSize") result.m_uncodedSize = static_cast<uint64_t>(value);
+		else if (key == "codedSize") result.m_codedSize = static_cast<uint64_t>(value);
+		else if (key == "encodeSpeed") result.m_encodeSpeed = value;
+		else if (key == "decodeSpeed") result.m_decodeSpeed = value;
+		else if (key == "peakMemory") result.m_peakMemory = static_cast<uint64_t>(value);
+	}
+}
+
+void BenchmarkBaseline::write(std::ostream& outputStream, const std::vector<CorpusResult>& results) const
+{
+	outputStream << "{\n  \"results\": [";
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const CorpusResult& result = results[i];
+
+		outputStream << (i > 0 ? ",\n" : "\n") << "    {\"name\": \"" << result.m_name << "\", \"uncodedSize\": " << result.m_uncodedSize
+			<< ", \"codedSize\": " << result.m_codedSize << ", \"encodeSpeed\": " << result.m_encodeSpeed
+			<< ", \"decodeSpeed\": " << result.m_decodeSpeed << ", \"peakMemory\": " << result.m_peakMemory << "}";
+	}
+
+	outputStream << (results.empty() ? "]\n" : "\n  ]\n") << "}\n";
+}
+
+bool BenchmarkBaseline::read(std::istream& inputStream, std::vector<CorpusResult>& results) const
+{
+	std::string str((std::istreambuf_iterator<char>(inputStream)), std::istreambuf_iterator<char>());
+	results.clear();
+
+	size_t position = str.find('[');
+	if (position == std::string::npos) return false;
+
+	//every object inside the array is one result
+	for (position = str.find_first_of("{]", position); position != std::string::npos && str[position] == '{'; position = str.find_first_of("{]", position))
+	{
+		CorpusResult result;
+		if (!parseResult(str, position, result)) return false;
+
+		results.push_back(result);
+	}
+
+	return position != std::string::npos;
+}
+
+bool BenchmarkBaseline::compare(std::ostream& outputStream, const std::vector<CorpusResult>& results, const std::vector<CorpusResult>& baseline, const RegressionThresholds& thresholds) const
+{
+	bool passed = true;
+
+	//relative change in percent, positive if the value grew
+	auto change = [](double value, double baselineValue)
+	{
+		return (baselineValue > 0.0) ? (value / baselineValue - 1.0) * 100.0 : 0.0;
+	};
+
+	for (const CorpusResult& result : results)
+	{
+		const CorpusResult* base = nullptr;
+		for (const CorpusResult& candidate : baseline)
+		{
+			if (candidate.m_name == result.m_name && candidate.m_uncodedSize == result.m_uncodedSize) base = &candidate;
+		}
+
+		if (base == nullptr)
+		{
+			outputStream << result.m_name << ": not in the baseline\n";
+			continue;
+		}
+
+		double sizeChange = change(static_cast<double>(result.m_codedSize), static_cast<double>(base->m_codedSize));
+		double encodeChange = change(result.m_encodeSpeed, base->m_encodeSpeed);
+		double decodeChange = change(result.m_decodeSpeed, base->m_decodeSpeed);
+		double memoryChange = change(static_cast<double>(result.m_peakMemory), static_cast<double>(base->m_peakMemory));
+
+		bool regressed = sizeChange > thresholds.m_ratio || -encodeChange > thresholds.m_speed
+			|| -decodeChange > thresholds.m_speed || memoryChange > thresholds.m_memory;
+
+		outputStream << result.m_name << ": codedSize " << sizeChange << "%, encodeSpeed " << encodeChange << "%, decodeSpeed " << decodeChange
+			<< "%, peakMemory " << memoryChange << "%" << (regressed ? "  REGRESSION" : "") << "\n";
+
+		passed = passed && !regressed;
+	}
+
+	return passed;
+}
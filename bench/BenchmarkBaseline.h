@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+*   result of the end-to-end benchmark of a single input of the corpus
+*/
+struct CorpusResult
+{
+	std::string m_name;         //!< name of the input
+	uint64_t m_uncodedSize = 0; //!< size of the input in bytes
+	uint64_t m_codedSize = 0;   //!< size of the encoded input in bytes
+	double m_encodeSpeed = 0.0; //!< median encoding throughput in MB/s of uncoded data
+	double m_decodeSpeed = 0.0; //!< median decoding throughput in MB/s of uncoded data
+	uint64_t m_peakMemory = 0;  //!< highest number of bytes allocated at once while encoding or decoding
+};
+
+/**
+*   allowed worsening of the results against the baseline, in percent
+*/
+struct RegressionThresholds
+{
+	double m_speed = 25.0;  //!< maximum drop of the encoding or decoding throughput
+	double m_ratio = 1.0;   //!< maximum growth of the encoded size
+	double m_memory = 25.0; //!< maximum growth of the peak memory
+};
+
+/**
+*   Saves the results of the corpus benchmark as JSON and compares them with the results of an earlier run
+*/
+class BenchmarkBaseline
+{
+private:
+
+	/**
+	*   \brief Parses a flat JSON object with string and number values
+	*   \param str JSON text
+	*   \param position position of the opening brace, moved after the closing brace
+	*   \param result values with known keys get saved here
+	*   \return true on success, false if the object isn't valid
+	*/
+	static bool parseResult(const std::string& str, size_t& position, CorpusResult& result);
+
+public:
+
+	/**
+	*   \brief Writes the results as JSON
+	*   \param outputStream output stream
+	*   \param results results of all inputs of the corpus
+	*/
+	void write(std::ostream& outputStream, const std::vector<CorpusResult>& results) const;
+
+	/**
+	*   \brief Reads results written by write
+	*   \param inputStream input stream
+	*   \param results read results get saved here
+	*   \return true on success, false if the input isn't valid
+	*/
+	bool read(std::istream& inputStream, std::vector<CorpusResult>& results) const;
+
+	/**
+	*   \brief Compares the results with the baseline and prints the differences
+	*   Inputs which aren't in the baseline or have a different size there aren't compared
+	*   \param outputStream the comparison of every input is printed here
+	*   \param results results of the current run
+	*   \param baseline results of the earlier run
+	*   \param thresholds allowed worsening of the results
+	*   \return true if no result got worse by more than the thresholds, false otherwise
+	*/
+	bool compare(std::ostream& outputStream, const std::vector<CorpusResult>& results, const std::vector<CorpusResult>& baseline, const RegressionThresholds& thresholds) const;
+};
@@ -0,0 +1,107 @@
+#include "BenchmarkInputs.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+BenchmarkInputs::BenchmarkInputs(const std::string& textFile)
+	: m_textFile(textFile)
+{
+}
+
+std::vector<std::string> BenchmarkInputs::getNames()
+{
+	return { "zeros", "runs", "periodic", "random", "text", "dna", "records" };
+}
+
+bool BenchmarkInputs::generate(const std::string& name, uint64_t size, std::string& input) const
+{
+	std::mt19937_64 random(size);
+	input.clear();
+	input.reserve(size);
+
+	if (name == "zeros")
+	{
+		//a single repeated byte, the worst case for sorters which compare permutations character by character
+		input.assign(size, '\0');
+	}
+	else if (name == "runs")
+	{
+		//runs of a single byte with random lengths
+		while (input.size() < size)
+		{
+			uint64_t length = std::min<uint64_t>(1 + random() % 1000, size - input.size());
+			input.append(length, static_cast<char>(random() & 0xFF));
+		}
+	}
+	else if (name == "periodic")
+	{
+		//a random string repeated, every permutation shares a prefix of almost the whole block with others
+		std::string period;
+		for (int i = 0; i < 1000; ++i)
+		{
+			period.push_back(static_cast<char>(random() & 0xFF));
+		}
+
+		while (input.size() < size)
+		{
+			input.append(period, 0, size - input.size());
+		}
+	}
+	else if (name == "text")
+	{
+		//English text, repeated if the file is shorter than the input
+		std::ifstream file(m_textFile, std::ifstream::in | std::ifstream::binary);
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (text.empty()) return false;
+
+		while (input.size() < size)
+		{
+			input.append(text, 0, size - input.size());
+		}
+	}
+	else if (name == "dna")
+	{
+		//four symbols without any structure, the sorters compare long common prefixes
+		const char symbols[] = { 'A', 'C', 'G', 'T' };
+		while (input.size() < size)
+		{
+			input.push_back(symbols[random() % 4]);
+		}
+	}
+	else if (name == "random")
+	{
+		//uniformly distributed bytes, incompressible
+		while (input.size() < size)
+		{
+			input.push_back(static_cast<char>(random() & 0xFF));
+		}
+	}
+	else if (name == "records")
+	{
+		//fixed-size binary records as written by a logging application: sequence number, timestamp, small values and a tag
+		const char* tags[] = { "INFO", "WARN", "DEBUG", "ERROR" };
+		uint64_t timestamp = 1500000000000;
+
+		for (uint32_t sequence = 0; input.size() < size; ++sequence)
+		{
+			std::string record(32, '\0');
+			timestamp += random() % 100;
+
+			for (int i = 0; i < 4; ++i) record[i] = static_cast<char>(sequence >> (8 * i));
+			for (int i = 0; i < 8; ++i) record[4 + i] = static_cast<char>(timestamp >> (8 * i));
+			record[12] = static_cast<char>(random() % 16);
+			record[13] = static_cast<char>(random() % 3);
+			record.replace(16, 5, tags[random() % 4]);
+
+			input.append(record, 0, size - input.size());
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+*   Generates the inputs of the benchmarks
+*
+*   Every input is generated deterministically from a fixed seed, so that runs on different machines measure the same data.
+*/
+class BenchmarkInputs
+{
+private:
+
+	std::string m_textFile; //!< file with the text input, repeated to the requested size
+
+public:
+
+	/**
+	*   \brief Creates the generator
+	*   \param textFile file with the text input, testFiles/test.txt of the repository
+	*/
+	explicit BenchmarkInputs(const std::string& textFile);
+
+	/**
+	*   \brief Returns the names of all inputs which can be generated
+	*   \return names of the inputs
+	*/
+	static std::vector<std::string> getNames();
+
+	/**
+	*   \brief Generates an input
+	*   \param name name of the input, one of getNames()
+	*   \param size number of bytes of the input
+	*   \param input generated input gets saved here
+	*   \return true on success, false if the name is unknown or the text file couldn't be read
+	*/
+	bool generate(const std::string& name, uint64_t size, std::string& input) const;
+};
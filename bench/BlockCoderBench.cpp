@@ -0,0 +1,241 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkInputs.h"
+
+#include "../src/BWTCoder.h"
+#include "../src/HuffmanCoder.h"
+#include "../src/MTFCoder.h"
+#include "../src/RLE0Coder.h"
+
+/**
+*   sorter of BWTCoder with its name in the output
+*/
+struct SorterEntry
+{
+	const char* m_name;        //!< name used in the output and on the command line
+	BWTCoder::Sorter m_sorter; //!< the sorter
+};
+
+const SorterEntry SORTERS[] =
+{
+	{ "prefix-doubling", BWTCoder::Sorter::PREFIX_DOUBLING },
+	{ "merge-sort", BWTCoder::Sorter::MERGE_SORT },
+	{ "std-sort", BWTCoder::Sorter::STD_SORT },
+	{ "induced-sorting", BWTCoder::Sorter::INDUCED_SORTING }
+};
+
+volatile uint64_t sink = 0; //results of the measured operations are added here, so that they can't be optimized away
+
+/**
+*   \brief Splits a comma separated list
+*   \param str list to split
+*   \return items of the list
+*/
+std::vector<std::string> splitList(const std::string& str)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(str);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty()) items.push_back(item);
+	}
+
+	return items;
+}
+
+/**
+*   \brief Measures an operation and prints one line of results
+*   \param benchmark benchmark with the number of warmup runs and repetitions
+*   \param input name of the input
+*   \param size size of the block in bytes, the throughput is computed from it
+*   \param coder name of the coder
+*   \param operation name of the operation
+*   \param function measured operation, returns its output
+*   \param counters whether the values of the hardware counters per byte are printed
+*/
+template <typename Function>
+void report(const Benchmark& benchmark, const std::string& input, uint64_t size, const std::string& coder, const std::string& operation, Function function, bool counters)
+{
+	BenchmarkResult result = benchmark.measure([&function]()
+	{
+		sink = sink + function().size();
+	});
+
+	std::cout << std::left << std::setw(8) << input << std::right << std::setw(10) << size << "  " << std::left << std::setw(22) << coder
+		<< std::setw(8) << operation << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(10) << Benchmark::getThroughput(size, result.m_medianTime)
+		<< std::setw(10) << Benchmark::getTimePerByte(size, result.m_medianTime)
+		<< std::setw(10) << Benchmark::getThroughput(size, result.m_minTime);
+
+	if (counters)
+	{
+		for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+		{
+			if (result.m_counters.m_valid[counter])
+			{
+				std::cout << std::setprecision(3) << std::setw(14) << result.m_counters.m_values[counter] / size;
+			}
+			else
+			{
+				std::cout << std::setw(14) << "n/a";
+			}
+		}
+	}
+
+	std::cout << "\n";
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string textFile = BWTED_TEST_FILE;
+	std::vector<std::string> inputs = { "text", "dna", "random" }; //the comparison sorters are quadratic on the repetitive inputs
+	std::vector<std::string> sizes = { "65536", "262144", "1048576" };
+	std::vector<std::string> sorters;
+	bool counters = false; //read the hardware counters
+	Benchmark benchmark;
+
+	for (const SorterEntry& entry : SORTERS)
+	{
+		sorters.push_back(entry.m_name);
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-i" && i < argc - 1)
+		{
+			textFile = argv[++i];
+		}
+		else if (arg == "--inputs" && i < argc - 1)
+		{
+			inputs = splitList(argv[++i]);
+		}
+		else if (arg == "--sizes" && i < argc - 1)
+		{
+			sizes = splitList(argv[++i]);
+		}
+		else if (arg == "--sorters" && i < argc - 1)
+		{
+			sorters = splitList(argv[++i]);
+		}
+		else if (arg == "--warmup" && i < argc - 1)
+		{
+			benchmark.setWarmupCount(std::atoi(argv[++i]));
+		}
+		else if (arg == "--repetitions" && i < argc - 1)
+		{
+			benchmark.setRepetitionCount(std::atoi(argv[++i]));
+		}
+		else if (arg == "--counters")
+		{
+			counters = true;
+		}
+		else
+		{
+			std::cout << "bwted_bench [-i <textFile>] [--inputs <list>] [--sizes <list>] [--sorters <list>] [--warmup <count>] [--repetitions <count>] [--counters]\n";
+			std::cout << "-i <textFile>: file used for the text input, repeated to the block size. Default: " << BWTED_TEST_FILE << "\n";
+			std::cout << "--inputs <list>: comma separated inputs, any of zeros, runs, periodic, random, text, dna, records. Default: text,dna,random.\n";
+			std::cout << "--sizes <list>: comma separated block sizes in bytes. Default: 65536,262144,1048576.\n";
+			std::cout << "--sorters <list>: comma separated BWT sorters, any of prefix-doubling, merge-sort, std-sort, induced-sorting. Default: all.\n";
+			std::cout << "--warmup <count>: number of runs before the measured ones. Default: 1.\n";
+			std::cout << "--repetitions <count>: number of measured runs, the median is reported. Default: 5.\n";
+			std::cout << "--counters: also report cycles, instructions, branch misses and last level cache misses per byte, averaged over the runs.\n";
+			return (arg == "-h") ? 0 : -1;
+		}
+	}
+
+	BenchmarkInputs generator(textFile);
+	BWTCoder BWT;
+	MTFCoder MTF;
+	RLE0Coder RLE0;
+	HuffmanCoder huffman;
+
+	//the benchmark still runs without counters, e.g. in containers or with a restrictive perf_event_paranoid
+	PerfCounters perfCounters;
+	if (counters && !perfCounters.isAvailable())
+	{
+		std::cout << "Hardware counters aren't available, they won't be reported.\n";
+		counters = false;
+	}
+	if (counters) benchmark.setCounters(&perfCounters);
+
+	//every stage is measured on the output of the previous one, as in the encoder, throughput is relative to the block size
+	std::cout << "input         size  coder                 op          MB/s   ns/byte  best MB/s";
+	if (counters)
+	{
+		for (const char* name : COUNTER_NAMES)
+		{
+			std::cout << std::setw(14) << (std::string(name) + "/B");
+		}
+	}
+	std::cout << "\n";
+
+	for (const std::string& input : inputs)
+	{
+		for (const std::string& sizeStr : sizes)
+		{
+			uint64_t size = std::strtoull(sizeStr.c_str(), nullptr, 10);
+			std::string block;
+
+			if (size == 0 || !generator.generate(input, size, block))
+			{
+				std::cout << "The input \"" << input << "\" of size \"" << sizeStr << "\" couldn't be generated!\n";
+				return -1;
+			}
+
+			for (const std::string& sorterName : sorters)
+			{
+				const SorterEntry* entry = nullptr;
+				for (const SorterEntry& sorter : SORTERS)
+				{
+					if (sorterName == sorter.m_name) entry = &sorter;
+				}
+
+				if (entry == nullptr)
+				{
+					std::cout << "Unknown sorter \"" << sorterName << "\"!\n";
+					return -1;
+				}
+
+				BWTCoder sorterBWT;
+				sorterBWT.setSorter(entry->m_sorter);
+				report(benchmark, input, size, std::string("BWT[") + entry->m_name + "]", "encode", [&]() { return sorterBWT.encode(block); }, counters);
+			}
+
+			std::string bwt = BWT.encode(block);
+			report(benchmark, input, size, "BWT", "decode", [&]() { return BWT.decode(bwt); }, counters);
+
+			std::string mtf = MTF.encode(bwt);
+			report(benchmark, input, size, "MTF", "encode", [&]() { return MTF.encode(bwt); }, counters);
+			report(benchmark, input, size, "MTF", "decode", [&]() { return MTF.decode(mtf); }, counters);
+
+			std::string rle = RLE0.encode(mtf);
+			report(benchmark, input, size, "RLE0", "encode", [&]() { return RLE0.encode(mtf); }, counters);
+			report(benchmark, input, size, "RLE0", "decode", [&]() { return RLE0.decode(rle); }, counters);
+
+			std::string coded = huffman.encode(rle);
+			report(benchmark, input, size, "Huffman", "encode", [&]() { return huffman.encode(rle); }, counters);
+			report(benchmark, input, size, "Huffman", "decode", [&]() { return huffman.decode(coded); }, counters);
+
+			//a benchmark of a broken coder is worthless
+			if (BWT.decode(MTF.decode(RLE0.decode(huffman.decode(coded)))) != block)
+			{
+				std::cout << "The round trip of the input \"" << input << "\" of size " << size << " failed!\n";
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,267 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkBaseline.h"
+#include "BenchmarkInputs.h"
+#include "Watchdog.h"
+
+#include "../src/BWT_MTF_RLE_Huffman_Coder.h"
+#include "../src/MemoryUsage.h"
+
+/**
+*   \brief Splits a comma separated list
+*   \param str list to split
+*   \return items of the list
+*/
+std::vector<std::string> splitList(const std::string& str)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(str);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty()) items.push_back(item);
+	}
+
+	return items;
+}
+
+/**
+*   \brief Checks that a stream followed by another one and a stream extended by append decode to the input twice
+*   \param coder configured coder
+*   \param input the input
+*   \param coded the input encoded by the coder
+*   \return true if both streams decode correctly, false otherwise
+*/
+bool checkConcatenation(const BWT_MTF_RLE_Huffman_Coder& coder, const std::string& input, const std::string& coded)
+{
+	Log log;
+	std::istringstream concatenatedStream(coded + coded);
+	std::ostringstream concatenatedOutput;
+	if (!coder.decode(log, concatenatedStream, concatenatedOutput) || concatenatedOutput.str() != input + input) return false;
+
+	std::istringstream inputStream(input);
+	std::stringstream appendedStream(coded);
+	std::ostringstream appendedOutput;
+	if (!coder.append(log, inputStream, appendedStream)) return false;
+
+	appendedStream.seekg(0);
+	return coder.decode(log, appendedStream, appendedOutput) && appendedOutput.str() == input + input;
+}
+
+/**
+*   \brief Encodes and decodes a single input of the corpus
+*   \param benchmark benchmark with the number of warmup runs and repetitions
+*   \param coder configured coder
+*   \param name name of the input
+*   \param input the input
+*   \param result sizes, throughput and peak memory get saved here
+*   \return true on success, false if the input didn't survive the round trip, also after concatenating or appending streams
+*/
+bool runCase(const Benchmark& benchmark, const BWT_MTF_RLE_Huffman_Coder& coder, const std::string& name, const std::string& input, CorpusResult& result)
+{
+	std::string coded;
+	std::string decoded;
+	bool success = true;
+
+	//the input and the results are already allocated, only the memory used by the coder is counted
+	uint64_t memoryBefore = MemoryUsage::getCurrent();
+	MemoryUsage::resetPeak();
+
+	BenchmarkResult encodeResult = benchmark.measure([&]()
+	{
+		Log log;
+		std::istringstream inputStream(input);
+		std::ostringstream outputStream;
+
+		success = coder.encode(log, inputStream, outputStream) && success;
+		coded = outputStream.str();
+	});
+
+	BenchmarkResult decodeResult = benchmark.measure([&]()
+	{
+		Log log;
+		std::istringstream inputStream(coded);
+		std::ostringstream outputStream;
+
+		success = coder.decode(log, inputStream, outputStream) && success;
+		decoded = outputStream.str();
+	});
+
+	result.m_name = name;
+	result.m_uncodedSize = input.size();
+	result.m_codedSize = coded.size();
+	result.m_encodeSpeed = Benchmark::getThroughput(input.size(), encodeResult.m_medianTime);
+	result.m_decodeSpeed = Benchmark::getThroughput(input.size(), decodeResult.m_medianTime);
+	result.m_peakMemory = MemoryUsage::getPeak() - std::min(memoryBefore, MemoryUsage::getPeak());
+
+	return success && decoded == input && checkConcatenation(coder, input, coded);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string textFile = BWTED_TEST_FILE;
+	std::vector<std::string> inputs = BenchmarkInputs::getNames();
+	uint64_t size = 1 << 20;          //size of every input in bytes
+	int level = BWT_MTF_RLE_Huffman_Coder::DEFAULT_LEVEL;
+	unsigned threadCount = 1;         //a single thread gives stable numbers
+	double timeout = 60.0;            //time limit of a single input in seconds
+	std::string saveFile;             //file the results are saved to
+	std::string baselineFile;         //file with the results of an earlier run
+	RegressionThresholds thresholds;
+	Benchmark benchmark;
+	benchmark.setRepetitionCount(3);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-i" && i < argc - 1)
+		{
+			textFile = argv[++i];
+		}
+		else if (arg == "--inputs" && i < argc - 1)
+		{
+			inputs = splitList(argv[++i]);
+		}
+		else if (arg == "--size" && i < argc - 1)
+		{
+			size = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg.size() == 2 && arg[0] == '-' && arg[1] >= '1' && arg[1] <= '9')
+		{
+			level = arg[1] - '0';
+		}
+		else if (arg == "--threads" && i < argc - 1)
+		{
+			threadCount = std::atoi(argv[++i]);
+		}
+		else if (arg == "--warmup" && i < argc - 1)
+		{
+			benchmark.setWarmupCount(std::atoi(argv[++i]));
+		}
+		else if (arg == "--repetitions" && i < argc - 1)
+		{
+			benchmark.setRepetitionCount(std::atoi(argv[++i]));
+		}
+		else if (arg == "--timeout" && i < argc - 1)
+		{
+			timeout = std::atof(argv[++i]);
+		}
+		else if (arg == "--save" && i < argc - 1)
+		{
+			saveFile = argv[++i];
+		}
+		else if (arg == "--baseline" && i < argc - 1)
+		{
+			baselineFile = argv[++i];
+		}
+		else if (arg == "--max-slowdown" && i < argc - 1)
+		{
+			thresholds.m_speed = std::atof(argv[++i]);
+		}
+		else if (arg == "--max-ratio-loss" && i < argc - 1)
+		{
+			thresholds.m_ratio = std::atof(argv[++i]);
+		}
+		else if (arg == "--max-memory-growth" && i < argc - 1)
+		{
+			thresholds.m_memory = std::atof(argv[++i]);
+		}
+		else
+		{
+			std::cout << "bwted_corpus [-i <textFile>] [--inputs <list>] [--size <bytes>] [-1 ... -9] [--threads <count>] [--warmup <count>] [--repetitions <count>] [--timeout <seconds>] [--save <file>] [--baseline <file>] [--max-slowdown <percent>] [--max-ratio-loss <percent>] [--max-memory-growth <percent>]\n";
+			std::cout << "-i <textFile>: file used for the text input, repeated to the input size. Default: " << BWTED_TEST_FILE << "\n";
+			std::cout << "--inputs <list>: comma separated inputs, any of zeros, runs, periodic, random, text, dna, records. Default: all.\n";
+			std::cout << "--size <bytes>: size of every input. Default: 1048576.\n";
+			std::cout << "-1 ... -9: compression level of the coder. Default: -5.\n";
+			std::cout << "--threads <count>: number of threads of the coder. Default: 1.\n";
+			std::cout << "--warmup <count>: number of runs before the measured ones. Default: 1.\n";
+			std::cout << "--repetitions <count>: number of measured runs, the median is reported. Default: 3.\n";
+			std::cout << "--timeout <seconds>: time limit of a single input, the benchmark exits with code 2 when it is exceeded, 0 for no limit. Default: 60.\n";
+			std::cout << "--save <file>: save the results as JSON.\n";
+			std::cout << "--baseline <file>: compare the results with results saved earlier, the exit code is 1 on a regression.\n";
+			std::cout << "--max-slowdown <percent>: allowed drop of encoding or decoding throughput. Default: 25.\n";
+			std::cout << "--max-ratio-loss <percent>: allowed growth of the encoded size. Default: 1.\n";
+			std::cout << "--max-memory-growth <percent>: allowed growth of the peak memory. Default: 25.\n";
+			return (arg == "-h") ? 0 : -1;
+		}
+	}
+
+	BenchmarkInputs generator(textFile);
+	BWT_MTF_RLE_Huffman_Coder coder;
+	coder.setLevel(level);
+	coder.setThreadCount(threadCount);
+
+	std::vector<CorpusResult> results;
+
+	std::cout << "input          size  codedSize   ratio  encode MB/s  decode MB/s  peakMemory\n";
+
+	for (const std::string& name : inputs)
+	{
+		std::string input;
+		if (size == 0 || !generator.generate(name, size, input))
+		{
+			std::cout << "The input \"" << name << "\" couldn't be generated!\n";
+			return -1;
+		}
+
+		CorpusResult result;
+		{
+			Watchdog watchdog(timeout, name);
+
+			if (!runCase(benchmark, coder, name, input, result))
+			{
+				std::cout << "The round trip of the input \"" << name << "\" failed!\n";
+				return -1;
+			}
+		}
+
+		std::cout << std::left << std::setw(10) << name << std::right << std::setw(9) << result.m_uncodedSize << std::setw(11) << result.m_codedSize
+			<< std::fixed << std::setprecision(4) << std::setw(8) << static_cast<double>(result.m_codedSize) / result.m_uncodedSize
+			<< std::setprecision(2) << std::setw(13) << result.m_encodeSpeed << std::setw(13) << result.m_decodeSpeed
+			<< std::setw(12) << result.m_peakMemory << "\n";
+		std::cout.unsetf(std::ios::floatfield);
+
+		results.push_back(result);
+	}
+
+	BenchmarkBaseline baseline;
+
+	if (!saveFile.empty())
+	{
+		std::ofstream saveStream(saveFile);
+		baseline.write(saveStream, results);
+
+		if (!saveStream)
+		{
+			std::cout << "The results couldn't be saved to \"" << saveFile << "\"!\n";
+			return -1;
+		}
+	}
+
+	if (!baselineFile.empty())
+	{
+		std::ifstream baselineStream(baselineFile);
+		std::vector<CorpusResult> baselineResults;
+
+		if (!baseline.read(baselineStream, baselineResults))
+		{
+			std::cout << "The baseline \"" << baselineFile << "\" couldn't be read!\n";
+			return -1;
+		}
+
+		std::cout << "\ncomparison with " << baselineFile << ":\n";
+		if (!baseline.compare(std::cout, results, baselineResults, thresholds)) return 1;
+	}
+
+	return 0;
+}
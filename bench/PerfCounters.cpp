@@ -0,0 +1,95 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+PerfCounters::PerfCounters()
+{
+	m_descriptors.fill(-1);
+
+#if defined(__linux__)
+	const uint64_t configs[COUNTER_COUNT] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES };
+
+	for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+	{
+		perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = configs[counter];
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		//the counters aren't grouped, so that a missing one doesn't prevent the others from being used
+		m_descriptors[counter] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+	}
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+	for (int descriptor : m_descriptors)
+	{
+		if (descriptor >= 0) close(descriptor);
+	}
+#endif
+}
+
+bool PerfCounters::isAvailable() const
+{
+	for (int descriptor : m_descriptors)
+	{
+		if (descriptor >= 0) return true;
+	}
+
+	return false;
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+	for (int descriptor : m_descriptors)
+	{
+		if (descriptor < 0) continue;
+
+		ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+		ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+void PerfCounters::stop(CounterValues& values)
+{
+	values = CounterValues();
+
+#if defined(__linux__)
+	for (int descriptor : m_descriptors)
+	{
+		if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+	{
+		if (m_descriptors[counter] < 0) continue;
+
+		//value, time enabled, time running
+		uint64_t data[3] = {};
+		if (read(m_descriptors[counter], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+
+		//a counter which never got onto the CPU has no value
+		if (data[2] == 0) continue;
+
+		values.m_values[counter] = static_cast<double>(data[0]) * data[1] / data[2];
+		values.m_valid[counter] = true;
+	}
+#endif
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+*   hardware events counted around a measured operation
+*/
+enum Counter
+{
+	COUNTER_CYCLES,        //!< CPU cycles
+	COUNTER_INSTRUCTIONS,  //!< retired instructions
+	COUNTER_BRANCH_MISSES, //!< mispredicted branches
+	COUNTER_CACHE_MISSES,  //!< last level cache misses
+	COUNTER_COUNT          //!< number of counters
+};
+
+/**
+*   names of the counters in the output, COUNTER_NAMES[counter]
+*/
+inline constexpr const char* COUNTER_NAMES[COUNTER_COUNT] = { "cycles", "instructions", "branchMisses", "cacheMisses" };
+
+/**
+*   values of all counters, counters which couldn't be opened aren't valid
+*/
+struct CounterValues
+{
+	std::array<double, COUNTER_COUNT> m_values = {}; //!< number of events, m_values[counter]
+	std::array<bool, COUNTER_COUNT> m_valid = {};    //!< whether the counter could be read, m_valid[counter]
+};
+
+/**
+*   Reads the hardware performance counters of the calling thread using perf_event_open
+*
+*   Only user space events are counted, so that it works with the default perf_event_paranoid setting of most distributions.
+*   Counters which the kernel, the CPU or the virtual machine don't provide are skipped, on other systems than Linux no counter is available.
+*   If the kernel multiplexes the counters, the values are scaled to the whole time of the measurement.
+*/
+class PerfCounters
+{
+private:
+
+	std::array<int, COUNTER_COUNT> m_descriptors; //!< file descriptors of the opened counters, -1 if a counter couldn't be opened
+
+public:
+
+	/**
+	*   \brief Opens all counters for the calling thread, they are disabled until start
+	*/
+	PerfCounters();
+
+	PerfCounters(const PerfCounters& other) = delete;
+
+	PerfCounters& operator=(const PerfCounters& other) = delete;
+
+	/**
+	*   \brief Closes all counters
+	*/
+	~PerfCounters();
+
+	/**
+	*   \brief Returns whether at least one counter could be opened
+	*   \return true if any counter is available
+	*/
+	bool isAvailable() const;
+
+	/**
+	*   \brief Resets and enables all counters
+	*/
+	void start();
+
+	/**
+	*   \brief Disables all counters and reads their values
+	*   \param values values of the counters since start get saved here
+	*/
+	void stop(CounterValues& values);
+};
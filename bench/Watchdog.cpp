@@ -0,0 +1,33 @@
+#include "Watchdog.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+Watchdog::Watchdog(double seconds, const std::string& name)
+{
+	if (seconds <= 0.0) return;
+
+	m_thread = std::thread([this, seconds, name]()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (!m_condition.wait_for(lock, std::chrono::duration<double>(seconds), [this]() { return m_done; }))
+		{
+			std::cout << name << ": timed out after " << seconds << " s\n" << std::flush;
+			std::_Exit(2);
+		}
+	});
+}
+
+Watchdog::~Watchdog()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_done = true;
+	}
+
+	m_condition.notify_all();
+
+	if (m_thread.joinable()) m_thread.join();
+}
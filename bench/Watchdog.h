@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+*   Ends the process if an operation doesn't finish in time
+*
+*   A sorter which degrades to quadratic time on repetitive data could otherwise keep the benchmark running for hours
+*   instead of reporting the regression. The process exits with code 2 without unwinding, because the hung operation
+*   can't be interrupted.
+*/
+class Watchdog
+{
+private:
+
+	std::mutex m_mutex;                  //!< protects m_done
+	std::condition_variable m_condition; //!< signals the end of the operation
+	bool m_done = false;                 //!< set when the watched operation finished
+	std::thread m_thread;                //!< waits for the end of the operation or for the timeout
+
+public:
+
+	/**
+	*   \brief Starts watching an operation
+	*   \param seconds time limit of the operation, 0 for no limit
+	*   \param name name of the operation printed when it times out
+	*/
+	Watchdog(double seconds, const std::string& name);
+
+	Watchdog(const Watchdog& other) = delete;
+
+	Watchdog& operator=(const Watchdog& other) = delete;
+
+	/**
+	*   \brief Stops watching, the operation finished
+	*/
+	~Watchdog();
+};
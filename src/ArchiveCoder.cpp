@@ -0,0 +1,406 @@
+#include "ArchiveCoder.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+ArchiveCoder::ArchiveCoder(const BWT_MTF_RLE_Huffman_Coder& coder)
+	: m_coder(coder)
+{
+}
+
+bool ArchiveCoder::collectFiles(const std::string& source, std::vector<ArchiveInput>& inputs) const
+{
+	inputs.clear();
+
+	std::error_code error;
+	if (std::filesystem::is_directory(source, error))
+	{
+		std::filesystem::recursive_directory_iterator it(source, error);
+		for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+		{
+			if (!it->is_regular_file(error)) continue;
+
+			const std::string name = std::filesystem::relative(it->path(), source, error).generic_string();
+			if (error) return false;
+
+			inputs.push_back({ it->path().string(), name });
+		}
+
+		if (error) return false;
+
+		//the same directory gives the same archive, whatever order the file system lists it in
+		std::sort(inputs.begin(), inputs.end(), [](const ArchiveInput& first, const ArchiveInput& second)
+		{
+			return first.m_name < second.m_name;
+		});
+	}
+	else
+	{
+		std::ifstream listStream(source);
+		if (!listStream) return false;
+
+		std::string line;
+		while (std::getline(listStream, line))
+		{
+			//lists written on Windows end their lines with CR LF
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty()) continue;
+
+			inputs.push_back({ line, line });
+		}
+
+		if (listStream.bad()) return false;
+	}
+
+	//every file must be found by its name when extracting
+	std::set<std::string> names;
+	for (const ArchiveInput& input : inputs)
+	{
+		if (input.m_name.empty() || input.m_name.size() > MAX_NAME_SIZE) return false;
+		if (!names.insert(input.m_name).second) return false;
+	}
+
+	return true;
+}
+
+void ArchiveCoder::encodeFile(Creation& creation, size_t file) const
+{
+	const ArchiveInput& input = (*creation.m_inputs)[file];
+	ArchiveEntry& entry = creation.m_entries[file];
+	const uint64_t blockSize = creation.m_streamHeader.m_blockSize;
+
+	std::ifstream inputStream(input.m_path, std::ios::binary);
+	inputStream.seekg(0, std::ios::end);
+	const std::streampos size = inputStream.tellg();
+
+	if (!inputStream || size == std::streampos(-1))
+	{
+		std::lock_guard<std::mutex> lock(creation.m_mutex);
+		creation.m_success = false;
+		return;
+	}
+
+	entry.m_uncodedSize = static_cast<uint64_t>(size);
+	const uint64_t blockCount = (entry.m_uncodedSize + blockSize - 1) / blockSize;
+	entry.m_blocks.resize(blockCount);
+
+	//the worker takes the blocks in order from the back of its queue, idle workers steal them from the front
+	for (uint64_t block = blockCount; block-- > 1;)
+	{
+		creation.m_pool->submit([this, &creation, file, block]()
+		{
+			std::ifstream blockStream((*creation.m_inputs)[file].m_path, std::ios::binary);
+			encodeFileBlock(creation, file, block, blockStream);
+		});
+	}
+
+	if (blockCount > 0)
+	{
+		encodeFileBlock(creation, file, 0, inputStream);
+	}
+}
+
+void ArchiveCoder::encodeFileBlock(Creation& creation, size_t file, uint64_t block, std::istream& inputStream) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+	const StreamHeader& streamHeader = creation.m_streamHeader;
+	ArchiveEntry& entry = creation.m_entries[file];
+	Workspace& workspace = creation.m_workspaces[creation.m_pool->getWorkerIndex()];
+
+	const uint64_t offset = block * streamHeader.m_blockSize;
+	const uint64_t size = std::min(streamHeader.m_blockSize, entry.m_uncodedSize - offset);
+
+	inputStream.clear();
+	inputStream.seekg(offset);
+	if (!streamFormat.readBytes(inputStream, workspace.m_block, size))
+	{
+		std::lock_guard<std::mutex> lock(creation.m_mutex);
+		creation.m_success = false;
+		return;
+	}
+
+	BlockHeader blockHeader;
+	BlockLog blockLog;
+	const std::string data = m_coder.encodeBlock(streamHeader, creation.m_sorter, workspace.m_block, blockHeader, blockLog, workspace.m_blockWorkspace);
+	const std::string header = streamFormat.encodeBlockHeader(streamHeader, blockHeader);
+
+	//blocks are written as soon as they are finished, the index remembers where each of them went
+	std::lock_guard<std::mutex> lock(creation.m_mutex);
+
+	entry.m_blocks[block] = { creation.m_offset, blockHeader.m_uncodedSize, blockHeader.m_codedSize };
+
+	creation.m_outputStream->write(header.data(), header.size());
+	creation.m_outputStream->write(data.data(), data.size());
+	creation.m_offset += header.size() + data.size();
+	creation.m_log->m_blocks.push_back(blockLog);
+
+	if (!*creation.m_outputStream) creation.m_success = false;
+}
+
+std::string ArchiveCoder::encodeIndex(const std::vector<ArchiveEntry>& entries) const
+{
+	std::string index = encodeNumber(entries.size(), sizeof(uint64_t));
+
+	for (const ArchiveEntry& entry : entries)
+	{
+		index += encodeNumber(entry.m_name.size(), sizeof(uint16_t));
+		index += entry.m_name;
+		index += encodeNumber(entry.m_uncodedSize, sizeof(uint64_t));
+		index += encodeNumber(entry.m_blocks.size(), sizeof(uint64_t));
+
+		for (const BlockIndexEntry& block : entry.m_blocks)
+		{
+			index += encodeNumber(block.m_offset, sizeof(uint64_t));
+			index += encodeNumber(block.m_uncodedSize, sizeof(uint64_t));
+			index += encodeNumber(block.m_codedSize, sizeof(uint64_t));
+		}
+	}
+
+	index += encodeNumber(index.size() + INDEX_TRAILER_SIZE, sizeof(uint64_t));
+	index.append(INDEX_MAGIC, MAGIC_SIZE);
+
+	return index;
+}
+
+bool ArchiveCoder::create(Log& log, const std::vector<ArchiveInput>& inputs, std::ostream& outputStream) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	uint64_t blockSize = 0;
+	unsigned threadCount = 0;
+	BWTCoder::Sorter sorter = BWTCoder::Sorter::INDUCED_SORTING;
+	m_coder.fitEncodeBudget(blockSize, threadCount, sorter);
+
+	Creation creation;
+	creation.m_inputs = &inputs;
+	creation.m_entries.resize(inputs.size());
+	for (size_t file = 0; file < inputs.size(); ++file)
+	{
+		creation.m_entries[file].m_name = inputs[file].m_name;
+	}
+
+	creation.m_workspaces.resize(std::max(threadCount, 1u));
+	creation.m_streamHeader = m_coder.getStreamHeader(blockSize);
+	creation.m_sorter = sorter;
+
+	//every file is extracted alone, so its blocks can't refer to the blocks of other files
+	creation.m_streamHeader.m_flags &= ~StreamFormat::FLAG_DEDUP;
+
+	creation.m_outputStream = &outputStream;
+	creation.m_log = &log;
+
+	//the block size must fit into the block headers and large blocks can't have a search index
+	const uint16_t flags = creation.m_streamHeader.m_flags;
+	if (blockSize == 0 || blockSize > streamFormat.getMaxBlockSize(flags)) return false;
+	if ((flags & StreamFormat::FLAG_LARGE_BLOCKS) && (flags & StreamFormat::FLAG_SEARCH_INDEX)) return false;
+
+	//initialize the log values
+	log.m_uncodedSize = 0;
+	log.m_codedSize = 0;
+	log.m_blocks.clear();
+	log.m_blockSize = blockSize;
+	log.m_threadCount = static_cast<unsigned>(creation.m_workspaces.size());
+	log.m_memoryBudget = m_coder.getMemoryBudget();
+
+	std::string header(ARCHIVE_MAGIC, MAGIC_SIZE);
+	header += static_cast<char>(VERSION);
+	header += streamFormat.encodeStreamHeader(creation.m_streamHeader);
+	outputStream.write(header.data(), header.size());
+	creation.m_offset = header.size();
+
+	{
+		WorkStealingPool pool(log.m_threadCount);
+		creation.m_pool = &pool;
+
+		for (size_t file = 0; file < inputs.size(); ++file)
+		{
+			pool.submit([this, &creation, file]()
+			{
+				encodeFile(creation, file);
+			});
+		}
+
+		pool.wait();
+	}
+
+	if (!creation.m_success) return false;
+
+	//mark the end of blocks and write the index
+	BlockHeader endHeader;
+	endHeader.m_flags = StreamFormat::BLOCK_END;
+	std::string trailer = streamFormat.encodeBlockHeader(creation.m_streamHeader, endHeader);
+	trailer += encodeIndex(creation.m_entries);
+	outputStream.write(trailer.data(), trailer.size());
+
+	for (const ArchiveEntry& entry : creation.m_entries)
+	{
+		log.m_uncodedSize += entry.m_uncodedSize;
+	}
+
+	log.m_codedSize = creation.m_offset + trailer.size();
+
+	return static_cast<bool>(outputStream);
+}
+
+bool ArchiveCoder::isArchive(std::istream& inputStream)
+{
+	std::streambuf* buffer = inputStream.rdbuf();
+
+	//the bytes can only be put back if they were read from the buffer
+	if (std::char_traits<char>::eq_int_type(buffer->sgetc(), std::char_traits<char>::eof())) return false;
+	if (buffer->in_avail() < MAGIC_SIZE) return false;
+
+	char magic[MAGIC_SIZE];
+	buffer->sgetn(magic, MAGIC_SIZE);
+	for (int i = MAGIC_SIZE; i-- > 0;)
+	{
+		buffer->sputbackc(magic[i]);
+	}
+
+	return std::equal(magic, magic + MAGIC_SIZE, ARCHIVE_MAGIC);
+}
+
+bool ArchiveCoder::readIndex(std::istream& inputStream, StreamHeader& streamHeader, std::vector<ArchiveEntry>& entries) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	entries.clear();
+
+	//position of the archive header, all offsets in the index are relative to it
+	const std::streampos archiveStart = inputStream.tellg();
+	if (archiveStart == std::streampos(-1)) return false;
+
+	std::string header;
+	if (!streamFormat.readBytes(inputStream, header, MAGIC_SIZE + 1)) return false;
+	if (header.compare(0, MAGIC_SIZE, ARCHIVE_MAGIC, MAGIC_SIZE) != 0) return false;
+	if (static_cast<uint8_t>(header[MAGIC_SIZE]) != VERSION) return false;
+	if (!streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+
+	const uint64_t blockHeaderSize = streamFormat.getBlockHeaderSize(streamHeader);
+
+	std::string trailer;
+	if (!inputStream.seekg(-INDEX_TRAILER_SIZE, std::ios::end)) return false;
+	const uint64_t archiveSize = static_cast<uint64_t>(inputStream.tellg() - archiveStart) + INDEX_TRAILER_SIZE;
+	if (!streamFormat.readBytes(inputStream, trailer, INDEX_TRAILER_SIZE)) return false;
+	if (trailer.compare(sizeof(uint64_t), MAGIC_SIZE, INDEX_MAGIC, MAGIC_SIZE) != 0) return false;
+
+	//the index must hold at least the number of files and leave space for the headers in front of it
+	const uint64_t indexSize = decodeNumber(trailer.substr(0, sizeof(uint64_t)));
+	if (indexSize < sizeof(uint64_t) + INDEX_TRAILER_SIZE) return false;
+	if (archiveSize < ARCHIVE_HEADER_SIZE + blockHeaderSize || indexSize > archiveSize - ARCHIVE_HEADER_SIZE - blockHeaderSize) return false;
+
+	const uint64_t indexStart = archiveSize - indexSize;
+	const uint64_t blocksEnd = indexStart - blockHeaderSize; //position of the block header with the BLOCK_END flag
+
+	std::string index;
+	inputStream.clear();
+	if (!inputStream.seekg(archiveStart + std::streamoff(indexStart))) return false;
+	if (!streamFormat.readBytes(inputStream, index, indexSize - INDEX_TRAILER_SIZE)) return false;
+
+	uint64_t position = 0;
+	auto readNumber = [this, &index, &position](size_t byteCount, uint64_t& value)
+	{
+		if (index.size() - position < byteCount) return false;
+
+		value = decodeNumber(index.substr(position, byteCount));
+		position += byteCount;
+		return true;
+	};
+
+	//the counts are checked against the remaining size of the index, so that a corrupted index can't make us allocate a huge buffer
+	uint64_t fileCount = 0;
+	if (!readNumber(sizeof(uint64_t), fileCount)) return false;
+	if (fileCount > (index.size() - position) / (sizeof(uint16_t) + 2 * sizeof(uint64_t))) return false;
+
+	entries.resize(fileCount);
+	for (ArchiveEntry& entry : entries)
+	{
+		uint64_t nameSize = 0;
+		if (!readNumber(sizeof(uint16_t), nameSize)) return false;
+		if (index.size() - position < nameSize) return false;
+		entry.m_name = index.substr(position, nameSize);
+		position += nameSize;
+
+		uint64_t blockCount = 0;
+		if (!readNumber(sizeof(uint64_t), entry.m_uncodedSize)) return false;
+		if (!readNumber(sizeof(uint64_t), blockCount)) return false;
+		if (blockCount > (index.size() - position) / StreamFormat::INDEX_ENTRY_SIZE) return false;
+
+		entry.m_blocks.resize(blockCount);
+		uint64_t uncodedOffset = 0;
+
+		for (BlockIndexEntry& block : entry.m_blocks)
+		{
+			if (!readNumber(sizeof(uint64_t), block.m_offset)) return false;
+			if (!readNumber(sizeof(uint64_t), block.m_uncodedSize)) return false;
+			if (!readNumber(sizeof(uint64_t), block.m_codedSize)) return false;
+
+			//every block must lie between the stream header and the end of blocks
+			if (block.m_uncodedSize == 0 || block.m_uncodedSize > streamHeader.m_blockSize) return false;
+			if (block.m_offset < ARCHIVE_HEADER_SIZE || block.m_offset > blocksEnd) return false;
+			if (blocksEnd - block.m_offset < blockHeaderSize || block.m_codedSize > blocksEnd - block.m_offset - blockHeaderSize) return false;
+
+			block.m_uncodedOffset = uncodedOffset;
+			uncodedOffset += block.m_uncodedSize;
+		}
+
+		if (uncodedOffset != entry.m_uncodedSize) return false;
+	}
+
+	return position == index.size();
+}
+
+bool ArchiveCoder::extract(Log& log, std::istream& inputStream, const std::string& name, std::ostream& outputStream) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	StreamHeader streamHeader;           //header of all blocks of the archive
+	BlockHeader blockHeader;             //describes the current block
+	std::vector<ArchiveEntry> entries;   //index of the archive
+	std::string block;                   //encoded blocks are read here
+	std::string output;                  //decoded blocks are saved here
+	BWT_MTF_RLE_Huffman_Coder::Workspace workspace;
+
+	//initialize the log values
+	log.m_uncodedSize = 0;
+	log.m_codedSize = 0;
+	log.m_blocks.clear();
+	log.m_threadCount = 1;
+	log.m_memoryBudget = m_coder.getMemoryBudget();
+
+	const std::streampos archiveStart = inputStream.tellg();
+	if (!readIndex(inputStream, streamHeader, entries)) return false;
+	log.m_blockSize = streamHeader.m_blockSize;
+
+	auto entry = std::find_if(entries.begin(), entries.end(), [&name](const ArchiveEntry& entry)
+	{
+		return entry.m_name == name;
+	});
+
+	if (entry == entries.end()) return false;
+
+	//only the blocks of the file are read, wherever the other files put theirs
+	for (const BlockIndexEntry& indexEntry : entry->m_blocks)
+	{
+		inputStream.clear();
+		if (!inputStream.seekg(archiveStart + std::streamoff(indexEntry.m_offset))) return false;
+
+		if (!streamFormat.readBlockHeader(inputStream, streamHeader, blockHeader)) return false;
+		if (blockHeader.m_flags & StreamFormat::BLOCK_END) return false;
+		if (blockHeader.m_uncodedSize != indexEntry.m_uncodedSize || blockHeader.m_codedSize != indexEntry.m_codedSize) return false;
+		if (!streamFormat.readBytes(inputStream, block, blockHeader.m_codedSize)) return false;
+		log.m_codedSize += streamFormat.getBlockHeaderSize(streamHeader) + blockHeader.m_codedSize;
+
+		BlockLog blockLog;
+		if (!m_coder.decodeBlock(streamHeader, blockHeader, block, output, blockLog, workspace)) return false;
+		log.m_blocks.push_back(blockLog);
+
+		outputStream.write(output.data(), output.size());
+		if (!outputStream) return false;
+		log.m_uncodedSize += output.size();
+	}
+
+	return true;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BWT_MTF_RLE_Huffman_Coder.h"
+#include "WorkStealingPool.h"
+
+/**
+*   Encoder of many files into a single archive, from which every file can be extracted alone
+*
+*   The files are split into blocks which are encoded by a work-stealing pool: the task of a file queues the blocks
+*   of the file at its worker and encodes the first one itself, other workers steal the remaining blocks of large files.
+*   So a few large files don't leave threads idle and many small files don't pay for a process or a stream each.
+*   The blocks are written in the order they are finished, the index at the end tells which blocks belong to which file.
+*
+*   archive: magic "BWTA", version (1 byte)
+*            stream header of BWT_MTF_RLE_Huffman_Coder, valid for all blocks
+*            blocks of all files, each with its block header like in a stream, in any order
+*            block header with the BLOCK_END flag
+*   index:   number of files (8 bytes), for every file the size of its name (2 bytes), its name, its uncoded size (8 bytes),
+*            its number of blocks (8 bytes) and for every block of it in the order of the file its offset from the beginning
+*            of the archive, uncoded size and coded size (8 bytes each),
+*            size of the whole index (8 bytes), magic "BWTX"
+*   All numbers are stored in big-endian order.
+*/
+class ArchiveCoder : public Coder
+{
+public:
+
+	static constexpr char ARCHIVE_MAGIC[] = "BWTA"; //!< first bytes of every archive
+	static constexpr char INDEX_MAGIC[] = "BWTX";   //!< last bytes of every archive
+	static constexpr int MAGIC_SIZE = 4;            //!< size of both magic values in bytes
+	static constexpr uint8_t VERSION = 1;           //!< version of the format written by this implementation
+
+	static constexpr int ARCHIVE_HEADER_SIZE = MAGIC_SIZE + 1 + StreamFormat::STREAM_HEADER_SIZE; //!< size of the magic, version and stream header in bytes
+	static constexpr int INDEX_TRAILER_SIZE = sizeof(uint64_t) + MAGIC_SIZE;                       //!< size of the index size and the index magic in bytes
+	static constexpr size_t MAX_NAME_SIZE = UINT16_MAX;                                            //!< maximum size of the name of a file in bytes
+
+	/**
+	*   file to put into an archive
+	*/
+	struct ArchiveInput
+	{
+		std::string m_path; //!< path the file is read from
+		std::string m_name; //!< name stored in the archive
+	};
+
+	/**
+	*   file stored in an archive
+	*/
+	struct ArchiveEntry
+	{
+		std::string m_name;                   //!< name of the file
+		uint64_t m_uncodedSize = 0;           //!< size of the file in bytes
+		std::vector<BlockIndexEntry> m_blocks; //!< blocks of the file in order, offsets from the beginning of the archive
+	};
+
+private:
+
+	/**
+	*   memory kept by a worker between the blocks it encodes
+	*/
+	struct Workspace
+	{
+		BWT_MTF_RLE_Huffman_Coder::Workspace m_blockWorkspace; //!< workspace of the stages
+		std::string m_block;                                   //!< uncoded block read from a file
+	};
+
+	/**
+	*   state of the creation of an archive shared by all tasks
+	*/
+	struct Creation
+	{
+		const std::vector<ArchiveInput>* m_inputs = nullptr;           //!< files to archive
+		std::vector<ArchiveEntry> m_entries;                           //!< index of the archive, m_entries[i] for (*m_inputs)[i]
+		std::vector<Workspace> m_workspaces;                           //!< workspace of every worker
+		StreamHeader m_streamHeader;                                   //!< header of the blocks
+		BWTCoder::Sorter m_sorter = BWTCoder::Sorter::INDUCED_SORTING; //!< sorter of the BWT stage which fits into the memory budget
+		WorkStealingPool* m_pool = nullptr;                            //!< pool which executes the tasks
+		std::ostream* m_outputStream = nullptr;                        //!< output stream of the archive
+		std::mutex m_mutex;                                            //!< protects the output stream and everything below
+		uint64_t m_offset = 0;                                         //!< number of bytes written to the output stream
+		Log* m_log = nullptr;                                          //!< log of the creation, the blocks in the order they were written
+		bool m_success = true;                                         //!< false once a file couldn't be read or the archive couldn't be written
+	};
+
+	const BWT_MTF_RLE_Huffman_Coder& m_coder; //!< coder which encodes and decodes the blocks
+
+	/**
+	*   \brief Queues the blocks of a file at the calling worker and encodes its first block
+	*   \param creation state of the creation
+	*   \param file index of the file
+	*/
+	void encodeFile(Creation& creation, size_t file) const;
+
+	/**
+	*   \brief Reads and encodes a block of a file and writes it to the archive
+	*   \param creation state of the creation
+	*   \param file index of the file
+	*   \param block index of the block in the file
+	*   \param inputStream opened file
+	*/
+	void encodeFileBlock(Creation& creation, size_t file, uint64_t block, std::istream& inputStream) const;
+
+	/**
+	*   \brief Encodes the index
+	*   \param entries files in the archive
+	*   \return encoded index including its size and magic
+	*/
+	std::string encodeIndex(const std::vector<ArchiveEntry>& entries) const;
+
+public:
+
+	/**
+	*   \brief Constructor
+	*   \param coder coder which encodes and decodes the blocks, its parameters are used for all files
+	*/
+	explicit ArchiveCoder(const BWT_MTF_RLE_Huffman_Coder& coder);
+
+	/**
+	*   \brief Collects the files to archive
+	*   \param source directory, whose regular files are archived with their paths relative to it,
+	*                 or a text file with the path of a file to archive on every line, which is also its name in the archive
+	*   \param inputs files to archive get saved here, the files of a directory sorted by their names
+	*   \return true on success, false if the source can't be read or a name is too long
+	*/
+	bool collectFiles(const std::string& source, std::vector<ArchiveInput>& inputs) const;
+
+	/**
+	*   \brief Encodes files into an archive
+	*   \param log log of the encoding, with the blocks in the order of the archive
+	*   \param inputs files to archive
+	*   \param outputStream output stream
+	*   \return true on success, false on error
+	*/
+	bool create(Log& log, const std::vector<ArchiveInput>& inputs, std::ostream& outputStream) const;
+
+	/**
+	*   \brief Checks whether the input starts with the magic of an archive, the input stays at its position
+	*   The magic is only compared if it is in the buffer of the input after its first read, so the input doesn't need to be seekable
+	*   \param inputStream input stream positioned at the beginning of the data
+	*   \return true if the input is an archive, false otherwise or if its first read gave fewer bytes than the magic
+	*/
+	static bool isArchive(std::istream& inputStream);
+
+	/**
+	*   \brief Reads the headers and the index of an archive
+	*   \param inputStream seekable stream positioned at the beginning of the archive
+	*   \param streamHeader header of the blocks gets saved here
+	*   \param entries files in the archive get saved here, in the order they were archived
+	*   \return true on success, false if the input isn't a valid archive or isn't seekable
+	*/
+	bool readIndex(std::istream& inputStream, StreamHeader& streamHeader, std::vector<ArchiveEntry>& entries) const;
+
+	/**
+	*   \brief Decodes a single file of an archive, only its own blocks are read
+	*   \param log log of the decoding
+	*   \param inputStream seekable stream positioned at the beginning of the archive
+	*   \param name name of the file in the archive
+	*   \param outputStream output stream
+	*   \return true on success, false if the file isn't in the archive or on error
+	*/
+	bool extract(Log& log, std::istream& inputStream, const std::string& name, std::ostream& outputStream) const;
+};
@@ -1,174 +1,615 @@
 #include "BWTCoder.h"
 
 #include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
 #include <vector>
 
-template<typename RandomAccessIterator>
-void BWTCoder::sortRange(RandomAccessIterator first, RandomAccessIterator last, std::vector<uint32_t>::iterator tFirst, std::vector<uint32_t>::iterator tLast) const
+namespace
 {
-	if (first < last - 1) //if the given range contains at least 2 elements
+	/**
+	*   text stored in an array, the reduced texts of induced sorting are kept in the suffix array this way
+	*/
+	template<typename Storage>
+	struct StoredText
 	{
-		auto elementCount = last - first;
+		const Storage* m_characters; //!< characters of the text
 
-		//element which follows after the last element of the first half of the range
-		RandomAccessIterator midLast = first + (elementCount / 2);
-		std::vector<uint32_t>::iterator tMidLast = tFirst + (elementCount / 2);
+		int64_t operator()(int64_t i) const
+		{
+			return m_characters[i];
+		}
+	};
+
+	/**
+	*   permutation of a string followed by a sentinel, the characters are shifted by one so that only the sentinel is 0
+	*/
+	struct RotatedText
+	{
+		const unsigned char* m_characters; //!< characters of the string
+		int64_t m_size;                    //!< length of the string
+		int64_t m_start;                   //!< index of the first character of the permutation in the string
+		int64_t m_length;                  //!< number of characters taken from the permutation, the sentinel follows them
+
+		int64_t operator()(int64_t i) const
+		{
+			if (i == m_length) return 0;
+
+			int64_t position = m_start + i;
+			return m_characters[position < m_size ? position : position - m_size] + 1;
+		}
+	};
+}
+
+template<typename Compare>
+void BWTCoder::insertionSort(std::vector<uint32_t>::iterator first, std::vector<uint32_t>::iterator last, Compare less) const
+{
+	if (first == last) return;
 
-		//first element of the second half of the range
-		RandomAccessIterator midFirst = midLast;
-		std::vector<uint32_t>::iterator tMidFirst = tMidLast;
+	//for all elements after the first one
+	for (std::vector<uint32_t>::iterator it = first + 1; it < last; ++it)
+	{
+		uint32_t value = *it; //element which will be inserted into the already sorted part of the range
+		std::vector<uint32_t>::iterator hole = it;
 
-		sortRange(first, midLast, tFirst, tMidLast); //recursively sort the first half of the range
-		sortRange(midFirst, last, tMidFirst, tLast); //recursively sort the second half of the range
+		//shift greater elements one position to the right, equal elements stay in front of the inserted one
+		while (hole > first && less(value, *(hole - 1)))
+		{
+			*hole = *(hole - 1);
+			hole--;
+		}
 
-		//sort the entire range knowing that both of it's halves are already sorted
+		*hole = value;
+	}
+}
 
-		using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type; //data type of the sorted values
+template<typename Compare>
+void BWTCoder::mergeSort(std::vector<uint32_t>& t, Compare less) const
+{
+	const size_t elementCount = t.size();
 
-		//allocate temporary vectors for the sorted values
-		std::vector<value_type> sorted(elementCount);
-		std::vector<uint32_t> tSorted(elementCount);
+	//sort short runs of elements by Insertion Sort
+	for (size_t runFirst = 0; runFirst < elementCount; runFirst += INSERTION_SORT_THRESHOLD)
+	{
+		size_t runLast = std::min(runFirst + INSERTION_SORT_THRESHOLD, elementCount);
+		insertionSort(t.begin() + runFirst, t.begin() + runLast, less);
+	}
 
-		//iterators which assign values to the sorted vectors
-		typename std::vector<value_type>::iterator sortedIt = sorted.begin();
-		std::vector<uint32_t>::iterator sortedTIt = tSorted.begin();
+	if (elementCount <= INSERTION_SORT_THRESHOLD) return;
 
-		RandomAccessIterator it1 = first;    //iterates over the first half of the range
-		RandomAccessIterator it2 = midFirst; //iterates over the second half of the range
+	//the only temporary memory, sorted runs are merged from one buffer to the other in every pass
+	std::vector<uint32_t> scratch(elementCount);
 
-		bool done = false; //will be set to true when the entire range is sorted
+	uint32_t* source = t.data();            //runs of the current width are read from here
+	uint32_t* destination = scratch.data(); //merged runs of double the width are written here
 
-		while (!done) //while the entire range isn't sorted
+	for (size_t width = INSERTION_SORT_THRESHOLD; width < elementCount; width *= 2)
+	{
+		//merge all pairs of neighbouring runs
+		for (size_t first = 0; first < elementCount; first += 2 * width)
 		{
-			//if the current value in the first half of the range is lesser or equal than the current value in the second half of the range
-			if (*it1 <= *it2)
-			{
-				//assign it to the current position in the sorted vectors
-				*sortedIt = *it1;
-				*sortedTIt = *(tFirst + (it1 - first));
+			size_t mid = std::min(first + width, elementCount);      //first element of the second run
+			size_t last = std::min(first + 2 * width, elementCount); //element after the last element of the second run
 
-				//move to the next position in sorted vectors
-				sortedIt++;
-				sortedTIt++;
+			uint32_t* it1 = source + first; //iterates over the first run
+			uint32_t* it2 = source + mid;   //iterates over the second run
+			uint32_t* out = destination + first;
 
-				if (it1 < midLast - 1) //we are not at the end of the first half of the range yet
+			while (it1 < source + mid && it2 < source + last)
+			{
+				//take the element from the second run only if it is strictly lesser, so that the sort stays stable
+				if (less(*it2, *it1))
 				{
-					it1++; //move to the next position in the first half of the range
+					*out++ = *it2++;
 				}
-				else //we are at the end of the first half of the range
+				else
 				{
-					//add the remainder of the second half of the range to the end of the sorted vectors
-					while (it2 < last)
-					{
-						//assign the current value from the second half of the range to the current position in the sorted vectors
-						*sortedIt = *it2;
-						*sortedTIt = *(tFirst + (it2 - first));
+					*out++ = *it1++;
+				}
+			}
 
-						//move to the next position in sorted vectors
-						sortedIt++;
-						sortedTIt++;
+			//add the remainder of the run which wasn't exhausted
+			out = std::copy(it1, source + mid, out);
+			std::copy(it2, source + last, out);
+		}
 
-						it2++; //move to the next position in the second half of the range
-					}
+		std::swap(source, destination);
+	}
 
-					done = true; //the entire range is sorted
-				}
+	//the last pass may have ended in the scratch buffer, take it over instead of copying it back
+	if (source != t.data())
+	{
+		t.swap(scratch);
+	}
+}
+
+std::vector<uint32_t> BWTCoder::sortPermutations(const std::string& str, Sorter sorter) const
+{
+	//each element of the result will have the value of the index of the first character of a permutation
+	std::vector<uint32_t> t(str.size());
+	for (uint32_t i = 0; i < t.size(); ++i)
+	{
+		t[i] = i;
+	}
+
+	//lexicographical comparison of the permutations which start at the given indices
+	auto less = [&str](uint32_t index1, uint32_t index2)
+	{
+		return StringPermutation(str, index1) < StringPermutation(str, index2);
+	};
+
+	//sort permutations
+	switch (sorter)
+	{
+	case Sorter::STD_SORT:
+		std::stable_sort(t.begin(), t.end(), less);
+		break;
+	case Sorter::MERGE_SORT:
+	default:
+		mergeSort(t, less);
+		break;
+	}
+
+	return t;
+}
+
+BWTCoder::Int40::Int40(int64_t value)
+{
+	*this = value;
+}
+
+BWTCoder::Int40& BWTCoder::Int40::operator=(int64_t value)
+{
+	for (int i = 0; i < BYTE_COUNT; ++i)
+	{
+		m_bytes[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * CHAR_BIT));
+	}
+
+	return *this;
+}
+
+BWTCoder::Int40::operator int64_t() const
+{
+	uint64_t value = 0;
+	for (int i = 0; i < BYTE_COUNT; ++i)
+	{
+		value |= static_cast<uint64_t>(m_bytes[i]) << (i * CHAR_BIT);
+	}
+
+	//extend the sign bit of the highest stored byte
+	const int unusedBits = (sizeof(uint64_t) - BYTE_COUNT) * CHAR_BIT;
+	return static_cast<int64_t>(value << unusedBits) >> unusedBits;
+}
+
+void BWTCoder::setSorter(Sorter sorter)
+{
+	m_sorter = sorter;
+}
+
+BWTCoder::Sorter BWTCoder::getSorter() const
+{
+	return m_sorter;
+}
+
+template<typename Index>
+std::vector<Index> BWTCoder::sortPermutationsByDoubling(const std::string& str) const
+{
+	const Index n = str.size();
+
+	//t contains the permutations ordered by their groups, a negative value -k marks a run of k permutations which are already sorted
+	//rank[permutation] = group of the permutation, which is the position of the last permutation of the group in t
+	std::vector<Index> t(n);
+	std::vector<Index> rank(n);
+
+	//group the permutations by their first character using Counting Sort
+	std::array<Index, UCHAR_MAX + 2> groupEnd = {};
+	for (unsigned char ch : str)
+	{
+		groupEnd[ch + 1]++;
+	}
+	for (int i = 1; i <= UCHAR_MAX + 1; ++i)
+	{
+		groupEnd[i] += groupEnd[i - 1];
+	}
+	for (Index i = 0; i < n; ++i)
+	{
+		t[groupEnd[static_cast<unsigned char>(str[i])]++] = i;
+	}
+	for (Index i = 0; i < n; ++i)
+	{
+		rank[i] = groupEnd[static_cast<unsigned char>(str[i])] - 1;
+	}
+	for (Index i = 0; i < n; ++i)
+	{
+		//groups with a single permutation are sorted
+		if (i == rank[t[i]] && (i == 0 || rank[t[i - 1]] != i))
+		{
+			t[i] = -1;
+		}
+	}
+
+	std::vector<bool> boundaries;               //boundaries[i] = whether a new group starts at the i-th permutation of the group being split
+	std::vector<std::pair<Index, Index>> keys; //pairs (key, permutation) of a small group being split
+	keys.reserve(std::min(static_cast<Index>(DOUBLING_BUFFER_SIZE), n));
+
+	//the permutations are sorted by their first h characters, after a pass by their first 2h characters
+	//once h reaches n or a pass doesn't split any group, all remaining groups contain equal permutations, their order doesn't matter
+	bool split = true;
+	for (uint64_t h = 1; h < static_cast<uint64_t>(n) && t[0] != -n && split; h *= 2)
+	{
+		split = false;
+
+		//group of the permutation which starts h characters later than the given one
+		auto key = [&rank, n, h](Index permutation) -> Index
+		{
+			Index next = permutation + static_cast<Index>(h);
+			return rank[next >= n ? next - n : next];
+		};
+
+		Index first = 0;        //position of the current group in t
+		Index sortedLength = 0; //length of the run of sorted permutations in front of the current group
+
+		while (first < n)
+		{
+			if (t[first] < 0)
+			{
+				//skip the sorted permutations, neighbouring runs are joined
+				Index length = -t[first];
+				sortedLength += length;
+				first += length;
+				continue;
 			}
-			else //if the current value in the second half of the range is lesser than the current value in the first half of the range
+
+			if (sortedLength > 0)
+			{
+				t[first - sortedLength] = -sortedLength;
+				sortedLength = 0;
+			}
+
+			Index last = rank[t[first]] + 1; //position after the last permutation of the current group
+
+			//find the new groups before any rank changes, the keys of the permutations may point into this group
+			boundaries.assign(last - first, false);
+
+			if (last - first <= static_cast<Index>(DOUBLING_BUFFER_SIZE))
 			{
-				//assign it to the current position in the sorted vectors
-				*sortedIt = *it2;
-				*sortedTIt = *(tFirst + (it2 - first));
+				//the keys of small groups are read only once, every read is likely a cache miss
+				keys.clear();
+				for (Index i = first; i < last; ++i)
+				{
+					keys.emplace_back(key(t[i]), t[i]);
+				}
 
-				//move to the next position in sorted vectors
-				sortedIt++;
-				sortedTIt++;
+				std::sort(keys.begin(), keys.end());
+
+				for (Index i = first; i < last; ++i)
+				{
+					t[i] = keys[i - first].second;
+					if (i > first) boundaries[i - first] = keys[i - first].first != keys[i - first - 1].first;
+				}
+			}
+			else
+			{
+				//large groups of equal permutations, such as runs of a single character, often don't split at all
+				Index firstKey = key(t[first]);
+				Index i = first + 1;
+				while (i < last && key(t[i]) == firstKey) i++;
 
-				if (it2 < last - 1) //we are not at the end of the second half of the range yet
+				if (i == last)
 				{
-					it2++; //move to the next position in the second half of the range
+					first = last;
+					continue;
 				}
-				else //we are at the end of the second half of the range
+
+				//sort the group by the groups of the permutations h characters later
+				std::sort(t.begin() + first, t.begin() + last, [&key](Index permutation1, Index permutation2)
 				{
-					//add the remainder of the first half of the range to the end of the sorted vectors
-					while (it1 < midLast)
-					{
-						//assign the current value from the first half of the range to the current position in the sorted vectors
-						*sortedIt = *it1;
-						*sortedTIt = *(tFirst + (it1 - first));
+					return key(permutation1) < key(permutation2);
+				});
 
-						//move to the next position in sorted vectors
-						sortedIt++;
-						sortedTIt++;
+				for (i = first + 1; i < last; ++i)
+				{
+					boundaries[i - first] = key(t[i]) != key(t[i - 1]);
+				}
+			}
 
-						it1++; //move to the next position in the first half of the range
-					}
+			//assign the new groups from the back, the last one keeps the rank of the original group
+			Index groupLast = last - 1;
+			for (Index i = last - 1; i >= first; --i)
+			{
+				rank[t[i]] = groupLast;
 
-					done = true; //the entire range is sorted
+				if (i == first || boundaries[i - first])
+				{
+					if (i == groupLast) t[i] = -1; //a group with a single permutation is sorted
+					if (i > first) split = true;
+					groupLast = i - 1;
 				}
 			}
+
+			first = last;
 		}
 
-		//overwrite the original ranges with the sorted ranges
-		std::copy(sorted.begin(), sorted.end(), first);
-		std::copy(tSorted.begin(), tSorted.end(), tFirst);
+		if (sortedLength > 0)
+		{
+			t[first - sortedLength] = -sortedLength;
+		}
 	}
+
+	//permutations in the groups which remained unsorted are equal, give them distinct ranks in their current order
+	for (Index first = 0; first < n;)
+	{
+		if (t[first] < 0)
+		{
+			first -= t[first];
+			continue;
+		}
+
+		Index last = rank[t[first]] + 1;
+		for (Index i = first; i < last; ++i)
+		{
+			rank[t[i]] = i;
+		}
+
+		first = last;
+	}
+
+	//the rank of every permutation is now its position in the sorted order
+	for (Index i = 0; i < n; ++i)
+	{
+		t[rank[i]] = i;
+	}
+
+	return t;
 }
 
-template<typename RandomAccessIterator>
-std::vector<uint32_t> BWTCoder::mergeSort(RandomAccessIterator first, RandomAccessIterator last) const
+template<typename Storage, typename Text>
+void BWTCoder::sortSuffixes(const Text& text, Storage* SA, int64_t n, int64_t alphabetSize) const
 {
-	auto elementCount = last - first;
+	//types[i] = whether the suffix at i is S-type (smaller than the next suffix), otherwise it is L-type
+	//the sentinel is S-type and the suffix in front of it is L-type
+	std::vector<bool> types(n);
+	types[n - 1] = true;
+	for (int64_t i = n - 3; i >= 0; --i)
+	{
+		int64_t current = text(i);
+		int64_t next = text(i + 1);
+		types[i] = current < next || (current == next && types[i + 1]);
+	}
 
-	//allocate space for the result
-	std::vector<uint32_t> t;
-	t.reserve(elementCount);
+	//left-most S-type suffixes, the ones right after an L-type suffix
+	auto isLMS = [&types](int64_t i)
+	{
+		return i > 0 && types[i] && !types[i - 1];
+	};
+
+	//buckets[character] = beginning or end of the bucket of the suffixes starting with the character in SA
+	std::vector<Storage> buckets;
+	auto getBuckets = [&text, &buckets, n, alphabetSize](bool end)
+	{
+		buckets.assign(alphabetSize, Storage(0));
+		for (int64_t i = 0; i < n; ++i)
+		{
+			int64_t ch = text(i);
+			buckets[ch] = buckets[ch] + 1;
+		}
+
+		int64_t sum = 0;
+		for (int64_t ch = 0; ch < alphabetSize; ++ch)
+		{
+			int64_t count = buckets[ch];
+			sum += count;
+			buckets[ch] = end ? sum : sum - count;
+		}
+	};
+
+	//the L-type suffixes are placed from the beginnings of their buckets in the order of the suffixes one character later,
+	//then the S-type suffixes from the ends of their buckets backwards
+	auto induce = [&]()
+	{
+		getBuckets(false);
+		for (int64_t i = 0; i < n; ++i)
+		{
+			int64_t j = static_cast<int64_t>(SA[i]) - 1;
+			if (j < 0 || types[j]) continue;
+
+			int64_t ch = text(j);
+			int64_t position = buckets[ch];
+			buckets[ch] = position + 1;
+			SA[position] = j;
+		}
+
+		getBuckets(true);
+		for (int64_t i = n - 1; i >= 0; --i)
+		{
+			int64_t j = static_cast<int64_t>(SA[i]) - 1;
+			if (j < 0 || !types[j]) continue;
+
+			int64_t ch = text(j);
+			int64_t position = buckets[ch] - 1;
+			buckets[ch] = position;
+			SA[position] = j;
+		}
+	};
 
-	//each element of the result will have the value of it's unsorted index
-	for (int i = 0; i < elementCount; ++i)
+	//sort the substrings between the left-most S-type suffixes by placing the suffixes at the ends of their buckets and inducing
+	std::fill(SA, SA + n, Storage(-1));
+	getBuckets(true);
+	for (int64_t i = 1; i < n; ++i)
 	{
-		t.push_back(i);
+		if (!isLMS(i)) continue;
+
+		int64_t ch = text(i);
+		int64_t position = buckets[ch] - 1;
+		buckets[ch] = position;
+		SA[position] = i;
 	}
+	induce();
+	std::vector<Storage>().swap(buckets);
 
-	//sort
-	sortRange(first, last, t.begin(), t.end());
+	//move the sorted left-most S-type suffixes to the beginning, there are at most n / 2 of them
+	int64_t n1 = 0;
+	for (int64_t i = 0; i < n; ++i)
+	{
+		if (isLMS(SA[i])) SA[n1++] = SA[i];
+	}
 
-	return t;
+	//name the substrings, equal substrings get equal names, the name of the substring at i is stored at n1 + i / 2
+	std::fill(SA + n1, SA + n, Storage(-1));
+	int64_t name = 0;
+	int64_t previous = -1;
+	for (int64_t i = 0; i < n1; ++i)
+	{
+		int64_t position = SA[i];
+		bool different = previous < 0;
+		for (int64_t d = 0; !different; ++d)
+		{
+			if (text(position + d) != text(previous + d) || types[position + d] != types[previous + d])
+			{
+				different = true;
+			}
+			else if (d > 0 && (isLMS(position + d) || isLMS(previous + d)))
+			{
+				break;
+			}
+		}
+
+		if (different)
+		{
+			name++;
+			previous = position;
+		}
+		SA[n1 + position / 2] = name - 1;
+	}
+
+	//the names in the order of the substrings form the reduced text at the end of SA, it ends with the name 0 of the sentinel
+	for (int64_t i = n - 1, j = n - 1; i >= n1; --i)
+	{
+		if (SA[i] >= 0) SA[j--] = SA[i];
+	}
+
+	Storage* SA1 = SA;
+	Storage* s1 = SA + n - n1;
+	if (name < n1)
+	{
+		sortSuffixes<Storage>(StoredText<Storage>{ s1 }, SA1, n1, name);
+	}
+	else
+	{
+		//all names are unique, they are the ranks of the suffixes
+		for (int64_t i = 0; i < n1; ++i)
+		{
+			SA1[s1[i]] = i;
+		}
+	}
+
+	//map the sorted reduced suffixes back to the positions of the left-most S-type suffixes
+	for (int64_t i = 1, j = 0; i < n; ++i)
+	{
+		if (isLMS(i)) s1[j++] = i;
+	}
+	for (int64_t i = 0; i < n1; ++i)
+	{
+		SA1[i] = s1[SA1[i]];
+	}
+	std::fill(SA + n1, SA + n, Storage(-1));
+
+	//place the sorted left-most S-type suffixes at the ends of their buckets in their order and induce all suffixes from them
+	getBuckets(true);
+	for (int64_t i = n1 - 1; i >= 0; --i)
+	{
+		int64_t j = SA[i];
+		SA[i] = -1;
+
+		int64_t ch = text(j);
+		int64_t position = buckets[ch] - 1;
+		buckets[ch] = position;
+		SA[position] = j;
+	}
+	induce();
 }
 
-std::vector<uint32_t> BWTCoder::sortPermutations(const std::string& str) const
+template<typename Storage>
+std::vector<Storage> BWTCoder::sortPermutationsBySuffixes(const std::string& str) const
 {
-	//create vector of all permutations 
-	std::vector<StringPermutation> permutations;
-	permutations.reserve(str.size());
+	const int64_t n = str.size();
+	if (n == 0) return std::vector<Storage>();
 
-	for (uint32_t i = 0; i < str.size(); ++i)
+	const unsigned char* characters = reinterpret_cast<const unsigned char*>(str.data());
+	auto at = [characters, n](int64_t i)
+	{
+		return characters[i < n ? i : i - n];
+	};
+
+	//Duval's algorithm factorizes the string concatenated with itself into Lyndon words,
+	//the last factor starting in the first half is the least permutation, its length is the period of the permutation
+	int64_t start = 0;
+	int64_t period = n;
+	for (int64_t i = 0; i < n;)
 	{
-		permutations.push_back(StringPermutation(str, i));
+		start = i;
+		int64_t j = i + 1;
+		int64_t k = i;
+		while (j < 2 * n && at(k) <= at(j))
+		{
+			k = at(k) < at(j) ? i : k + 1;
+			j++;
+		}
+
+		period = j - k;
+		while (i <= k)
+		{
+			i += period;
+		}
 	}
 
-	//sort permutations
-	std::vector<uint32_t> t = mergeSort(permutations.begin(), permutations.end());
+	//sort the suffixes of the Lyndon word followed by the sentinel, the sentinel is the first suffix
+	std::vector<Storage> t(n + 1);
+	sortSuffixes<Storage>(RotatedText{ characters, n, start, period }, t.data(), period + 1, UCHAR_MAX + 2);
+
+	const int64_t repetitions = n / period;
+	if (repetitions == 1)
+	{
+		for (int64_t i = 0; i < n; ++i)
+		{
+			int64_t permutation = static_cast<int64_t>(t[i + 1]) + start;
+			t[i] = permutation < n ? permutation : permutation - n;
+		}
+	}
+	else
+	{
+		//every permutation of the Lyndon word stands for the equal permutations of all its repetitions,
+		//they are expanded from the back so that no index is overwritten before it is read
+		for (int64_t i = period - 1; i >= 0; --i)
+		{
+			int64_t permutation = static_cast<int64_t>(t[i + 1]) + start;
+			for (int64_t j = repetitions - 1; j >= 0; --j)
+			{
+				t[i * repetitions + j] = (permutation + j * period) % n;
+			}
+		}
+	}
+	t.resize(n);
 
 	return t;
 }
 
-std::string BWTCoder::encode(const std::string& input) const
+template<typename Index>
+std::string BWTCoder::createOutput(const std::string& input, const std::vector<Index>& t, int indexSize) const
 {
 	//allocate space for the result
 	std::string output;
-	output.reserve(input.size() + INDEX_SIZE);
-
-	//get vector t where t[lexicographical order of given permutation] = index of the first character of given permutation in the string
-	std::vector<uint32_t> t = sortPermutations(input);
+	output.reserve(input.size() + indexSize);
+	output.resize(indexSize);
 
-	uint32_t index; //BWT index
+	uint64_t index = 0; //BWT index
 
 	//iterate over all permutatins in sorted order
-	for (uint32_t i = 0; i < t.size(); ++i)
+	for (size_t i = 0; i < t.size(); ++i)
 	{
 		//take the last character of current permutation
-		output += input[(t[i] + input.size() - 1) % input.size()];
+		output += input[(t[i] == 0 ? input.size() : t[i]) - 1];
 		//the value of the BWT index is a position where t contains 0
 		if (t[i] == 0)
 		{
@@ -177,53 +618,114 @@ std::string BWTCoder::encode(const std::string& input) const
 	}
 
 	//save the BWT index at the beginning of output
-	output.insert(0, encodeNumber(index, INDEX_SIZE));
+	output.replace(0, indexSize, encodeNumber(index, indexSize));
 
 	return output;
 }
 
-std::string BWTCoder::decode(const std::string& input) const
+template<typename Index, typename Storage>
+std::string BWTCoder::decodeLastColumn(const std::string& last, uint64_t index) const
 {
-	std::string last = input.substr(INDEX_SIZE);  //last column of sorted permutation matrix
-	std::string first = input.substr(INDEX_SIZE); //here will be the first column of sorted permutation matrix
+	//we need a mapping from the rows of the sorted permutation matrix to the rows of the permutations which start one character earlier,
+	//which is the position of the character in the first column, obtained by counting the characters of the last column
+	std::array<Index, UCHAR_MAX + 1> firstRows = {};
+	for (unsigned char ch : last)
+	{
+		firstRows[ch]++;
+	}
 
-	//get first by sorting last
-	//also get vector t where t[new  index] = old index
-	std::vector<uint32_t> t = mergeSort(first.begin(), first.end());
+	Index sum = 0;
+	for (Index& firstRow : firstRows)
+	{
+		Index count = firstRow;
+		firstRow = sum;
+		sum += count;
+	}
 
-	//we need a mapping from the old ordering to the new
-	std::vector<uint32_t> tRev(t.size());
-	for (uint32_t i = 0; i < tRev.size(); ++i)
+	std::vector<Storage> tRev(last.size());
+	for (size_t i = 0; i < tRev.size(); ++i)
 	{
-		tRev[t[i]] = i;
+		tRev[i] = firstRows[static_cast<unsigned char>(last[i])]++;
 	}
 
-	//std::string output(last.size(), '0'); //allocate string for output
-	std::string output;
-	output.reserve(last.size());
+	//the string is decoded from its end
+	std::string output(last.size(), '\0');
+
+	Index row = index;
+	for (size_t i = last.size(); i > 0; --i)
+	{
+		output[i - 1] = last[row];
+		row = tRev[row];
+	}
+
+	return output;
+}
+
+std::string BWTCoder::encode(const std::string& input) const
+{
+	return encode(input, INDEX_SIZE);
+}
+
+std::string BWTCoder::encode(const std::string& input, int indexSize) const
+{
+	return encode(input, indexSize, m_sorter);
+}
+
+std::string BWTCoder::encode(const std::string& input, int indexSize, Sorter sorter) const
+{
+	//32-bit indices can't address all permutations of huge inputs, induced sorting needs only a single array of them,
+	//40-bit indices keep it at 5 bytes per character instead of 8
+	if (input.size() >= static_cast<size_t>(INT32_MAX))
+	{
+		if (input.size() < static_cast<uint64_t>(Int40::MAX)) return createOutput(input, sortPermutationsBySuffixes<Int40>(input), indexSize);
 
-	uint32_t index = decodeNumber(input.substr(0, INDEX_SIZE)); //decode BWT index from the beginning of input
+		return createOutput(input, sortPermutationsBySuffixes<int64_t>(input), indexSize);
+	}
 
-	//decode the rest
-	for (uint32_t i = 0; i < last.size(); ++i)
+	if (sorter == Sorter::INDUCED_SORTING)
 	{
-		uint32_t prevIndex;
+		return createOutput(input, sortPermutationsBySuffixes<int32_t>(input), indexSize);
+	}
 
-		if (i == 0)
-		{
-			output += last[index];
-			prevIndex = index;
-		}
-		else
-		{
-			output += last[tRev[prevIndex]];
-			prevIndex = tRev[prevIndex];
-		}
+	if (sorter == Sorter::PREFIX_DOUBLING)
+	{
+		return createOutput(input, sortPermutationsByDoubling<int32_t>(input), indexSize);
 	}
 
-	std::reverse(output.begin(), output.end());
+	//get vector t where t[lexicographical order of given permutation] = index of the first character of given permutation in the string
+	return createOutput(input, sortPermutations(input, sorter), indexSize);
+}
 
-	return output;
+std::string BWTCoder::decode(const std::string& input) const
+{
+	return decode(input, INDEX_SIZE);
+}
+
+std::string BWTCoder::decode(const std::string& input, int indexSize) const
+{
+	//the input must contain at least the BWT index, otherwise it is corrupted
+	if (input.size() < static_cast<size_t>(indexSize))
+	{
+		return std::string();
+	}
+
+	uint64_t index = decodeNumber(input.substr(0, indexSize)); //decode BWT index from the beginning of input
+	std::string last = input.substr(indexSize);                //last column of sorted permutation matrix
+
+	//the index must point to one of the permutations, otherwise the input is corrupted
+	if (index >= last.size())
+	{
+		return std::string();
+	}
+
+	if (last.size() > UINT32_MAX)
+	{
+		if (last.size() <= static_cast<uint64_t>(Int40::MAX)) return decodeLastColumn<uint64_t, Int40>(last, index);
+
+		return decodeLastColumn<uint64_t>(last, index);
+	}
+
+	return decodeLastColumn<uint32_t>(last, index);
 }
 
 BWTCoder::StringPermutation::StringPermutation(const std::string& str, uint32_t startIndex)
@@ -2,6 +2,9 @@
 
 #include "BlockCoder.h"
 
+#include <climits>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 /**
@@ -9,8 +12,23 @@
 */
 class BWTCoder : public BlockCoder
 {
+public:
+
+	/**
+	*   algorithms which can be used for sorting the permutations of the input string
+	*/
+	enum class Sorter
+	{
+		PREFIX_DOUBLING, //!< Larsson-Sadakane prefix doubling over the ranks of the permutations, O(n log n) regardless of the content
+		MERGE_SORT,      //!< bottom-up Merge Sort with an Insertion Sort cutoff, the reference comparison sort
+		STD_SORT,        //!< std::stable_sort with the same comparisons, used as a baseline for benchmarking
+		INDUCED_SORTING  //!< SA-IS over the least permutation, linear time and a single array of indices besides the input
+	};
+
 private:
 
+	Sorter m_sorter = Sorter::INDUCED_SORTING; //!< algorithm used for sorting the permutations of the input string
+
 	class StringPermutation
 	{
 	private:
@@ -53,44 +71,155 @@ private:
 	};
 
 	/**
-	*   Sorts elements in the range [first,last) in ascending order using Merge Sort algorithm
-	*   The range [tFirst,tLast) must have the same length as the range [first,last), it's elements are sorted in the same order
-	*   Each element in the range [tFirst,tLast) must contain the value of the index of the element before sorting,
-	*   so after sorting we get a vector where t[new  index] = old index
+	*   signed integer of 40 bits stored in 5 bytes, the indices of huge blocks are kept in it instead of int64_t,
+	*   which saves 3 bytes per index, the arithmetic is done in int64_t
+	*/
+	class Int40
+	{
+	private:
+
+		static constexpr int BYTE_COUNT = 5;
+
+		uint8_t m_bytes[BYTE_COUNT]; //!< value in two's complement, least significant byte first
+
+	public:
+
+		static constexpr int64_t MAX = (int64_t(1) << (BYTE_COUNT * CHAR_BIT - 1)) - 1; //!< maximum value which can be stored
+
+		Int40() = default;
+
+		explicit Int40(int64_t value);
+
+		Int40& operator=(int64_t value);
+
+		operator int64_t() const;
+	};
+
+	/**
+	*   number of elements below which a range is sorted by Insertion Sort instead of being merged
+	*/
+	static constexpr int INSERTION_SORT_THRESHOLD = 16;
+
+	/**
+	*   maximum number of permutations of a group whose keys are buffered while the group is split by prefix doubling
+	*/
+	static constexpr int DOUBLING_BUFFER_SIZE = 1 << 16;
+
+	/**
+	*   \brief Sorts elements in the range [first,last) in ascending order using Insertion Sort algorithm, the sort is stable
 	*   \param first iterator to the first element of the range to be sorted
 	*   \param last iterator to the element after the last element of the range to be sorted
-	*   \param tFirst iterator to the first element of the range where the mapping will be created
-	*   \param tLast iterator to the element after the last element of the range where the mapping will be created
+	*   \param less comparison function object, returns true if the first argument goes before the second
 	*/
 	template
-	<typename RandomAccessIterator>
-	void sortRange(RandomAccessIterator first, RandomAccessIterator last, std::vector<uint32_t>::iterator tFirst, std::vector<uint32_t>::iterator tLast) const;
+	<typename Compare>
+	void insertionSort(std::vector<uint32_t>::iterator first, std::vector<uint32_t>::iterator last, Compare less) const;
 
 	/**
-	*   \brief Sorts elements in the range [first,last) in ascending order using Merge Sort algorithm
-	*   \param first iterator to the first element of the range to be sorted
-	*   \param last iterator to the element after the last element of the range to be sorted
-	*   \return vector t where t[new  index] = old index
+	*   \brief Sorts vector t in ascending order using bottom-up Merge Sort algorithm, the sort is stable
+	*   Runs of INSERTION_SORT_THRESHOLD elements are sorted by Insertion Sort first, then they are merged
+	*   back and forth between t and a single scratch buffer of the same size, no other memory is allocated
+	*   \param t vector to be sorted
+	*   \param less comparison function object, returns true if the first argument goes before the second
+	*/
+	template
+	<typename Compare>
+	void mergeSort(std::vector<uint32_t>& t, Compare less) const;
+
+	/**
+	*   \brief Determines the lexicographical order of all permutations of the input string by comparing them
+	*   \param str string whose permutatios will be sorted
+	*   \param sorter MERGE_SORT or STD_SORT
+	*   \return vector t where t[lexicographical order of given permutation] = index of the first character of given permutation in the string
+	*/
+	std::vector<uint32_t> sortPermutations(const std::string& str, Sorter sorter) const;
+
+	/**
+	*   \brief Determines the lexicographical order of all permutations of the input string by prefix doubling
+	*   The permutations are first grouped by their first character, then every pass sorts the unsorted groups by the group
+	*   of the permutation which starts h characters later and splits them, which doubles the number of sorted characters.
+	*   Apart from the input only two arrays of n indices are used, groups which are already sorted are skipped.
+	*   \param str string whose permutatios will be sorted
+	*   \return vector t where t[lexicographical order of given permutation] = index of the first character of given permutation in the string
 	*/
 	template
-	<typename RandomAccessIterator>
-	std::vector<uint32_t> mergeSort(RandomAccessIterator first, RandomAccessIterator last) const;
+	<typename Index>
+	std::vector<Index> sortPermutationsByDoubling(const std::string& str) const;
 
 	/**
-	*   \brief Determines the lexicographical order of all permutations of the input string
+	*   \brief Computes the suffix array of a text ending with a sentinel by induced sorting (SA-IS)
+	*   The left-most S-type suffixes are sorted first, the sorted suffixes induce the order of the others. If the substrings
+	*   between them aren't unique, their names form a reduced text which is stored in the upper half of the suffix array
+	*   and sorted recursively. Besides the suffix array only a bit per character and a counter per character are allocated.
+	*   \param text function object returning the character at a position, the last character is a unique 0
+	*   \param SA suffix array of the text gets saved here, indices are stored as Storage
+	*   \param n length of the text including the sentinel, at least 2
+	*   \param alphabetSize number of different characters, all characters are smaller
+	*/
+	template
+	<typename Storage, typename Text>
+	void sortSuffixes(const Text& text, Storage* SA, int64_t n, int64_t alphabetSize) const;
+
+	/**
+	*   \brief Determines the lexicographical order of all permutations of the input string by induced sorting of suffixes
+	*   The least permutation of the string is found by Duval's algorithm, it is a repetition of a Lyndon word, whose
+	*   permutations are ordered like its suffixes. So the suffix array of the Lyndon word followed by a sentinel gives
+	*   the order of the permutations, the repetitions of an equal permutation follow each other.
+	*   Apart from the input only one array of n + 1 indices is used, which are stored as Storage.
 	*   \param str string whose permutatios will be sorted
 	*   \return vector t where t[lexicographical order of given permutation] = index of the first character of given permutation in the string
 	*/
-	std::vector<uint32_t> sortPermutations(const std::string& str) const;
+	template
+	<typename Storage>
+	std::vector<Storage> sortPermutationsBySuffixes(const std::string& str) const;
+
+	/**
+	*   \brief Creates the output of BWT from the sorted permutations
+	*   \param input input string (uncoded)
+	*   \param t vector where t[lexicographical order of given permutation] = index of the first character of given permutation in the string
+	*   \param indexSize size of the stored BWT index in bytes
+	*   \return encoded string
+	*/
+	template
+	<typename Index>
+	std::string createOutput(const std::string& input, const std::vector<Index>& t, int indexSize) const;
+
+	/**
+	*   \brief Reconstructs the input of BWT from its last column
+	*   The rows are computed as Index and stored as Storage, which may be a smaller type converting to and from Index
+	*   \param last last column of the sorted permutation matrix
+	*   \param index BWT index
+	*   \return decoded string
+	*/
+	template
+	<typename Index, typename Storage = Index>
+	std::string decodeLastColumn(const std::string& last, uint64_t index) const;
 
 public:
 
+	/**
+	*   \brief Sets the algorithm used for sorting the permutations of the input string
+	*   \param sorter algorithm used for sorting the permutations of the input string
+	*/
+	void setSorter(Sorter sorter);
+
+	/**
+	*   \brief Gets the algorithm used for sorting the permutations of the input string
+	*   \return algorithm used for sorting the permutations of the input string
+	*/
+	Sorter getSorter() const;
+
 	/**
 	*   size of encoded BWT index for a single block in bytes 
 	*   value of the index cannot be greater than the value of the size of a block
 	*/
 	static constexpr int INDEX_SIZE = sizeof(uint32_t);
 
+	/**
+	*   size of encoded BWT index for a single block in bytes if blocks may be larger than 4 GiB
+	*/
+	static constexpr int LARGE_INDEX_SIZE = sizeof(uint64_t);
+
 	/**
 	*   \brief Encodes the input string using BWT transform
 	*   \param input input string (uncoded)
@@ -98,10 +227,36 @@ public:
 	*/
 	std::string encode(const std::string& input) const override;
 
+	/**
+	*   \brief Encodes the input string using BWT transform
+	*   Inputs with more than INT32_MAX characters are always sorted by induced sorting with 40-bit indices, or 64-bit indices beyond Int40::MAX
+	*   \param input input string (uncoded)
+	*   \param indexSize size of the stored BWT index in bytes, INDEX_SIZE or LARGE_INDEX_SIZE
+	*   \return encoded string
+	*/
+	std::string encode(const std::string& input, int indexSize) const;
+
+	/**
+	*   \brief Encodes the input string using BWT transform with the given sorter instead of the set one
+	*   \param input input string (uncoded)
+	*   \param indexSize size of the stored BWT index in bytes, INDEX_SIZE or LARGE_INDEX_SIZE
+	*   \param sorter algorithm used for sorting the permutations of the input string, ignored for inputs with more than INT32_MAX characters
+	*   \return encoded string
+	*/
+	std::string encode(const std::string& input, int indexSize, Sorter sorter) const;
+
 	/**
 	*   \brief Decodes the input string using BWT transform
 	*   \param input input string (encoded)
 	*   \return decoded string
 	*/
 	std::string decode(const std::string& input) const override;
+
+	/**
+	*   \brief Decodes the input string using BWT transform
+	*   \param input input string (encoded)
+	*   \param indexSize size of the stored BWT index in bytes, the same as used for encoding
+	*   \return decoded string
+	*/
+	std::string decode(const std::string& input, int indexSize) const;
 };
@@ -2,111 +2,1192 @@
 
 #include "BWT_MTF_RLE_Huffman_Coder.h"
 
+#include "CRC32C.h"
+#include "Decoder.h"
+#include "Encoder.h"
+#include "ReadAheadBuffer.h"
+#include "StageTimer.h"
+#include "ThreadPool.h"
+
 #include <algorithm>
+#include <array>
+#include <climits>
 #include <cmath>
+#include <future>
+
+//the levels differ only in the block size and the stage selection, the sorter isn't part of a level, because induced sorting,
+//the default of BWTCoder, is the fastest one at every block size, and the number of threads is left to the caller
+const BWT_MTF_RLE_Huffman_Coder::Preset BWT_MTF_RLE_Huffman_Coder::PRESETS[MAX_LEVEL] =
+{
+	//fast levels use small blocks, which are sorted quickly and keep the data of all threads in cache
+	{ 100000, false },
+	{ 200000, false },
+	{ 300000, true },
+	{ 400000, true },
+	{ 500000, true },
+	//high levels use large blocks, which give BWT more context
+	{ 1000000, true },
+	{ 2000000, true },
+	{ 4000000, true },
+	{ 8000000, true }
+};
+
+uint64_t BWT_MTF_RLE_Huffman_Coder::getEncodeMemory(uint64_t blockSize, BWTCoder::Sorter sorter)
+{
+	//the intermediate results of the stages are about as large as the block, the sorter needs the most memory on top of them,
+	//blocks of INT32_MAX bytes or more are always sorted by induced sorting
+	uint64_t sorterMemory = SORTER_MEMORY_PER_BYTE;
+	if (blockSize >= INT32_MAX) sorterMemory = LARGE_SORTER_MEMORY_PER_BYTE;
+	else if (sorter == BWTCoder::Sorter::INDUCED_SORTING) sorterMemory = INDUCED_SORTER_MEMORY_PER_BYTE;
+
+	return (STAGE_MEMORY_PER_BYTE + sorterMemory) * blockSize;
+}
+
+uint64_t BWT_MTF_RLE_Huffman_Coder::getBlockMemoryBudget() const
+{
+	if (m_memoryBudget == 0) return 0;
+
+	//a budget smaller than the fixed part leaves nothing for the blocks, they get as small as allowed
+	return (m_memoryBudget > BASE_MEMORY) ? m_memoryBudget - BASE_MEMORY : 1;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::fitEncodeBudget(uint64_t& blockSize, unsigned& threadCount, BWTCoder::Sorter& sorter) const
+{
+	blockSize = m_blockSize;
+	threadCount = m_threadCount;
+	sorter = m_BWTCoder.getSorter();
+
+	uint64_t budget = getBlockMemoryBudget();
+	if (budget == 0) return;
+
+	//all sorters give the same order, a sorter needing less memory costs neither ratio nor parallelism
+	if (threadCount * getEncodeMemory(blockSize, sorter) > budget)
+	{
+		sorter = BWTCoder::Sorter::INDUCED_SORTING;
+	}
+
+	//parallelism is given up next, so that the ratio isn't affected as long as possible
+	while (threadCount > 1 && threadCount * getEncodeMemory(blockSize, sorter) > budget)
+	{
+		threadCount--;
+	}
+
+	if (getEncodeMemory(blockSize, sorter) > budget)
+	{
+		blockSize = std::max(std::min(blockSize, budget / (STAGE_MEMORY_PER_BYTE + INDUCED_SORTER_MEMORY_PER_BYTE)), std::min(blockSize, MIN_BUDGET_BLOCK_SIZE));
+	}
+}
+
+StreamHeader BWT_MTF_RLE_Huffman_Coder::getStreamHeader(uint64_t blockSize) const
+{
+	StreamHeader streamHeader;
+	streamHeader.m_blockSize = blockSize;
+	if (m_searchIndex) streamHeader.m_flags |= StreamFormat::FLAG_SEARCH_INDEX;
+	if (m_checksum) streamHeader.m_flags |= StreamFormat::FLAG_CHECKSUM;
+	if (m_largeBlocks || blockSize > StreamFormat::MAX_BLOCK_SIZE) streamHeader.m_flags |= StreamFormat::FLAG_LARGE_BLOCKS;
+	if (m_model) streamHeader.m_flags |= StreamFormat::FLAG_MODEL;
+	if (m_deduplication) streamHeader.m_flags |= StreamFormat::FLAG_DEDUP;
+
+	return streamHeader;
+}
+
+uint64_t BWT_MTF_RLE_Huffman_Coder::getMaxCodedBlockSize(const StreamHeader& streamHeader, uint64_t uncodedSize) const
+{
+	//BWT adds its index, MTF keeps the size, RLE at most doubles the size by escaping special symbols,
+	//Huffman never makes the data longer, but adds the histogram and the number of encoded values
+	const uint64_t sizeFieldSize = m_streamFormat.getSizeFieldSize(streamHeader);
+	uint64_t size = 2 * (uncodedSize + sizeFieldSize) + (UCHAR_MAX + 2) * sizeFieldSize;
+
+	if (streamHeader.m_flags & StreamFormat::FLAG_SEARCH_INDEX)
+	{
+		size += m_FMIndex.getMaxIndexSize(uncodedSize);
+	}
+
+	return size;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::isIncompressible(const std::string& block) const
+{
+	std::array<uint32_t, UCHAR_MAX + 1> hist = {}; //histogram of the sample
+	std::vector<bool> pairs(1 << (2 * CHAR_BIT));  //pairs of neighbouring bytes present in the sample
+	size_t sampleSize = 0;                         //number of sampled bytes
+	size_t pairCount = 0;                          //number of distinct pairs of neighbouring bytes
+
+	//chunks of the sample are spread evenly over the whole block
+	const size_t chunkCount = ENTROPY_SAMPLE_SIZE / ENTROPY_SAMPLE_CHUNK;
+	const size_t stride = std::max(block.size() / chunkCount, ENTROPY_SAMPLE_CHUNK);
+
+	for (size_t chunk = 0; chunk < block.size(); chunk += stride)
+	{
+		size_t chunkEnd = std::min(chunk + ENTROPY_SAMPLE_CHUNK, block.size());
+
+		for (size_t i = chunk; i < chunkEnd; ++i)
+		{
+			unsigned char ch = block[i];
+			hist[ch]++;
+
+			if (i > chunk)
+			{
+				size_t pair = (static_cast<unsigned char>(block[i - 1]) << CHAR_BIT) | ch;
+				if (!pairs[pair])
+				{
+					pairs[pair] = true;
+					pairCount++;
+				}
+			}
+		}
+
+		sampleSize += chunkEnd - chunk;
+	}
+
+	if (sampleSize == 0) return false;
+
+	//order-0 entropy in bits per byte
+	double entropy = 0.0;
+	for (uint32_t count : hist)
+	{
+		if (count == 0) continue;
+
+		double probability = static_cast<double>(count) / sampleSize;
+		entropy -= probability * std::log2(probability);
+	}
+
+	if (entropy < INCOMPRESSIBLE_ENTROPY) return false;
+
+	//expected number of distinct pairs if the sample were random
+	const double pairSpace = pairs.size();
+	double expectedPairCount = pairSpace * (1.0 - std::exp(-static_cast<double>(sampleSize) / pairSpace));
+
+	return pairCount >= INCOMPRESSIBLE_PAIR_RATIO * expectedPairCount;
+}
+
+double BWT_MTF_RLE_Huffman_Coder::getEntropy(const std::string& data)
+{
+	std::array<uint64_t, UCHAR_MAX + 1> hist = {};
+	for (unsigned char ch : data)
+	{
+		hist[ch]++;
+	}
+
+	double entropy = 0.0;
+	for (uint64_t count : hist)
+	{
+		if (count == 0) continue;
+
+		double probability = static_cast<double>(count) / data.size();
+		entropy -= probability * std::log2(probability);
+	}
+
+	return entropy;
+}
+
+int64_t BWT_MTF_RLE_Huffman_Coder::estimateRLE0(const std::string& data, uint64_t& zeroRuns, uint64_t& escapes)
+{
+	int64_t change = 0;
+	zeroRuns = 0;
+	escapes = 0;
+
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		if (data[i] == '@')
+		{
+			//every special symbol is followed by an indicator
+			escapes++;
+			change++;
+		}
+		else if (data[i] == '\0')
+		{
+			size_t j = i + 1;
+			while (j < data.size() && data[j] == '\0') j++;
+
+			//a run of 0s is replaced by two special symbols, the indicator and the bits of its length, same as in RLE0Coder
+			uint64_t repeatCount = j - i;
+			if (repeatCount > 5)
+			{
+				zeroRuns++;
+				change += 3 + static_cast<int64_t>(std::floor(std::log2(repeatCount + 1))) - static_cast<int64_t>(repeatCount);
+			}
+
+			i = j - 1;
+		}
+	}
+
+	return change;
+}
+
+std::string BWT_MTF_RLE_Huffman_Coder::encodeBlock(const StreamHeader& streamHeader, BWTCoder::Sorter sorter, const std::string& block, BlockHeader& blockHeader, BlockLog& blockLog) const
+{
+	Workspace workspace;
+
+	return encodeBlock(streamHeader, sorter, block, blockHeader, blockLog, workspace);
+}
+
+std::string BWT_MTF_RLE_Huffman_Coder::encodeBlock(const StreamHeader& streamHeader, BWTCoder::Sorter sorter, const std::string& block, BlockHeader& blockHeader, BlockLog& blockLog, Workspace& workspace) const
+{
+	std::string bwt;
+	std::string output;
+
+	blockHeader.m_flags = 0;
+	blockHeader.m_searchIndexSize = 0;
+	blockHeader.m_modelID = 0;
+	blockLog = BlockLog();
+
+	StageTimer timer;
+	bool incompressible = isIncompressible(block);
+	timer.stop(blockLog.m_stages[STAGE_ANALYSIS]);
+
+	if (!incompressible)
+	{
+		bwt = m_BWTCoder.encode(block, m_streamFormat.getSizeFieldSize(streamHeader), sorter);
+		timer.stop(blockLog.m_stages[STAGE_BWT], bwt.size());
+
+		output = m_MTFCoder.encode(bwt);
+		timer.stop(blockLog.m_stages[STAGE_MTF], output.size());
+
+		if (m_stageSelection)
+		{
+			//MTF pays off only if it makes the distribution of values more skewed for the Huffman coder
+			blockLog.m_BWTEntropy = getEntropy(bwt);
+			blockLog.m_MTFEntropy = getEntropy(output);
+
+			if (blockLog.m_MTFEntropy >= blockLog.m_BWTEntropy)
+			{
+				blockHeader.m_flags |= StreamFormat::BLOCK_SKIP_MTF;
+				output = bwt;
+			}
+
+			//RLE pays off only if the runs of 0s save more than the escaping of the special symbols costs
+			if (estimateRLE0(output, blockLog.m_zeroRuns, blockLog.m_escapes) >= 0)
+			{
+				blockHeader.m_flags |= StreamFormat::BLOCK_SKIP_RLE0;
+			}
+
+			timer.stop(blockLog.m_stages[STAGE_ANALYSIS]);
+		}
+
+		if (!(blockHeader.m_flags & StreamFormat::BLOCK_SKIP_RLE0))
+		{
+			output = m_RLE0Coder.encode(output);
+			timer.stop(blockLog.m_stages[STAGE_RLE0], output.size());
+		}
+
+		//the shared model saves the histogram, but a large block may be described better by its own
+		const int sizeFieldSize = m_streamFormat.getSizeFieldSize(streamHeader);
+		if ((streamHeader.m_flags & StreamFormat::FLAG_MODEL) && m_model
+			&& m_huffmanCoder.getSharedEncodedSize(output, sizeFieldSize, m_model->getHuffmanTree()) <= m_huffmanCoder.getEncodedSize(output, sizeFieldSize, workspace.m_huffmanTree))
+		{
+			blockHeader.m_modelID = m_model->getID();
+			output = m_huffmanCoder.encodeShared(output, sizeFieldSize, m_model->getHuffmanTree());
+		}
+		else
+		{
+			output = m_huffmanCoder.encode(output, sizeFieldSize, workspace.m_huffmanTree);
+		}
+		timer.stop(blockLog.m_stages[STAGE_HUFFMAN], output.size());
+	}
+
+	//store the block raw if it wasn't encoded or didn't get any smaller, so that it can't grow by more than its header
+	if (bwt.empty() || output.size() >= block.size())
+	{
+		blockHeader.m_flags = StreamFormat::BLOCK_RAW;
+		blockHeader.m_modelID = 0;
+		output = block;
+	}
+	//the BWT is needed for the search index only during encoding, it is reconstructed from the encoded block when searching
+	else if (streamHeader.m_flags & StreamFormat::FLAG_SEARCH_INDEX)
+	{
+		std::string searchIndex = m_FMIndex.build(bwt);
+		blockHeader.m_searchIndexSize = searchIndex.size();
+		output += searchIndex;
+		timer.stop(blockLog.m_stages[STAGE_SEARCH_INDEX], searchIndex.size());
+	}
+
+	blockHeader.m_uncodedSize = block.size();
+	blockHeader.m_codedSize = output.size();
+	blockHeader.m_checksum = 0;
+
+	if (streamHeader.m_flags & StreamFormat::FLAG_CHECKSUM)
+	{
+		blockHeader.m_checksum = CRC32C::instance().compute(block);
+		timer.stop(blockLog.m_stages[STAGE_CHECKSUM], sizeof(blockHeader.m_checksum));
+	}
+
+	blockLog.m_uncodedSize = blockHeader.m_uncodedSize;
+	blockLog.m_codedSize = blockHeader.m_codedSize;
+	blockLog.m_flags = blockHeader.m_flags;
+
+	return output;
+}
+
+std::string BWT_MTF_RLE_Huffman_Coder::decodeToBWT(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, BlockLog& blockLog) const
+{
+	Workspace workspace;
+
+	return decodeToBWT(streamHeader, blockHeader, block, blockLog, workspace);
+}
+
+std::string BWT_MTF_RLE_Huffman_Coder::decodeToBWT(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, BlockLog& blockLog, Workspace& workspace) const
+{
+	const int sizeFieldSize = m_streamFormat.getSizeFieldSize(streamHeader);
+	std::string output;
+
+	StageTimer timer;
+
+	//the search index at the end of the block isn't needed for decoding
+	std::string huffmanInput;
+	if (blockHeader.m_searchIndexSize > 0) huffmanInput = block.substr(0, block.size() - blockHeader.m_searchIndexSize);
+	const std::string& coded = (blockHeader.m_searchIndexSize > 0) ? huffmanInput : block;
+
+	if (blockHeader.m_modelID != 0)
+	{
+		//a block encoded with a shared model can only be decoded with the same model, otherwise it stays empty and fails the size check
+		if (!m_model || m_model->getID() != blockHeader.m_modelID) return output;
+
+		output = m_huffmanCoder.decodeShared(coded, sizeFieldSize, m_model->getHuffmanTree());
+	}
+	else
+	{
+		output = m_huffmanCoder.decode(coded, sizeFieldSize, workspace.m_huffmanTree);
+	}
+	timer.stop(blockLog.m_stages[STAGE_HUFFMAN], output.size());
+
+	//a corrupted block could expand to a huge number of 0s, the output can't be longer than the BWT of the block
+	if (!(blockHeader.m_flags & StreamFormat::BLOCK_SKIP_RLE0))
+	{
+		output = m_RLE0Coder.decode(output, blockHeader.m_uncodedSize + sizeFieldSize);
+		timer.stop(blockLog.m_stages[STAGE_RLE0], output.size());
+	}
+
+	if (!(blockHeader.m_flags & StreamFormat::BLOCK_SKIP_MTF))
+	{
+		output = m_MTFCoder.decode(output);
+		timer.stop(blockLog.m_stages[STAGE_MTF], output.size());
+	}
+
+	return output;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::decodeBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, std::string& output, BlockLog& blockLog) const
+{
+	Workspace workspace;
+
+	return decodeBlock(streamHeader, blockHeader, block, output, blockLog, workspace);
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::decodeBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, std::string& output, BlockLog& blockLog, Workspace& workspace) const
+{
+	blockLog.m_uncodedSize = blockHeader.m_uncodedSize;
+	blockLog.m_codedSize = blockHeader.m_codedSize;
+	blockLog.m_flags = blockHeader.m_flags;
+
+	//a reference can only be resolved with the blocks in front of it
+	if (blockHeader.m_flags & StreamFormat::BLOCK_REFERENCE) return false;
+
+	if (blockHeader.m_flags & StreamFormat::BLOCK_RAW)
+	{
+		//raw blocks are just copied
+		output = block;
+	}
+	else
+	{
+		//perform all the decoding steps on the block
+		std::string bwt = decodeToBWT(streamHeader, blockHeader, block, blockLog, workspace);
+
+		StageTimer timer;
+		output = m_BWTCoder.decode(bwt, m_streamFormat.getSizeFieldSize(streamHeader));
+		timer.stop(blockLog.m_stages[STAGE_BWT], output.size());
+	}
+
+	return checkBlock(streamHeader, blockHeader, output, blockLog);
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::checkBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& output, BlockLog& blockLog) const
+{
+	if (output.size() != blockHeader.m_uncodedSize) return false;
+
+	//a corrupted block may still decode to the right size
+	if (streamHeader.m_flags & StreamFormat::FLAG_CHECKSUM)
+	{
+		StageTimer timer;
+		bool intact = CRC32C::instance().compute(output) == blockHeader.m_checksum;
+		timer.stop(blockLog.m_stages[STAGE_CHECKSUM], sizeof(blockHeader.m_checksum));
+
+		return intact;
+	}
+
+	return true;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::decodeBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, std::string& output, BlockLog& blockLog, Workspace& workspace,
+	uint64_t blockNumber, DeduplicationCache<std::string>& cache) const
+{
+	if (blockHeader.m_flags & StreamFormat::BLOCK_REFERENCE)
+	{
+		blockLog.m_uncodedSize = blockHeader.m_uncodedSize;
+		blockLog.m_codedSize = blockHeader.m_codedSize;
+		blockLog.m_flags = blockHeader.m_flags;
+
+		StageTimer timer;
+		const std::string* earlier = cache.use(decodeNumber(block), blockHeader.m_uncodedSize);
+		if (earlier == nullptr) return false;
+		output = *earlier;
+		timer.stop(blockLog.m_stages[STAGE_DEDUP], output.size());
+
+		//the checksum guards against a reference which was made for a different block with the same hash
+		return checkBlock(streamHeader, blockHeader, output, blockLog);
+	}
+
+	if (!decodeBlock(streamHeader, blockHeader, block, output, blockLog, workspace)) return false;
+
+	//only streams which may contain references pay for keeping the blocks
+	if (streamHeader.m_flags & StreamFormat::FLAG_DEDUP)
+	{
+		StageTimer timer;
+		std::vector<std::string> evicted;
+		cache.insert(blockNumber, output.size(), output, evicted);
+		timer.stop(blockLog.m_stages[STAGE_DEDUP], output.size());
+	}
+
+	return true;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setLevel(int level)
+{
+	const Preset& preset = PRESETS[std::clamp(level, MIN_LEVEL, MAX_LEVEL) - 1];
+
+	m_blockSize = preset.m_blockSize;
+	m_stageSelection = preset.m_stageSelection;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setSorter(BWTCoder::Sorter sorter)
+{
+	m_BWTCoder.setSorter(sorter);
+}
+
+BWTCoder::Sorter BWT_MTF_RLE_Huffman_Coder::getSorter() const
+{
+	return m_BWTCoder.getSorter();
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setStageSelection(bool stageSelection)
+{
+	m_stageSelection = stageSelection;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::getStageSelection() const
+{
+	return m_stageSelection;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setSearchIndex(bool searchIndex)
+{
+	m_searchIndex = searchIndex;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::getSearchIndex() const
+{
+	return m_searchIndex;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setChecksum(bool checksum)
+{
+	m_checksum = checksum;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::getChecksum() const
+{
+	return m_checksum;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setLargeBlocks(bool largeBlocks)
+{
+	m_largeBlocks = largeBlocks;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::getLargeBlocks() const
+{
+	return m_largeBlocks;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setMinBlockSize(uint64_t minBlockSize)
+{
+	m_minBlockSize = minBlockSize;
+}
+
+uint64_t BWT_MTF_RLE_Huffman_Coder::getMinBlockSize() const
+{
+	return m_minBlockSize;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setDeduplication(bool deduplication)
+{
+	m_deduplication = deduplication;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::getDeduplication() const
+{
+	return m_deduplication;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setModel(std::shared_ptr<const EntropyModel> model)
+{
+	m_model = std::move(model);
+}
+
+std::shared_ptr<const EntropyModel> BWT_MTF_RLE_Huffman_Coder::getModel() const
+{
+	return m_model;
+}
+
+void BWT_MTF_RLE_Huffman_Coder::setFlushDelay(std::chrono::milliseconds flushDelay)
+{
+	m_flushDelay = flushDelay;
+}
+
+std::chrono::milliseconds BWT_MTF_RLE_Huffman_Coder::getFlushDelay() const
+{
+	return m_flushDelay;
+}
 
 bool BWT_MTF_RLE_Huffman_Coder::encode(Log& log, std::istream& inputStream, std::ostream& outputStream) const
 {
-	std::string buffer(m_blockSize, '0'); //auxiliary buffer for reading blocks of data from input stream
-    std::string block;                    //input blocks of data will then be copied here and all other processing will be done on this string
-    
-	//initialize the log values
-    log.m_uncodedSize = 0;
-    log.m_codedSize = 0;
-    
-	//for all blocks of input data
-    do
-    {
-		//read one block of input data
-		inputStream.read(buffer.data(), m_blockSize);
-		std::streamsize count = inputStream.gcount();
-		//check for errors during reading
-        if (!inputStream && !inputStream.eof()) return false;
-		//if nothing was read, end
-		if (count == 0) break;
-		//update uncoded data size
-        log.m_uncodedSize += count;
-		//copy input block to string
-        block.assign(buffer.data(), count);
-
-		//perform all the encoding steps on the block
-        block = m_BWTCoder.encode(block); 
-        block = m_MTFCoder.encode(block);
-        block = m_RLE0Coder.encode(block);
-		block = m_huffmanCoder.encode(block);
-		//encode the size of the encoded block before the encoded block
-		block = encodeNumber(block.size(), sizeof(uint32_t)) + block;
-
-		//update the size of encoded data in the log
-        log.m_codedSize += block.size();  
-		//write encoded block to output stream
-		outputStream.write(block.c_str(), block.size());
-
-		//check for errors during writing
-        if (!outputStream) return false;
-
-    } while (!inputStream.eof()); //check for end of file
-    
-    return true;
+	Encoder encoder(*this, [&outputStream](const char* data, size_t size)
+	{
+		return static_cast<bool>(outputStream.write(data, size));
+	});
+
+	return encodeWithEncoder(log, encoder, inputStream, outputStream);
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::append(Log& log, std::istream& inputStream, std::iostream& stream) const
+{
+	StreamHeader streamHeader;          //header of the existing stream, valid for the new blocks too
+	BlockHeader endHeader;              //end of blocks of the existing stream
+	std::vector<BlockIndexEntry> index; //blocks of the existing stream
+
+	Encoder encoder(*this, [&stream](const char* data, size_t size)
+	{
+		return static_cast<bool>(stream.write(data, size));
+	});
+
+	std::streampos streamStart = stream.tellg();
+	if (streamStart == std::streampos(-1)) return false;
+
+	//an empty file gets a new stream, so that the first append doesn't need to be done differently
+	if (stream.peek() == std::char_traits<char>::eof())
+	{
+		stream.clear();
+		if (!stream.seekp(streamStart)) return false;
+
+		return encodeWithEncoder(log, encoder, inputStream, stream);
+	}
+
+	//the new blocks are added to the last of concatenated streams, the streams in front of it stay as they are
+	std::streampos lastStreamStart;
+	if (m_streamFormat.findLastStream(stream, lastStreamStart)) streamStart = lastStreamStart;
+
+	stream.clear();
+	if (!stream.seekg(streamStart) || !m_streamFormat.readIndex(stream, streamHeader, index)) return false;
+
+	//the new blocks start where the end of blocks of the existing stream is
+	uint64_t blocksEnd = StreamFormat::STREAM_HEADER_SIZE;
+	if (!index.empty())
+	{
+		blocksEnd = index.back().m_offset + m_streamFormat.getBlockHeaderSize(streamHeader) + index.back().m_codedSize;
+	}
+
+	stream.clear();
+	if (!stream.seekg(streamStart + std::streamoff(blocksEnd))) return false;
+	if (!m_streamFormat.readBlockHeader(stream, streamHeader, endHeader) || !(endHeader.m_flags & StreamFormat::BLOCK_END)) return false;
+	if (!stream.seekp(streamStart + std::streamoff(blocksEnd))) return false;
+
+	if (!encoder.resume(streamHeader, index, blocksEnd)) return false;
+
+	return encodeWithEncoder(log, encoder, inputStream, stream);
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::encodeWithEncoder(Log& log, Encoder& encoder, std::istream& inputStream, std::ostream& outputStream) const
+{
+	if (m_flushDelay.count() > 0) return encodeWithFlushDelay(log, encoder, inputStream, outputStream);
+
+	//the chunks are copied into the blocks of the encoder, a chunk smaller than a block doesn't allocate a whole block
+	std::string chunk(static_cast<size_t>(std::min(READ_CHUNK_SIZE, encoder.m_blockSize)), '\0');
+	bool success = true;
+
+	while (success && !inputStream.eof())
+	{
+		//read one chunk of input data, check for errors during reading
+		StageLog readLog;
+		StageTimer timer;
+		inputStream.read(&chunk[0], chunk.size());
+		timer.stop(readLog, inputStream.gcount());
+
+		if (!inputStream && !inputStream.eof())
+		{
+			success = false;
+			break;
+		}
+
+		encoder.addReadTime(readLog);
+		success = encoder.write(chunk.data(), static_cast<size_t>(inputStream.gcount()));
+	}
+
+	success = success && encoder.finish();
+	log = encoder.getLog();
+
+	return success;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::encodeWithFlushDelay(Log& log, Encoder& encoder, std::istream& inputStream, std::ostream& outputStream) const
+{
+	const size_t chunkSize = static_cast<size_t>(std::min(READ_CHUNK_SIZE, std::max<uint64_t>(encoder.m_blockSize / FLUSH_CHUNK_FRACTION, 1)));
+	std::string chunk(chunkSize, '\0');
+	bool success = true;
+
+	ReadAheadBuffer readAhead(inputStream.rdbuf(), chunkSize);
+
+	while (success)
+	{
+		//the oldest waiting byte decides, so that a steady trickle of data can't postpone the flush
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+		if (encoder.m_unflushed) deadline = encoder.m_unflushedSince + m_flushDelay;
+
+		if (std::chrono::steady_clock::now() >= deadline || !readAhead.waitForData(deadline))
+		{
+			success = encoder.flush() && outputStream.flush();
+			continue;
+		}
+
+		//end of input
+		std::streamsize available = readAhead.in_avail();
+		if (available < 0) break;
+
+		//only the data which has already arrived is taken, so that the loop gets back to the deadline
+		StageLog readLog;
+		StageTimer timer;
+		std::streamsize count = readAhead.sgetn(&chunk[0], std::min<std::streamsize>(available, chunkSize));
+		timer.stop(readLog, count);
+
+		encoder.addReadTime(readLog);
+		success = encoder.write(chunk.data(), static_cast<size_t>(count));
+	}
+
+	success = success && encoder.finish();
+	log = encoder.getLog();
+
+	return success;
 }
 
 bool BWT_MTF_RLE_Huffman_Coder::decode(Log& log, std::istream& inputStream, std::ostream& outputStream) const
 {
-	//auxiliary buffer for reading blocks of data from input stream
-	//maximum possible size of encoded block (without the information about block size):
-	//(UCHAR_MAX + 1) * sizeof(u_int32_t) = size of histogram
-	//sizeof(u_int32_t) = size of the value of the number of values encoded by Huffman
-	//+ size of BWT index and size of uncoded block
-	std::string buffer(((UCHAR_MAX + 1) * sizeof(uint32_t)) + sizeof(uint32_t) + BWTCoder::INDEX_SIZE + m_blockSize, '0');
-    std::string block;           //input blocks of data will then be copied here and all other processing will be done on this string
-	std::string blockSizeString; //size of encoded block will be in here
-    
+	bool unflushed = false; //decoded data has been written since the last flush
+
+	Decoder decoder(*this, [&outputStream, &unflushed](const char* data, size_t size)
+	{
+		unflushed = true;
+		return static_cast<bool>(outputStream.write(data, size));
+	});
+
+	std::string chunk; //read data, grows up to READ_CHUNK_SIZE
+
+	//only the bytes which the decoder still expects are read, after a footer the header of another stream may follow
+	while (true)
+	{
+		chunk.resize(static_cast<size_t>(std::min(READ_CHUNK_SIZE, decoder.m_neededSize - decoder.m_buffer.size())));
+
+		StageLog readLog;
+		StageTimer timer;
+		inputStream.read(&chunk[0], chunk.size());
+		timer.stop(readLog, inputStream.gcount());
+
+		decoder.addReadTime(readLog);
+		if (!decoder.write(chunk.data(), static_cast<size_t>(inputStream.gcount())) || !inputStream) break;
+
+		//the next read would wait for the input, so the decoded blocks are passed on first,
+		//e.g. when the encoder writes blocks as they are flushed, the output follows them instead of waiting for the end of the input
+		if (unflushed && inputStream.rdbuf()->in_avail() <= 0)
+		{
+			unflushed = false;
+			if (!outputStream.flush()) break;
+		}
+	}
+
+	log = decoder.getLog();
+
+	return decoder.finish() && static_cast<bool>(outputStream);
+}
+
+uint64_t BWT_MTF_RLE_Huffman_Coder::writeRange(std::ostream& outputStream, const std::string& block, uint64_t blockOffset, uint64_t offset, uint64_t length) const
+{
+	//trim the block to the range
+	uint64_t first = std::max(offset, blockOffset) - blockOffset;
+	uint64_t last = std::min(offset + length, blockOffset + block.size()) - blockOffset;
+
+	if (first >= last) return 0;
+
+	outputStream.write(block.data() + first, last - first);
+
+	return last - first;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::decodeRange(Log& log, std::istream& inputStream, std::ostream& outputStream, uint64_t offset, uint64_t length) const
+{
+	StreamHeader streamHeader;          //describes the encoded stream
+	BlockHeader blockHeader;            //describes the current block
+	std::vector<BlockIndexEntry> index; //block index of the stream
+	std::string block;                  //encoded blocks are read here
+	std::string output;                 //decoded blocks are saved here
+
 	//initialize the log values
-    log.m_uncodedSize = 0;
-    log.m_codedSize = 0;
+	log.m_uncodedSize = 0;
+	log.m_codedSize = 0;
+	log.m_blocks.clear();
+
+	//the end of the range, saturated so that the range can't wrap around
+	length = std::min(length, UINT64_MAX - offset);
+	const uint64_t rangeEnd = offset + length;
+
+	std::streampos streamStart = inputStream.tellg();
+
+	//seekable input, jump directly to the blocks which overlap the range
+	if (streamStart != std::streampos(-1) && m_streamFormat.readIndex(inputStream, streamHeader, index))
+	{
+		//first block which ends after the beginning of the range
+		auto it = std::upper_bound(index.begin(), index.end(), offset, [](uint64_t value, const BlockIndexEntry& entry)
+		{
+			return value < entry.m_uncodedOffset + entry.m_uncodedSize;
+		});
+
+		//reads the block at the given entry of the index
+		auto readBlock = [&](const BlockIndexEntry& entry, BlockHeader& header)
+		{
+			inputStream.clear();
+			if (!inputStream.seekg(streamStart + std::streamoff(entry.m_offset))) return false;
+
+			if (!m_streamFormat.readBlockHeader(inputStream, streamHeader, header)) return false;
+			if (header.m_flags & StreamFormat::BLOCK_END) return false;
+			if (header.m_codedSize > getMaxCodedBlockSize(streamHeader, header.m_uncodedSize)) return false;
+			if (!m_streamFormat.readBytes(inputStream, block, header.m_codedSize)) return false;
+			log.m_codedSize += m_streamFormat.getBlockHeaderSize(streamHeader) + header.m_codedSize;
+
+			return true;
+		};
+
+		for (; it != index.end() && it->m_uncodedOffset < rangeEnd; ++it)
+		{
+			if (!readBlock(*it, blockHeader)) return false;
+
+			BlockLog blockLog;
+			if (blockHeader.m_flags & StreamFormat::BLOCK_REFERENCE)
+			{
+				//the repeated block is found by the index instead of decoding the blocks in front of it
+				const uint64_t blockNumber = decodeNumber(block);
+				if (blockNumber >= static_cast<uint64_t>(it - index.begin())) return false;
+
+				BlockHeader earlierHeader;
+				if (!readBlock(index[blockNumber], earlierHeader)) return false;
+				if (!decodeBlock(streamHeader, earlierHeader, block, output, blockLog)) return false;
+
+				//the time of decoding the repeated block is kept, the sizes are those of the reference
+				blockLog.m_uncodedSize = blockHeader.m_uncodedSize;
+				blockLog.m_codedSize = blockHeader.m_codedSize;
+				blockLog.m_flags = blockHeader.m_flags;
+				if (!checkBlock(streamHeader, blockHeader, output, blockLog)) return false;
+			}
+			else
+			{
+				if (!decodeBlock(streamHeader, blockHeader, block, output, blockLog)) return false;
+			}
+			log.m_blocks.push_back(blockLog);
+
+			log.m_uncodedSize += writeRange(outputStream, output, it->m_uncodedOffset, offset, length);
+			if (!outputStream) return false;
+		}
+
+		return true;
+	}
+
+	//input isn't seekable or the index couldn't be read, read it sequentially and decode only the blocks which overlap the range
+	inputStream.clear();
+	if (streamStart != std::streampos(-1)) inputStream.seekg(streamStart);
+	if (!m_streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+	log.m_codedSize += StreamFormat::STREAM_HEADER_SIZE;
+
+	uint64_t blockOffset = 0; //position of the first byte of the current block in the uncoded data
+	uint64_t blockNumber = 0; //number of the current block in its stream
+	Workspace workspace;
+	DeduplicationCache<std::string> cache(StreamFormat::DEDUP_WINDOW);
+
+	while (blockOffset < rangeEnd)
+	{
+		if (!m_streamFormat.readBlockHeader(inputStream, streamHeader, blockHeader)) return false;
+		log.m_codedSize += m_streamFormat.getBlockHeaderSize(streamHeader);
+
+		//the uncoded data of a stream which follows continues that of this one
+		if (blockHeader.m_flags & StreamFormat::BLOCK_END)
+		{
+			bool next = false;
+			if (!readNextStream(log, inputStream, streamHeader, next)) return false;
+			if (!next) break;
+			blockNumber = 0;
+			cache.clear();
+			continue;
+		}
+
+		if (blockHeader.m_codedSize > getMaxCodedBlockSize(streamHeader, blockHeader.m_uncodedSize)) return false;
+
+		//the block ends before the range, skip it, unless a reference in the range may repeat it
+		if (blockOffset + blockHeader.m_uncodedSize <= offset && !(streamHeader.m_flags & StreamFormat::FLAG_DEDUP))
+		{
+			inputStream.ignore(blockHeader.m_codedSize);
+			if (inputStream.gcount() != static_cast<std::streamsize>(blockHeader.m_codedSize)) return false;
+		}
+		else
+		{
+			if (!m_streamFormat.readBytes(inputStream, block, blockHeader.m_codedSize)) return false;
+			BlockLog blockLog;
+			if (!decodeBlock(streamHeader, blockHeader, block, output, blockLog, workspace, blockNumber, cache)) return false;
+			log.m_blocks.push_back(blockLog);
+
+			log.m_uncodedSize += writeRange(outputStream, output, blockOffset, offset, length);
+			if (!outputStream) return false;
+		}
+
+		log.m_codedSize += blockHeader.m_codedSize;
+		blockOffset += blockHeader.m_uncodedSize;
+		blockNumber++;
+	}
+
+	return true;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::readNextStream(Log& log, std::istream& inputStream, StreamHeader& streamHeader, bool& next) const
+{
+	std::vector<BlockIndexEntry> index;
+	if (!m_streamFormat.readFooter(inputStream, index)) return false;
+	log.m_codedSize += sizeof(uint64_t) + index.size() * StreamFormat::INDEX_ENTRY_SIZE + StreamFormat::FOOTER_TRAILER_SIZE;
+
+	next = inputStream.peek() != std::char_traits<char>::eof();
+	if (!next) return true;
+
+	if (!m_streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+	log.m_codedSize += StreamFormat::STREAM_HEADER_SIZE;
+
+	return true;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::verify(Log& log, std::istream& inputStream) const
+{
+	//initialize the log values
+	log.m_uncodedSize = 0;
+	log.m_codedSize = 0;
+	log.m_blockSize = 0;
+	log.m_threadCount = 0;
+	log.m_blocks.clear();
+	log.m_memoryBudget = m_memoryBudget;
+
+	//streams written one after another are checked one by one
+	do
+	{
+		if (!verifyStream(log, inputStream)) return false;
+	}
+	while (inputStream.peek() != std::char_traits<char>::eof());
+
+	return true;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::verifyStream(Log& log, std::istream& inputStream) const
+{
+	StreamHeader streamHeader;          //describes the encoded stream
+	std::vector<BlockIndexEntry> index; //block index from the footer
+
+	if (!m_streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+	log.m_codedSize += StreamFormat::STREAM_HEADER_SIZE;
+
+	//the block size is given by the stream, so only the number of blocks decoded in parallel can fit the memory budget
+	uint64_t budget = getBlockMemoryBudget();
+	unsigned threadCount = m_threadCount;
+	while (budget > 0 && threadCount > 1 && threadCount * DECODE_MEMORY_PER_BYTE * streamHeader.m_blockSize > budget)
+	{
+		threadCount--;
+	}
+	log.m_blockSize = std::max(log.m_blockSize, streamHeader.m_blockSize);
+	log.m_threadCount = std::max(log.m_threadCount, threadCount);
+
+	//blocks are read in batches, so that all threads have work while the number of blocks in memory stays bounded
+	const size_t batchSize = 2 * threadCount;
+	std::vector<BlockHeader> blockHeaders(batchSize);
+	std::vector<std::string> blocks(batchSize);
+	std::vector<BlockLog> blockLogs(batchSize);
+	std::vector<std::future<bool>> results;
+
+	//references are checked in order against the checksums of the blocks they can reach, without copying the blocks
+	DeduplicationCache<uint32_t> cache(StreamFormat::DEDUP_WINDOW);
+	std::vector<uint32_t> evicted;
+	uint64_t blockNumber = 0;
+
+	//declared last, so that on early return it finishes the running tasks before their buffers are destroyed
+	ThreadPool threadPool(threadCount);
+
+	bool end = false;
+	while (!end)
+	{
+		results.clear();
+
+		for (size_t i = 0; i < batchSize; ++i)
+		{
+			if (!m_streamFormat.readBlockHeader(inputStream, streamHeader, blockHeaders[i])) return false;
+			log.m_codedSize += m_streamFormat.getBlockHeaderSize(streamHeader);
+
+			if (blockHeaders[i].m_flags & StreamFormat::BLOCK_END)
+			{
+				end = true;
+				break;
+			}
+
+			if (blockHeaders[i].m_codedSize > getMaxCodedBlockSize(streamHeader, blockHeaders[i].m_uncodedSize)) return false;
+			StageTimer timer;
+			blockLogs[i] = BlockLog();
+			if (!m_streamFormat.readBytes(inputStream, blocks[i], blockHeaders[i].m_codedSize)) return false;
+			timer.stop(blockLogs[i].m_stages[STAGE_IO], blocks[i].size());
+			log.m_codedSize += blockHeaders[i].m_codedSize;
+
+			if (blockHeaders[i].m_flags & StreamFormat::BLOCK_REFERENCE)
+			{
+				blockLogs[i].m_uncodedSize = blockHeaders[i].m_uncodedSize;
+				blockLogs[i].m_codedSize = blockHeaders[i].m_codedSize;
+				blockLogs[i].m_flags = blockHeaders[i].m_flags;
+
+				//the repeated block is checked by its own task
+				StageTimer dedupTimer;
+				const uint32_t* checksum = cache.use(decodeNumber(blocks[i]), blockHeaders[i].m_uncodedSize);
+				bool intact = checksum != nullptr && *checksum == blockHeaders[i].m_checksum;
+				dedupTimer.stop(blockLogs[i].m_stages[STAGE_DEDUP], 0);
+
+				std::promise<bool> result;
+				result.set_value(intact);
+				results.push_back(result.get_future());
+				blockNumber++;
+				continue;
+			}
+
+			if (streamHeader.m_flags & StreamFormat::FLAG_DEDUP)
+			{
+				cache.insert(blockNumber, blockHeaders[i].m_uncodedSize, blockHeaders[i].m_checksum, evicted);
+				evicted.clear();
+			}
+			blockNumber++;
+
+			results.push_back(threadPool.submit([this, &streamHeader, &blockHeader = blockHeaders[i], &block = blocks[i], &blockLog = blockLogs[i]]()
+			{
+				std::string output;
+				return decodeBlock(streamHeader, blockHeader, block, output, blockLog);
+			}));
+		}
+
+		//wait for the whole batch before its buffers are reused
+		bool intact = true;
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			intact = results[i].get() && intact;
+			log.m_uncodedSize += blockHeaders[i].m_uncodedSize;
+			log.m_blocks.push_back(blockLogs[i]);
+		}
+
+		if (!intact) return false;
+	}
+
+	if (!m_streamFormat.readFooter(inputStream, index)) return false;
+	log.m_codedSize += sizeof(uint64_t) + index.size() * StreamFormat::INDEX_ENTRY_SIZE + StreamFormat::FOOTER_TRAILER_SIZE;
+
+	return true;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::search(Log& log, std::istream& inputStream, const std::string& pattern, std::vector<uint64_t>& positions) const
+{
+	StreamHeader streamHeader; //describes the encoded stream
+	BlockHeader blockHeader;   //describes the current block
+	std::string block;         //encoded blocks are read here
+	FMIndex index;             //index of the current block
+
+	//initialize the log values
+	log.m_uncodedSize = 0;
+	log.m_codedSize = 0;
+	log.m_blocks.clear();
+
+	positions.clear();
+
+	if (pattern.empty()) return false;
+
+	//read the stream header, the stream must have been encoded with the search index
+	if (!m_streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+	if (!(streamHeader.m_flags & StreamFormat::FLAG_SEARCH_INDEX)) return false;
+	log.m_codedSize += StreamFormat::STREAM_HEADER_SIZE;
+
+	uint64_t blockOffset = 0; //position of the first byte of the current block in the uncoded data
+	uint64_t blockNumber = 0; //number of the current block in its stream
+
+	//positions of the occurences in the blocks which references can reach, relative to the beginning of the block
+	DeduplicationCache<std::vector<uint64_t>> cache(StreamFormat::DEDUP_WINDOW);
+	std::vector<std::vector<uint64_t>> evicted;
 
 	//for all blocks of input data
-    do
-    {
-		//read the size of encoded block 
-		inputStream.read(buffer.data(), sizeof(uint32_t));
-		std::streamsize count = inputStream.gcount();
-		//check for errors during reading
-        if (!inputStream) return false;
-		//if nothing was read, end
-		if (count == 0) break;
-		//update encoded data size
-        log.m_codedSize += count;
-		//copy size of encoded block to string
-		blockSizeString.assign(buffer.data(), count);
-		//decode size of encoded block
-		uint64_t blockSize = decodeNumber(blockSizeString);
-
-		//read the encoded block
-		inputStream.read(buffer.data(), blockSize);
-		count = inputStream.gcount();
-		//check for errors during reading
-		if (!inputStream || count == 0) return false;
-		//update encoded data size
-		log.m_codedSize += count;
-		//copy encoded block to string
-		block.assign(buffer.data(), count);
+	while (true)
+	{
+		if (!m_streamFormat.readBlockHeader(inputStream, streamHeader, blockHeader)) return false;
+		log.m_codedSize += m_streamFormat.getBlockHeaderSize(streamHeader);
 
-		//perform all the decoding steps on the block
-		block = m_huffmanCoder.decode(block);
-        block = m_RLE0Coder.decode(block);
-        block = m_MTFCoder.decode(block);
-        block = m_BWTCoder.decode(block);
-
-		//update decoded data size
-        log.m_uncodedSize += block.size();   
-		//write decoded block to output stream
-		outputStream.write(block.c_str(), block.size());
-
-		//check for errors during writing
-        if (!outputStream) return false;
-
-    } while (!inputStream.eof()); //check for end of file
-	
-    return true;
-}
\ No newline at end of file
+		//the positions in a stream which follows continue those of this one, it must have been encoded with the search index too
+		if (blockHeader.m_flags & StreamFormat::BLOCK_END)
+		{
+			bool next = false;
+			if (!readNextStream(log, inputStream, streamHeader, next)) return false;
+			if (!next) break;
+			if (!(streamHeader.m_flags & StreamFormat::FLAG_SEARCH_INDEX)) return false;
+			blockNumber = 0;
+			cache.clear();
+			continue;
+		}
+
+		if (blockHeader.m_codedSize > getMaxCodedBlockSize(streamHeader, blockHeader.m_uncodedSize)) return false;
+		if (!m_streamFormat.readBytes(inputStream, block, blockHeader.m_codedSize)) return false;
+		log.m_codedSize += blockHeader.m_codedSize;
+
+		BlockLog blockLog;
+		blockLog.m_uncodedSize = blockHeader.m_uncodedSize;
+		blockLog.m_codedSize = blockHeader.m_codedSize;
+		blockLog.m_flags = blockHeader.m_flags;
+
+		const size_t firstPosition = positions.size(); //the positions in the block are added after this one
+
+		if (blockHeader.m_flags & StreamFormat::BLOCK_REFERENCE)
+		{
+			//a repeated block has the same occurences
+			StageTimer timer;
+			const std::vector<uint64_t>* blockPositions = cache.use(decodeNumber(block), blockHeader.m_uncodedSize);
+			if (blockPositions == nullptr) return false;
+
+			for (uint64_t position : *blockPositions)
+			{
+				positions.push_back(blockOffset + position);
+			}
+			timer.stop(blockLog.m_stages[STAGE_DEDUP], blockPositions->size() * sizeof(uint64_t));
+		}
+		else if (blockHeader.m_flags & StreamFormat::BLOCK_RAW)
+		{
+			//raw blocks have no index, but they can be searched directly
+			for (size_t position = block.find(pattern); position != std::string::npos; position = block.find(pattern, position + 1))
+			{
+				positions.push_back(blockOffset + position);
+			}
+		}
+		else
+		{
+			//the inverse BWT is skipped, the search runs directly over the BWT of the block
+			std::string bwt = decodeToBWT(streamHeader, blockHeader, block, blockLog);
+			if (bwt.size() != blockHeader.m_uncodedSize + BWTCoder::INDEX_SIZE) return false;
+
+			StageTimer timer;
+			if (!index.load(bwt, block.substr(block.size() - blockHeader.m_searchIndexSize))) return false;
+
+			std::vector<uint32_t> blockPositions = index.locate(pattern);
+			for (uint32_t position : blockPositions)
+			{
+				positions.push_back(blockOffset + position);
+			}
+			timer.stop(blockLog.m_stages[STAGE_SEARCH_INDEX], blockPositions.size() * sizeof(uint64_t));
+		}
+
+		if ((streamHeader.m_flags & StreamFormat::FLAG_DEDUP) && !(blockHeader.m_flags & StreamFormat::BLOCK_REFERENCE))
+		{
+			std::vector<uint64_t> blockPositions;
+			for (size_t i = firstPosition; i < positions.size(); ++i)
+			{
+				blockPositions.push_back(positions[i] - blockOffset);
+			}
+
+			cache.insert(blockNumber, blockHeader.m_uncodedSize, std::move(blockPositions), evicted);
+			evicted.clear();
+		}
+		blockNumber++;
+
+		log.m_blocks.push_back(blockLog);
+
+		log.m_uncodedSize += blockHeader.m_uncodedSize;
+		blockOffset += blockHeader.m_uncodedSize;
+	}
+
+	return true;
+}
+
+bool BWT_MTF_RLE_Huffman_Coder::train(Log& log, std::istream& inputStream, EntropyModel& model) const
+{
+	uint64_t blockSize = 0;
+	unsigned threadCount = 0;
+	BWTCoder::Sorter sorter = BWTCoder::Sorter::INDUCED_SORTING;
+	fitEncodeBudget(blockSize, threadCount, sorter);
+	const int sizeFieldSize = m_streamFormat.getSizeFieldSize(getStreamHeader(blockSize));
+
+	//initialize the log values
+	log.m_uncodedSize = 0;
+	log.m_codedSize = 0;
+	log.m_blocks.clear();
+	log.m_blockSize = blockSize;
+	log.m_threadCount = 1;
+	log.m_memoryBudget = m_memoryBudget;
+
+	std::array<uint64_t, UCHAR_MAX + 1> histogram = {}; //input of the Huffman stage counted over all blocks
+	std::string block;
+	uint64_t sampledBlocks = 0;
+
+	while (true)
+	{
+		BlockLog blockLog;
+		StageTimer timer;
+
+		block.resize(blockSize);
+		inputStream.read(block.data(), blockSize);
+		block.resize(inputStream.gcount());
+		if (inputStream.bad()) return false;
+		if (block.empty()) break;
+
+		timer.stop(blockLog.m_stages[STAGE_IO], block.size());
+		log.m_uncodedSize += block.size();
+		blockLog.m_uncodedSize = block.size();
+
+		//incompressible blocks are stored raw, they never reach the Huffman stage
+		bool incompressible = isIncompressible(block);
+		timer.stop(blockLog.m_stages[STAGE_ANALYSIS]);
+
+		if (!incompressible)
+		{
+			std::string output = m_BWTCoder.encode(block, sizeFieldSize, sorter);
+			timer.stop(blockLog.m_stages[STAGE_BWT], output.size());
+
+			output = m_MTFCoder.encode(output);
+			timer.stop(blockLog.m_stages[STAGE_MTF], output.size());
+
+			output = m_RLE0Coder.encode(output);
+			timer.stop(blockLog.m_stages[STAGE_RLE0], output.size());
+
+			for (unsigned char ch : output)
+			{
+				histogram[ch]++;
+			}
+			timer.stop(blockLog.m_stages[STAGE_HUFFMAN]);
+
+			sampledBlocks++;
+		}
+
+		log.m_blocks.push_back(blockLog);
+
+		if (inputStream.eof()) break;
+	}
+
+	if (sampledBlocks == 0) return false;
+
+	model.build(histogram);
+	log.m_codedSize = EntropyModel::FILE_SIZE;
+
+	return true;
+}
@@ -1,13 +1,21 @@
 
 #pragma once
 
+#include <chrono>
 #include <fstream>
+#include <memory>
 
 #include "StreamCoder.h"
+#include "DeduplicationCache.h"
+#include "EntropyModel.h"
 #include "HuffmanCoder.h"
 #include "BWTCoder.h"
+#include "FMIndex.h"
 #include "MTFCoder.h"
 #include "RLE0Coder.h"
+#include "StreamFormat.h"
+
+class Encoder;
 
 /**
 *   Encoder/Decoder which uses a combination of other coders/decoders:
@@ -16,17 +24,414 @@
 */
 class BWT_MTF_RLE_Huffman_Coder : public StreamCoder
 {
+public:
+
+	/**
+	*   parameters of the encoder chosen by a compression level
+	*/
+	struct Preset
+	{
+		uint64_t m_blockSize;  //!< maximum number of bytes in a single block
+		bool m_stageSelection; //!< whether MTF and RLE are skipped for blocks where they don't pay off
+	};
+
+	static constexpr int MIN_LEVEL = 1;     //!< fastest compression level
+	static constexpr int MAX_LEVEL = 9;     //!< compression level with the best ratio
+	static constexpr int DEFAULT_LEVEL = 5; //!< compression level used if none is set
+
+	static const Preset PRESETS[MAX_LEVEL]; //!< parameters of all compression levels, PRESETS[level - 1]
+
 private:
 
+	//the streaming classes drive the encoding and decoding of single blocks
+	friend class ArchiveCoder;
+	friend class Encoder;
+	friend class Decoder;
+	friend class BatchCoder;
+
+	/**
+	*   memory kept by a thread between the blocks it encodes or decodes, so that small blocks don't pay for setting it up again
+	*/
+	struct Workspace
+	{
+		HuffmanTree m_huffmanTree; //!< tree of the Huffman stage, rebuilt for every block
+	};
+
 	HuffmanCoder m_huffmanCoder;
 	BWTCoder m_BWTCoder;
 	MTFCoder m_MTFCoder;
 	RLE0Coder m_RLE0Coder;
+	StreamFormat m_streamFormat;
+	FMIndex m_FMIndex;
+
+	bool m_searchIndex = false;   //!< whether an FM-index for substring search is stored with every block
+	bool m_checksum = true;       //!< whether a checksum of the uncoded data is stored with every block
+	bool m_stageSelection = true; //!< whether MTF and RLE are skipped for blocks where they don't pay off
+	bool m_largeBlocks = false;   //!< whether 64-bit sizes are stored even if the block size doesn't need them
+	bool m_deduplication = false; //!< whether blocks identical to an earlier block are stored as references to it
+	uint64_t m_minBlockSize = 0;  //!< minimum size of a block ended early by BlockSplitter, 0 for blocks of fixed size
+	std::chrono::milliseconds m_flushDelay{ 0 }; //!< maximum time the encoded data may lag behind the input, 0 to flush only full blocks
+	std::shared_ptr<const EntropyModel> m_model; //!< shared entropy model of the Huffman stage, nullptr if every block stores its own histogram
+
+	static constexpr uint64_t READ_CHUNK_SIZE = 1 << 20; //!< number of bytes read from the input stream at once
+	static constexpr uint64_t FLUSH_CHUNK_FRACTION = 16; //!< a chunk read ahead when encoding with a flush delay takes at most this fraction of a block, so that the chunks fit into the memory estimate
+
+	static constexpr uint64_t BASE_MEMORY = 1 << 18;           //!< part of the memory budget reserved for the buffers of the streams, tables of the coders and the log
+	static constexpr uint64_t STAGE_MEMORY_PER_BYTE = 8;        //!< estimated bytes of memory per byte of a block being encoded apart from its sorter, including the blocks waiting in its batch
+	static constexpr uint64_t SORTER_MEMORY_PER_BYTE = 8;       //!< bytes of memory per byte of a block taken by the two arrays of 32-bit indices of prefix doubling or Merge Sort
+	static constexpr uint64_t INDUCED_SORTER_MEMORY_PER_BYTE = 7; //!< bytes of memory per byte of a block sorted by induced sorting with 32-bit indices, 4 for the indices and at most 3 for the reduced texts
+	static constexpr uint64_t LARGE_SORTER_MEMORY_PER_BYTE = 8; //!< bytes of memory per byte of a block sorted by induced sorting with 40-bit indices, 5 for the indices and at most 3 for the reduced texts
+	static constexpr uint64_t DECODE_MEMORY_PER_BYTE = 10;     //!< estimated bytes of memory per byte of a block being decoded, including the blocks waiting in its batch
+	static constexpr uint64_t MIN_BUDGET_BLOCK_SIZE = 4096;    //!< block size below which the memory budget doesn't shrink the blocks
+
+	/**
+	*   \brief Returns the part of the memory budget left for the blocks being processed
+	*   \return number of bytes, 0 if there is no memory budget
+	*/
+	uint64_t getBlockMemoryBudget() const;
+
+	/**
+	*   \brief Estimates the memory needed for encoding a single block
+	*   \param blockSize number of bytes of the block
+	*   \param sorter algorithm sorting the permutations of the block
+	*   \return estimated number of bytes
+	*/
+	static uint64_t getEncodeMemory(uint64_t blockSize, BWTCoder::Sorter sorter);
+
+	/**
+	*   \brief Chooses the sorter, the number of threads and the block size of encoding so that the estimated memory fits into the memory budget
+	*   The set sorter is replaced by induced sorting first, which needs less memory and gives the same output,
+	*   then the number of threads and then the block size are lowered. BASE_MEMORY is subtracted from the budget first.
+	*   Neither goes below 1 thread and MIN_BUDGET_BLOCK_SIZE, so a tiny budget may be exceeded
+	*   \param blockSize block size to use gets saved here
+	*   \param threadCount number of threads to use gets saved here
+	*   \param sorter sorter to use gets saved here
+	*/
+	void fitEncodeBudget(uint64_t& blockSize, unsigned& threadCount, BWTCoder::Sorter& sorter) const;
+
+	/**
+	*   \brief Creates the header of a stream encoded with the current parameters
+	*   \param blockSize block size which is used, may be smaller than the set one because of the memory budget
+	*   \return header of the stream
+	*/
+	StreamHeader getStreamHeader(uint64_t blockSize) const;
+
+	/**
+	*   \brief Returns the maximum size of a block after encoding
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param uncodedSize size of the block before encoding
+	*   \return maximum size of the block after encoding, including its search index
+	*/
+	uint64_t getMaxCodedBlockSize(const StreamHeader& streamHeader, uint64_t uncodedSize) const;
+
+	static constexpr size_t ENTROPY_SAMPLE_SIZE = 65536;      //!< maximum number of bytes of a block sampled when estimating its compressibility
+	static constexpr size_t ENTROPY_SAMPLE_CHUNK = 4096;      //!< number of consecutive bytes in a single sample
+	static constexpr double INCOMPRESSIBLE_ENTROPY = 7.9;     //!< order-0 entropy in bits per byte above which a block may be incompressible
+	static constexpr double INCOMPRESSIBLE_PAIR_RATIO = 0.9;  //!< ratio of distinct pairs of bytes to random data above which a block is incompressible
+
+	/**
+	*   \brief Estimates whether a block is incompressible from a sample of the block
+	*   The sample must have both a high order-0 entropy and about as many distinct pairs of neighbouring bytes as random data,
+	*   so that data such as periodic sequences of all byte values, which BWT compresses well, isn't stored raw
+	*   \param block block of data (uncoded)
+	*   \return true if encoding the block isn't worth trying
+	*/
+	bool isIncompressible(const std::string& block) const;
+
+	/**
+	*   \brief Computes the order-0 entropy of data
+	*   \param data input data
+	*   \return entropy in bits per byte
+	*/
+	static double getEntropy(const std::string& data);
+
+	/**
+	*   \brief Counts the runs of 0s which RLE encodes and the special symbols which RLE has to escape
+	*   \param data input of RLE
+	*   \param zeroRuns number of encoded runs of 0s gets saved here
+	*   \param escapes number of escaped special symbols gets saved here
+	*   \return estimated change of the size of the data after RLE in bytes, negative if RLE makes the data shorter
+	*/
+	static int64_t estimateRLE0(const std::string& data, uint64_t& zeroRuns, uint64_t& escapes);
+
+	/**
+	*   \brief Encodes a single block using this sequence of encoders: BWT -> MTF -> RLE -> Huffman
+	*   With stage selection, MTF is skipped if it doesn't lower the entropy of the BWT output and RLE is skipped
+	*   if it doesn't make its input shorter, blocks which are incompressible or grow during encoding are stored raw instead
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param sorter algorithm sorting the permutations of the block, chosen by fitEncodeBudget
+	*   \param block block of data (uncoded)
+	*   \param blockHeader header describing the encoded block gets saved here
+	*   \param blockLog statistics of the block and the decisions made for it get saved here
+	*   \return encoded block, followed by its search index if the stream has one
+	*/
+	std::string encodeBlock(const StreamHeader& streamHeader, BWTCoder::Sorter sorter, const std::string& block, BlockHeader& blockHeader, BlockLog& blockLog) const;
+
+	/**
+	*   \brief Encodes a single block like encodeBlock, reusing the memory of the workspace
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param sorter algorithm sorting the permutations of the block, chosen by fitEncodeBudget
+	*   \param block block of data (uncoded)
+	*   \param blockHeader header describing the encoded block gets saved here
+	*   \param blockLog statistics of the block and the decisions made for it get saved here
+	*   \param workspace workspace of the calling thread
+	*   \return encoded block, followed by its search index if the stream has one
+	*/
+	std::string encodeBlock(const StreamHeader& streamHeader, BWTCoder::Sorter sorter, const std::string& block, BlockHeader& blockHeader, BlockLog& blockLog, Workspace& workspace) const;
+
+	/**
+	*   \brief Decodes a single block up to the BWT stage using this sequence of decoders: Huffman -> RLE -> MTF
+	*   The stages which were skipped during encoding are skipped
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader header of the block
+	*   \param block block of data (encoded)
+	*   \param blockLog time and output size of the stages get added here
+	*   \return output of BWTCoder::encode for the block
+	*/
+	std::string decodeToBWT(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, BlockLog& blockLog) const;
+
+	/**
+	*   \brief Decodes a single block up to the BWT stage like decodeToBWT, reusing the memory of the workspace
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader header of the block
+	*   \param block block of data (encoded)
+	*   \param blockLog time and output size of the stages get added here
+	*   \param workspace workspace of the calling thread
+	*   \return output of BWTCoder::encode for the block
+	*/
+	std::string decodeToBWT(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, BlockLog& blockLog, Workspace& workspace) const;
+
+	/**
+	*   \brief Decodes a single block using this sequence of decoders: Huffman -> RLE -> MTF -> BWT
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader header of the block
+	*   \param block block of data (encoded)
+	*   \param output decoded block gets saved here
+	*   \param blockLog sizes, flags and time of the stages of the block get saved here
+	*   \return true on success, false if the block couldn't be decoded, has the BLOCK_REFERENCE flag or doesn't match its size or checksum
+	*/
+	bool decodeBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, std::string& output, BlockLog& blockLog) const;
+
+	/**
+	*   \brief Decodes a single block like decodeBlock, reusing the memory of the workspace
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader header of the block
+	*   \param block block of data (encoded)
+	*   \param output decoded block gets saved here
+	*   \param blockLog sizes, flags and time of the stages of the block get saved here
+	*   \param workspace workspace of the calling thread
+	*   \return true on success, false if the block couldn't be decoded, has the BLOCK_REFERENCE flag or doesn't match its size or checksum
+	*/
+	bool decodeBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, std::string& output, BlockLog& blockLog, Workspace& workspace) const;
+
+	/**
+	*   \brief Checks the size and the checksum of a decoded block against its header
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader header of the block
+	*   \param output decoded block
+	*   \param blockLog time of computing the checksum gets saved here
+	*   \return true if the block matches its size and checksum
+	*/
+	bool checkBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& output, BlockLog& blockLog) const;
+
+	/**
+	*   \brief Decodes a single block like decodeBlock, a block with the BLOCK_REFERENCE flag is copied from the cache
+	*   In a stream with FLAG_DEDUP every other block is added to the cache, so the blocks of a stream must be decoded in order
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader header of the block
+	*   \param block block of data (encoded)
+	*   \param output decoded block gets saved here
+	*   \param blockLog sizes, flags and time of the stages of the block get saved here
+	*   \param workspace workspace of the calling thread
+	*   \param blockNumber number of the block in its stream
+	*   \param cache decoded blocks of the stream which references can reach, cleared at the beginning of every stream
+	*   \return true on success, false if the block couldn't be decoded, refers to a block which isn't in the cache or doesn't match its size or checksum
+	*/
+	bool decodeBlock(const StreamHeader& streamHeader, const BlockHeader& blockHeader, const std::string& block, std::string& output, BlockLog& blockLog, Workspace& workspace,
+		uint64_t blockNumber, DeduplicationCache<std::string>& cache) const;
+
+	/**
+	*   \brief Reads the input stream in chunks and gives them to the encoder, with a flush delay like encodeWithFlushDelay
+	*   \param log log of the encoding process gets saved here
+	*   \param encoder encoder which passes the encoded stream to the output stream
+	*   \param inputStream input stream (uncoded)
+	*   \param outputStream output stream (encoded), only flushed
+	*   \return true on success, false on error
+	*/
+	bool encodeWithEncoder(Log& log, Encoder& encoder, std::istream& inputStream, std::ostream& outputStream) const;
+
+	/**
+	*   \brief Encodes the input stream like encode, but writes out and flushes the current block once its oldest byte has waited for the flush delay
+	*   The input is read ahead in a background thread, so that waiting for it can time out
+	*   \param log log of the encoding process gets saved here, including the latency of every flush
+	*   \param encoder encoder which passes the encoded stream to the output stream
+	*   \param inputStream input stream (uncoded)
+	*   \param outputStream output stream (encoded), flushed after every flush of the encoder
+	*   \return true on success, false on error
+	*/
+	bool encodeWithFlushDelay(Log& log, Encoder& encoder, std::istream& inputStream, std::ostream& outputStream) const;
+
+	/**
+	*   \brief Reads the footer of a stream and the header of the stream which follows it, if there is one
+	*   \param log the sizes of the footer and the header get added to its coded size
+	*   \param inputStream stream positioned right after the block header with the BLOCK_END flag
+	*   \param streamHeader header of the next stream gets saved here
+	*   \param next set to true if another stream follows the footer, false if the input ends with it
+	*   \return true on success, false if the footer or the header of the next stream isn't valid
+	*/
+	bool readNextStream(Log& log, std::istream& inputStream, StreamHeader& streamHeader, bool& next) const;
+
+	/**
+	*   \brief Checks a single stream like verify
+	*   \param log sizes and blocks of the stream get added to it
+	*   \param inputStream stream positioned at the beginning of the stream header
+	*   \return true if all blocks are intact, false otherwise
+	*/
+	bool verifyStream(Log& log, std::istream& inputStream) const;
+
+	/**
+	*   \brief Writes the part of a decoded block which overlaps the given range of uncoded data
+	*   \param outputStream output stream (decoded)
+	*   \param block decoded block
+	*   \param blockOffset position of the first byte of the block in the uncoded data
+	*   \param offset position of the first byte of the range in the uncoded data
+	*   \param length number of bytes of the range
+	*   \return number of written bytes
+	*/
+	uint64_t writeRange(std::ostream& outputStream, const std::string& block, uint64_t blockOffset, uint64_t offset, uint64_t length) const;
 
 public:
 
+	/**
+	*   \brief Sets all parameters of the encoder chosen by a compression level
+	*   All levels produce streams which are decoded the same way
+	*   \param level compression level, between MIN_LEVEL and MAX_LEVEL
+	*/
+	void setLevel(int level);
+
+	/**
+	*   \brief Sets the algorithm used for sorting the permutations in BWT
+	*   \param sorter sorting algorithm
+	*/
+	void setSorter(BWTCoder::Sorter sorter);
+
+	/**
+	*   \brief Gets the algorithm used for sorting the permutations in BWT
+	*   \return sorting algorithm
+	*/
+	BWTCoder::Sorter getSorter() const;
+
+	/**
+	*   \brief Sets whether MTF and RLE are skipped for blocks where they don't pay off
+	*   \param stageSelection true to select the stages for every block, false to always use all stages
+	*/
+	void setStageSelection(bool stageSelection);
+
+	/**
+	*   \brief Gets whether MTF and RLE are skipped for blocks where they don't pay off
+	*   \return true if the stages are selected for every block
+	*/
+	bool getStageSelection() const;
+
+	/**
+	*   \brief Sets whether an FM-index for substring search is stored with every encoded block
+	*   \param searchIndex true to store the index
+	*/
+	void setSearchIndex(bool searchIndex);
+
+	/**
+	*   \brief Gets whether an FM-index for substring search is stored with every encoded block
+	*   \return true if the index is stored
+	*/
+	bool getSearchIndex() const;
+
+	/**
+	*   \brief Sets whether a CRC-32C checksum of the uncoded data is stored with every encoded block
+	*   \param checksum true to store the checksum
+	*/
+	void setChecksum(bool checksum);
+
+	/**
+	*   \brief Gets whether a CRC-32C checksum of the uncoded data is stored with every encoded block
+	*   \return true if the checksum is stored
+	*/
+	bool getChecksum() const;
+
+	/**
+	*   \brief Sets whether the stream is written with 64-bit sizes of blocks, BWT indices and Huffman counts
+	*   Block sizes above StreamFormat::MAX_BLOCK_SIZE always use 64-bit sizes, such streams can't have a search index
+	*   \param largeBlocks true to use 64-bit sizes regardless of the block size
+	*/
+	void setLargeBlocks(bool largeBlocks);
+
+	/**
+	*   \brief Gets whether the stream is written with 64-bit sizes regardless of the block size
+	*   \return true if 64-bit sizes are used regardless of the block size
+	*/
+	bool getLargeBlocks() const;
+
+	/**
+	*   \brief Sets whether blocks are ended early where the statistics of the content shift, see BlockSplitter
+	*   The block size stays the maximum size of a block. Only encode and Encoder choose the boundaries,
+	*   the records of BatchCoder and the files of archives are cut into blocks of the block size.
+	*   \param minBlockSize minimum size of a block ended early, 0 to end blocks only when they have the block size
+	*/
+	void setMinBlockSize(uint64_t minBlockSize);
+
+	/**
+	*   \brief Gets the minimum size of a block ended early where the statistics of the content shift
+	*   \return minimum size of a block, 0 if blocks always have the block size
+	*/
+	uint64_t getMinBlockSize() const;
+
+	/**
+	*   \brief Sets whether a block identical to an earlier block of the stream is stored as a reference to it instead of being encoded again
+	*   The blocks are compared by a 128-bit hash, a reference can reach the blocks kept by DeduplicationCache with StreamFormat::DEDUP_WINDOW.
+	*   Only encode uses references, the blocks appended to an existing stream, the records of BatchCoder and the blocks of archives are all encoded.
+	*   \param deduplication true to store repeated blocks as references
+	*/
+	void setDeduplication(bool deduplication);
+
+	/**
+	*   \brief Gets whether a block identical to an earlier block of the stream is stored as a reference to it
+	*   \return true if repeated blocks are stored as references
+	*/
+	bool getDeduplication() const;
+
+	/**
+	*   \brief Sets the shared entropy model of the Huffman stage
+	*   When encoding, every block is encoded with the model instead of its own histogram if that makes it smaller.
+	*   When decoding, blocks encoded with a model can only be decoded if the same model is set.
+	*   \param model trained model, nullptr to store a histogram with every block
+	*/
+	void setModel(std::shared_ptr<const EntropyModel> model);
+
+	/**
+	*   \brief Gets the shared entropy model of the Huffman stage
+	*   \return the model, nullptr if there is none
+	*/
+	std::shared_ptr<const EntropyModel> getModel() const;
+
+	/**
+	*   \brief Sets the maximum time the encoded data may lag behind the input
+	*   With a flush delay, the current block is ended early and written out with the blocks before it once its oldest byte
+	*   has waited for the delay, so that a slow input can be decoded as it arrives, at the cost of some ratio
+	*   \param flushDelay maximum delay, 0 to write only full blocks
+	*/
+	void setFlushDelay(std::chrono::milliseconds flushDelay);
+
+	/**
+	*   \brief Gets the maximum time the encoded data may lag behind the input
+	*   \return maximum delay, 0 if only full blocks are written
+	*/
+	std::chrono::milliseconds getFlushDelay() const;
+
 	/**
     *   \brief Encodes the input stream using this sequence of encoders: BWT -> MTF -> RLE -> Huffman
+	*   Up to the number of threads blocks are encoded in parallel, they are written in their original order
+	*   With a memory budget, fewer threads and smaller blocks may be used
+	*   The stream is read in chunks and given to an Encoder, which can be used directly to encode data from memory
+	*   With a flush delay, the blocks are written out as described in setFlushDelay
     *   \param log log of the encoding process gets saved here
 	*   \param inputStream input stream (uncoded)
 	*   \param outputStream output stream (encoded)
@@ -34,8 +439,24 @@ public:
     */
 	bool encode(Log& log, std::istream& inputStream, std::ostream& outputStream) const override;
 
+	/**
+	*   \brief Encodes the input stream into new blocks at the end of an existing encoded stream, the existing blocks aren't decoded
+	*   The new blocks take the place of the end of blocks and the footer, which are written again after them with a block index
+	*   of all blocks. They use the block size and the flags of the existing stream, the block size may be made smaller by the coder.
+	*   Concatenated streams get the new blocks in the last stream, which is found from the footer at their end.
+	*   If the encoding fails, the existing stream is left without its end.
+	*   \param log log of the encoding of the new blocks gets saved here
+	*   \param inputStream input stream (uncoded)
+	*   \param stream existing stream, readable, writable and seekable, positioned at the beginning of the stream header
+	*   \return true on success, false if the existing stream isn't complete or on error
+	*/
+	bool append(Log& log, std::istream& inputStream, std::iostream& stream) const;
+
 	/**
 	*   \brief Decodes the input stream using this sequence of decoders: Huffman -> RLE -> MTF -> BWT
+	*   The stream is read in chunks and given to a Decoder, which can be used directly to decode data from memory
+	*   Streams written one after another are decoded into the concatenation of their data
+	*   The output stream is flushed after a block whenever no more input is ready, so that the decoded blocks don't wait for the input
 	*   \param log log of the decoding process gets saved here
 	*   \param inputStream input stream (encoded)
 	*   \param outputStream output stream (decoded)
@@ -43,4 +464,51 @@ public:
 	*/
 	bool decode(Log& bwted, std::istream& inputStream, std::ostream& outputStream) const override;
 
+	/**
+	*   \brief Decodes only the given range of uncoded data
+	*   Only the blocks which overlap the range are decoded. If the input stream is seekable, the block index is used
+	*   to jump directly to the first of them, otherwise the blocks in front of the range are skipped without decoding.
+	*   The uncoded data of concatenated streams is one range, which is read without the index.
+	*   \param log log of the decoding process gets saved here
+	*   \param inputStream input stream (encoded)
+	*   \param outputStream output stream (decoded range)
+	*   \param offset position of the first byte of the range in the uncoded data
+	*   \param length number of bytes of the range, the range is shortened if it reaches past the end of the data
+	*   \return true on success, false on error
+	*/
+	bool decodeRange(Log& log, std::istream& inputStream, std::ostream& outputStream, uint64_t offset, uint64_t length) const;
+
+	/**
+	*   \brief Decodes all blocks of the input stream in parallel and checks their sizes and checksums, nothing is written
+	*   With a memory budget, fewer threads may be used, the block size is given by the stream
+	*   Streams written one after another are checked one by one
+	*   \param log log of the decoding process gets saved here
+	*   \param inputStream input stream (encoded)
+	*   \return true if all blocks are intact, false otherwise
+	*/
+	bool verify(Log& log, std::istream& inputStream) const;
+
+	/**
+	*   \brief Finds all occurences of a pattern in the uncoded data using the FM-index of every block, without decoding the blocks completely
+	*   Occurences which cross the boundary of two blocks aren't found
+	*   The positions in streams written one after another continue those of the previous streams, all of them need the search index
+	*   \param log log of the search gets saved here
+	*   \param inputStream input stream (encoded with the search index)
+	*   \param pattern searched string, must not be empty
+	*   \param positions positions of all occurences in the uncoded data get saved here in ascending order
+	*   \return true on success, false on error or if the stream has no search index
+	*/
+	bool search(Log& log, std::istream& inputStream, const std::string& pattern, std::vector<uint64_t>& positions) const;
+
+	/**
+	*   \brief Trains a shared entropy model of the Huffman stage on a sample corpus
+	*   The corpus is split into blocks of the block size, which should be close to the size of the messages the model is meant for,
+	*   and the input of the Huffman stage after BWT -> MTF -> RLE is counted over all blocks. Incompressible blocks are left out.
+	*   \param log log of the training gets saved here
+	*   \param inputStream sample corpus (uncoded)
+	*   \param model trained model gets saved here
+	*   \return true on success, false on error or if the corpus has no compressible block
+	*/
+	bool train(Log& log, std::istream& inputStream, EntropyModel& model) const;
+
 };
@@ -0,0 +1,212 @@
+#include "BatchCoder.h"
+
+#include "MemoryBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <future>
+
+BatchCoder::BatchCoder(const BWT_MTF_RLE_Huffman_Coder& coder)
+	: m_coder(coder)
+{
+	coder.fitEncodeBudget(m_blockSize, m_threadCount, m_sorter);
+	m_streamHeader = coder.getStreamHeader(m_blockSize);
+
+	//records are encoded block by block, a repeated block is encoded again
+	m_streamHeader.m_flags &= ~StreamFormat::FLAG_DEDUP;
+	m_encodedStreamHeader = coder.m_streamFormat.encodeStreamHeader(m_streamHeader);
+
+	//the block size must fit into the block headers and large blocks can't have a search index
+	const uint16_t flags = m_streamHeader.m_flags;
+	if (m_blockSize == 0 || m_blockSize > coder.m_streamFormat.getMaxBlockSize(flags)) m_valid = false;
+	if ((flags & StreamFormat::FLAG_LARGE_BLOCKS) && (flags & StreamFormat::FLAG_SEARCH_INDEX)) m_valid = false;
+
+	m_workspaces.resize(m_threadCount);
+	m_threadPool = std::make_unique<ThreadPool>(m_threadCount);
+}
+
+void BatchCoder::encodeRecord(const std::string& record, std::string& output, RecordResult& result, Workspace& workspace) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	output = m_encodedStreamHeader;
+	workspace.m_index.clear();
+	result.m_blockSize = m_blockSize;
+
+	for (uint64_t offset = 0; offset < record.size(); offset += m_blockSize)
+	{
+		//a record which fits into a single block is encoded without copying it
+		const std::string* block = &record;
+		if (record.size() > m_blockSize)
+		{
+			workspace.m_block.assign(record, offset, m_blockSize);
+			block = &workspace.m_block;
+		}
+
+		BlockHeader blockHeader;
+		BlockLog blockLog;
+		std::string data = m_coder.encodeBlock(m_streamHeader, m_sorter, *block, blockHeader, blockLog, workspace.m_blockWorkspace);
+
+		//the header with the sizes of the block goes before the encoded block
+		workspace.m_index.push_back({ output.size(), blockHeader.m_uncodedSize, blockHeader.m_codedSize });
+		output += streamFormat.encodeBlockHeader(m_streamHeader, blockHeader);
+		output += data;
+
+		result.m_blocks.push_back(blockLog);
+	}
+
+	//mark the end of blocks and write the footer with the block index
+	BlockHeader endHeader;
+	endHeader.m_flags = StreamFormat::BLOCK_END;
+	output += streamFormat.encodeBlockHeader(m_streamHeader, endHeader);
+	output += streamFormat.encodeFooter(workspace.m_index);
+
+	result.m_success = true;
+}
+
+bool BatchCoder::decodeRecord(const std::string& record, std::string& output, RecordResult& result, Workspace& workspace) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	MemoryBuffer buffer(record);
+	std::istream inputStream(&buffer);
+
+	output.clear();
+
+	StreamHeader streamHeader;
+	if (!streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+	result.m_blockSize = streamHeader.m_blockSize;
+	workspace.m_dedupCache.clear();
+
+	while (true)
+	{
+		BlockHeader blockHeader;
+		if (!streamFormat.readBlockHeader(inputStream, streamHeader, blockHeader)) return false;
+
+		//no more blocks, only the footer follows
+		if (blockHeader.m_flags & StreamFormat::BLOCK_END) break;
+
+		//the encoded block must fit into its maximum size, so that a corrupted header can't make us allocate a huge buffer
+		if (blockHeader.m_codedSize > m_coder.getMaxCodedBlockSize(streamHeader, blockHeader.m_uncodedSize)) return false;
+		if (!streamFormat.readBytes(inputStream, workspace.m_block, blockHeader.m_codedSize)) return false;
+
+		//the first block is decoded right into the output, the usual small record has no other
+		BlockLog blockLog;
+		std::string& decoded = result.m_blocks.empty() ? output : workspace.m_output;
+		if (!m_coder.decodeBlock(streamHeader, blockHeader, workspace.m_block, decoded, blockLog, workspace.m_blockWorkspace, result.m_blocks.size(), workspace.m_dedupCache)) return false;
+		if (&decoded != &output) output += decoded;
+
+		result.m_blocks.push_back(blockLog);
+	}
+
+	//the index must have an entry for every block and nothing may follow the footer
+	if (!streamFormat.readFooter(inputStream, workspace.m_index)) return false;
+	if (workspace.m_index.size() != result.m_blocks.size()) return false;
+
+	result.m_success = inputStream.peek() == std::char_traits<char>::eof();
+
+	return result.m_success;
+}
+
+bool BatchCoder::getDecodedSize(const std::string& record, uint64_t& size) const
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	MemoryBuffer buffer(record);
+	std::istream inputStream(&buffer);
+
+	size = 0;
+
+	StreamHeader streamHeader;
+	if (!streamFormat.readStreamHeader(inputStream, streamHeader)) return false;
+
+	while (true)
+	{
+		BlockHeader blockHeader;
+		if (!streamFormat.readBlockHeader(inputStream, streamHeader, blockHeader)) return false;
+		if (blockHeader.m_flags & StreamFormat::BLOCK_END) return true;
+
+		if (blockHeader.m_uncodedSize > streamHeader.m_blockSize || blockHeader.m_codedSize > record.size()) return false;
+		if (blockHeader.m_uncodedSize > UINT64_MAX - size) return false;
+		size += blockHeader.m_uncodedSize;
+
+		inputStream.ignore(static_cast<std::streamsize>(blockHeader.m_codedSize));
+		if (static_cast<uint64_t>(inputStream.gcount()) != blockHeader.m_codedSize) return false;
+	}
+}
+
+bool BatchCoder::process(Log& log, const std::vector<std::string>& inputs, std::vector<std::string>& outputs, std::vector<bool>& succeeded, bool encode)
+{
+	outputs.resize(inputs.size());
+	std::vector<RecordResult> results(inputs.size());
+	std::atomic<size_t> nextRecord(0);
+
+	//every task owns one workspace, so that the workspaces are never shared by two threads
+	const unsigned taskCount = static_cast<unsigned>(std::min<size_t>(m_threadCount, inputs.size()));
+	std::vector<std::future<void>> tasks;
+	for (unsigned task = 0; task < taskCount; ++task)
+	{
+		tasks.push_back(m_threadPool->submit([this, &inputs, &outputs, &results, &nextRecord, encode, task]()
+		{
+			Workspace& workspace = m_workspaces[task];
+
+			for (size_t record = nextRecord++; record < inputs.size(); record = nextRecord++)
+			{
+				if (encode)
+				{
+					encodeRecord(inputs[record], outputs[record], results[record], workspace);
+				}
+				else
+				{
+					decodeRecord(inputs[record], outputs[record], results[record], workspace);
+				}
+			}
+		}));
+	}
+
+	for (std::future<void>& task : tasks)
+	{
+		task.get();
+	}
+
+	//collect the log in the order of the records
+	log = Log();
+	log.m_threadCount = m_threadCount;
+	log.m_memoryBudget = m_coder.getMemoryBudget();
+
+	bool success = true;
+	succeeded.assign(inputs.size(), false);
+	for (size_t record = 0; record < inputs.size(); ++record)
+	{
+		const RecordResult& result = results[record];
+		success = success && result.m_success;
+		succeeded[record] = result.m_success;
+
+		log.m_blockSize = std::max(log.m_blockSize, result.m_blockSize);
+		log.m_uncodedSize += encode ? inputs[record].size() : outputs[record].size();
+		log.m_codedSize += encode ? outputs[record].size() : inputs[record].size();
+		log.m_blocks.insert(log.m_blocks.end(), result.m_blocks.begin(), result.m_blocks.end());
+	}
+
+	return success;
+}
+
+bool BatchCoder::encode(Log& log, const std::vector<std::string>& records, std::vector<std::string>& outputs)
+{
+	if (!m_valid) return false;
+
+	std::vector<bool> succeeded;
+	return process(log, records, outputs, succeeded, true);
+}
+
+bool BatchCoder::decode(Log& log, const std::vector<std::string>& records, std::vector<std::string>& outputs)
+{
+	std::vector<bool> succeeded;
+	return decode(log, records, outputs, succeeded);
+}
+
+bool BatchCoder::decode(Log& log, const std::vector<std::string>& records, std::vector<std::string>& outputs, std::vector<bool>& succeeded)
+{
+	return process(log, records, outputs, succeeded, false);
+}
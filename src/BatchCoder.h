@@ -0,0 +1,135 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BWT_MTF_RLE_Huffman_Coder.h"
+#include "ThreadPool.h"
+
+/**
+*   Encoder/Decoder of many small records at once, such as the messages of an RPC layer
+*
+*   Every record is encoded into its own complete stream, the same as BWT_MTF_RLE_Huffman_Coder::encode would write for it,
+*   so it can be decoded alone by any decoder. The records are spread over a thread pool which lives as long as the batch coder,
+*   every worker keeps a workspace between its records, so that the tables of the stages aren't set up again for every record.
+*   The coder must outlive the batch coder and its parameters mustn't change while the batch coder exists.
+*/
+class BatchCoder : public Coder
+{
+private:
+
+	/**
+	*   memory kept by a task between its records
+	*/
+	struct Workspace
+	{
+		BWT_MTF_RLE_Huffman_Coder::Workspace m_blockWorkspace; //!< workspace of the stages
+		std::string m_block;                                   //!< block copied out of a record, only if the record has more than one block
+		std::string m_output;                                  //!< decoded block which is appended to a record, only if the record has more than one block
+		std::vector<BlockIndexEntry> m_index;                  //!< block index of the current record
+		DeduplicationCache<std::string> m_dedupCache{ StreamFormat::DEDUP_WINDOW }; //!< decoded blocks of the current record which references can reach
+	};
+
+	/**
+	*   result of a single record
+	*/
+	struct RecordResult
+	{
+		std::vector<BlockLog> m_blocks; //!< statistics of the blocks of the record
+		uint64_t m_blockSize = 0;       //!< block size of the stream of the record
+		bool m_success = false;         //!< whether the record was processed
+	};
+
+	const BWT_MTF_RLE_Huffman_Coder& m_coder; //!< coder which encodes and decodes the blocks
+
+	StreamHeader m_streamHeader;                                   //!< header of every encoded record
+	std::string m_encodedStreamHeader;                             //!< the stream header encoded once for all records
+	uint64_t m_blockSize = 0;                                      //!< block size which fits into the memory budget
+	unsigned m_threadCount = 0;                                    //!< number of threads which fits into the memory budget
+	BWTCoder::Sorter m_sorter = BWTCoder::Sorter::INDUCED_SORTING; //!< sorter of the BWT stage which fits into the memory budget
+	bool m_valid = true;                                           //!< whether the parameters of the coder can be encoded
+
+	std::vector<Workspace> m_workspaces;      //!< workspace of every task, a task uses the one of its index
+	std::unique_ptr<ThreadPool> m_threadPool; //!< declared last, so that it stops before the workspaces are destroyed
+
+	/**
+	*   \brief Encodes a single record into a complete stream
+	*   \param record uncoded record
+	*   \param output encoded stream gets saved here
+	*   \param result statistics of the blocks get saved here
+	*   \param workspace workspace of the calling task
+	*/
+	void encodeRecord(const std::string& record, std::string& output, RecordResult& result, Workspace& workspace) const;
+
+	/**
+	*   \brief Decodes a single record which is a complete stream
+	*   \param record encoded stream
+	*   \param output decoded record gets saved here
+	*   \param result statistics of the blocks get saved here
+	*   \param workspace workspace of the calling task
+	*   \return true on success, false if the stream isn't valid or doesn't end with its footer
+	*/
+	bool decodeRecord(const std::string& record, std::string& output, RecordResult& result, Workspace& workspace) const;
+
+	/**
+	*   \brief Processes all records by the tasks of the thread pool and collects their log
+	*   Every task takes the next unprocessed record until there is none, so a few long records don't hold up the rest
+	*   \param log log of the whole batch gets saved here
+	*   \param inputs input records
+	*   \param outputs output records get saved here, in the order of the inputs
+	*   \param succeeded whether every record was processed gets saved here, succeeded[i] for inputs[i]
+	*   \param encode true to encode the records, false to decode them
+	*   \return true if all records were processed, false otherwise
+	*/
+	bool process(Log& log, const std::vector<std::string>& inputs, std::vector<std::string>& outputs, std::vector<bool>& succeeded, bool encode);
+
+public:
+
+	/**
+	*   \brief Chooses the block size and the number of threads of the coder within its memory budget and starts the threads
+	*   \param coder coder which encodes and decodes the blocks, its parameters are used for all records
+	*/
+	explicit BatchCoder(const BWT_MTF_RLE_Huffman_Coder& coder);
+
+	BatchCoder(const BatchCoder& other) = delete;
+
+	BatchCoder& operator=(const BatchCoder& other) = delete;
+
+	/**
+	*   \brief Encodes every record into its own stream
+	*   \param log log of the whole batch gets saved here, with the blocks of all records in order
+	*   \param records uncoded records
+	*   \param outputs encoded stream of every record gets saved here, outputs[i] for records[i]
+	*   \return true on success, false on error
+	*/
+	bool encode(Log& log, const std::vector<std::string>& records, std::vector<std::string>& outputs);
+
+	/**
+	*   \brief Decodes every record, each of which is a complete stream
+	*   \param log log of the whole batch gets saved here, with the blocks of all records in order
+	*   \param records encoded streams
+	*   \param outputs decoded record gets saved here, outputs[i] for records[i]
+	*   \return true if all records were decoded, false if any of them isn't valid
+	*/
+	bool decode(Log& log, const std::vector<std::string>& records, std::vector<std::string>& outputs);
+
+	/**
+	*   \brief Decodes every record and tells which of them are valid, so that a corrupted record doesn't spoil the others
+	*   \param log log of the whole batch gets saved here, with the blocks of all records in order
+	*   \param records encoded streams
+	*   \param outputs decoded record gets saved here, outputs[i] for records[i]
+	*   \param succeeded whether every record was decoded gets saved here, succeeded[i] for records[i]
+	*   \return true if all records were decoded, false if any of them isn't valid
+	*/
+	bool decode(Log& log, const std::vector<std::string>& records, std::vector<std::string>& outputs, std::vector<bool>& succeeded);
+
+	/**
+	*   \brief Sums the uncoded sizes in the block headers of a record without decoding its blocks
+	*   A small record may decode to a huge output, e.g. long runs of a single byte, so its size can be checked first
+	*   \param record encoded stream
+	*   \param size number of bytes the record decodes to gets saved here
+	*   \return true on success, false if the headers of the record aren't valid
+	*/
+	bool getDecodedSize(const std::string& record, uint64_t& size) const;
+};
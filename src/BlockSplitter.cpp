@@ -0,0 +1,58 @@
+#include "BlockSplitter.h"
+
+#include <algorithm>
+#include <cmath>
+
+BlockSplitter::BlockSplitter(uint64_t minSize)
+	: m_minSize(std::max<uint64_t>(minSize, WINDOW_SIZE))
+{
+	reset();
+}
+
+void BlockSplitter::reset()
+{
+	m_histogram.fill(0);
+	m_analyzedSize = 0;
+}
+
+double BlockSplitter::getDivergence(const std::array<uint32_t, UCHAR_MAX + 1>& window) const
+{
+	const double blockTotal = m_analyzedSize + PRIOR_COUNT * window.size();
+	double divergence = 0.0;
+
+	//only the symbols of the window contribute, the probabilities of the window are count / WINDOW_SIZE
+	for (size_t symbol = 0; symbol < window.size(); ++symbol)
+	{
+		if (window[symbol] == 0) continue;
+
+		const double windowProbability = static_cast<double>(window[symbol]) / WINDOW_SIZE;
+		const double blockProbability = (m_histogram[symbol] + PRIOR_COUNT) / blockTotal;
+		divergence += windowProbability * std::log2(windowProbability / blockProbability);
+	}
+
+	return divergence;
+}
+
+uint64_t BlockSplitter::findBoundary(const std::string& block)
+{
+	while (m_analyzedSize + WINDOW_SIZE <= block.size())
+	{
+		std::array<uint32_t, UCHAR_MAX + 1> window = {};
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(block.data()) + m_analyzedSize;
+		for (size_t i = 0; i < WINDOW_SIZE; ++i)
+		{
+			window[data[i]]++;
+		}
+
+		//the statistics shift at this window, it starts the next block
+		if (m_analyzedSize >= m_minSize && getDivergence(window) >= SHIFT_THRESHOLD) return m_analyzedSize;
+
+		for (size_t symbol = 0; symbol < window.size(); ++symbol)
+		{
+			m_histogram[symbol] += window[symbol];
+		}
+		m_analyzedSize += WINDOW_SIZE;
+	}
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+*   Chooses where a block ends by the content of the data, so that a block doesn't mix data with different statistics
+*
+*   The block being filled is analyzed in windows of WINDOW_SIZE bytes. The histogram of every window is compared with
+*   the histogram of the block before it, and once the block has its minimum size, the first window whose bytes would cost
+*   SHIFT_THRESHOLD bits per byte more with the order-0 statistics of the block than with their own starts the next block.
+*   The maximum size of a block is enforced by its user, the splitter only finds earlier boundaries.
+*/
+class BlockSplitter
+{
+public:
+
+	static constexpr size_t WINDOW_SIZE = 4096;     //!< number of bytes compared with the block at once, boundaries fall between windows
+	static constexpr double SHIFT_THRESHOLD = 1.0;  //!< Kullback-Leibler divergence of a window from the block in bits per byte at which the block ends
+	static constexpr double PRIOR_COUNT = 0.5;      //!< count added to every symbol of the block, so that a byte not seen in the block doesn't cost infinitely many bits
+
+private:
+
+	uint64_t m_minSize;                               //!< minimum size of a block ended by the splitter
+	std::array<uint64_t, UCHAR_MAX + 1> m_histogram;  //!< histogram of the analyzed part of the block
+	uint64_t m_analyzedSize = 0;                      //!< number of bytes at the beginning of the block added to the histogram
+
+	/**
+	*   \brief Computes how many more bits per byte a window costs with the statistics of the block than with its own
+	*   \param window histogram of the window
+	*   \return Kullback-Leibler divergence of the window from the block in bits per byte
+	*/
+	double getDivergence(const std::array<uint32_t, UCHAR_MAX + 1>& window) const;
+
+public:
+
+	/**
+	*   \brief Constructor
+	*   \param minSize minimum size of a block ended by the splitter, at least WINDOW_SIZE is used
+	*/
+	explicit BlockSplitter(uint64_t minSize);
+
+	/**
+	*   \brief Forgets the analyzed data, must be called whenever a new block starts
+	*/
+	void reset();
+
+	/**
+	*   \brief Analyzes the complete windows of the block which haven't been analyzed yet, until it finds a boundary
+	*   The block may grow between the calls, the part analyzed before must stay the same
+	*   \param block data of the block being filled
+	*   \return size of the block which ends at the boundary, 0 if there is no boundary in the analyzed data
+	*/
+	uint64_t findBoundary(const std::string& block);
+};
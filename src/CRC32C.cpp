@@ -0,0 +1,190 @@
+#include "CRC32C.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_HARDWARE
+#include <nmmintrin.h>
+#endif
+
+CRC32C::CRC32C()
+{
+	//table for processing a single byte
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; ++bit)
+		{
+			crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+		}
+		m_tables[0][i] = crc;
+	}
+
+	//tables for the following bytes, each one continues the previous one by a zero byte
+	for (int table = 1; table < 8; ++table)
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			m_tables[table][i] = (m_tables[table - 1][i] >> 8) ^ m_tables[0][m_tables[table - 1][i] & 0xFF];
+		}
+	}
+
+	m_laneShift = shiftPolynomial(LANE_SIZE);
+	m_twoLanesShift = shiftPolynomial(2 * LANE_SIZE);
+
+#ifdef CRC32C_HARDWARE
+	m_hardware = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+const CRC32C& CRC32C::instance()
+{
+	static const CRC32C crc32c;
+
+	return crc32c;
+}
+
+uint32_t CRC32C::multiplyModulo(uint32_t a, uint32_t b)
+{
+	uint32_t product = 0;
+
+	//the highest bit is the coefficient of x^0
+	for (uint32_t mask = 1u << 31; mask != 0; mask >>= 1)
+	{
+		if (a & mask) product ^= b;
+
+		//multiply b by x
+		b = (b & 1) ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+	}
+
+	return product;
+}
+
+uint32_t CRC32C::shiftPolynomial(size_t size)
+{
+	uint32_t result = 1u << 31;   //x^0
+	uint32_t power = 1u << 23;    //x^8, shift over a single byte
+
+	//exponentiation by squaring
+	while (size > 0)
+	{
+		if (size & 1) result = multiplyModulo(result, power);
+		power = multiplyModulo(power, power);
+		size >>= 1;
+	}
+
+	return result;
+}
+
+uint32_t CRC32C::updateSoftware(uint32_t crc, const unsigned char* data, size_t size) const
+{
+	//8 bytes at once
+	while (size >= 8)
+	{
+		uint32_t low = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24));
+		uint32_t high = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+
+		crc = m_tables[7][low & 0xFF] ^ m_tables[6][(low >> 8) & 0xFF] ^ m_tables[5][(low >> 16) & 0xFF] ^ m_tables[4][low >> 24]
+			^ m_tables[3][high & 0xFF] ^ m_tables[2][(high >> 8) & 0xFF] ^ m_tables[1][(high >> 16) & 0xFF] ^ m_tables[0][high >> 24];
+
+		data += 8;
+		size -= 8;
+	}
+
+	//the rest byte by byte
+	while (size > 0)
+	{
+		crc = m_tables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+
+		data++;
+		size--;
+	}
+
+	return crc;
+}
+
+#ifdef CRC32C_HARDWARE
+
+__attribute__((target("sse4.2")))
+uint32_t CRC32C::updateHardware(uint32_t crc, const unsigned char* data, size_t size) const
+{
+	uint64_t crc0 = crc;
+
+	//three independent lanes, the register of the first lane is then shifted over the other two and combined with them
+	while (size >= 3 * LANE_SIZE)
+	{
+		uint64_t crc1 = 0;
+		uint64_t crc2 = 0;
+
+		for (size_t i = 0; i < LANE_SIZE; i += 8)
+		{
+			uint64_t value0, value1, value2;
+			std::memcpy(&value0, data + i, 8);
+			std::memcpy(&value1, data + LANE_SIZE + i, 8);
+			std::memcpy(&value2, data + 2 * LANE_SIZE + i, 8);
+
+			crc0 = _mm_crc32_u64(crc0, value0);
+			crc1 = _mm_crc32_u64(crc1, value1);
+			crc2 = _mm_crc32_u64(crc2, value2);
+		}
+
+		crc0 = multiplyModulo(m_twoLanesShift, static_cast<uint32_t>(crc0)) ^ multiplyModulo(m_laneShift, static_cast<uint32_t>(crc1)) ^ static_cast<uint32_t>(crc2);
+
+		data += 3 * LANE_SIZE;
+		size -= 3 * LANE_SIZE;
+	}
+
+	//the rest in a single lane
+	while (size >= 8)
+	{
+		uint64_t value;
+		std::memcpy(&value, data, 8);
+		crc0 = _mm_crc32_u64(crc0, value);
+
+		data += 8;
+		size -= 8;
+	}
+
+	uint32_t result = static_cast<uint32_t>(crc0);
+	while (size > 0)
+	{
+		result = _mm_crc32_u8(result, *data);
+
+		data++;
+		size--;
+	}
+
+	return result;
+}
+
+#else
+
+uint32_t CRC32C::updateHardware(uint32_t crc, const unsigned char* data, size_t size) const
+{
+	return updateSoftware(crc, data, size);
+}
+
+#endif
+
+uint32_t CRC32C::update(uint32_t crc, const char* data, size_t size) const
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+	//the register is inverted before and after processing the data
+	if (m_hardware)
+	{
+		return ~updateHardware(~crc, bytes, size);
+	}
+
+	return ~updateSoftware(~crc, bytes, size);
+}
+
+uint32_t CRC32C::compute(const std::string& str) const
+{
+	return update(0, str.data(), str.size());
+}
+
+bool CRC32C::isHardwareAccelerated() const
+{
+	return m_hardware;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+*   Computes CRC-32C (Castagnoli) checksums
+*   The SSE4.2 crc32 instruction is used if the CPU supports it, otherwise the checksum is computed using lookup tables.
+*/
+class CRC32C
+{
+private:
+
+	static constexpr uint32_t POLYNOMIAL = 0x82F63B78; //!< reversed CRC-32C polynomial
+	static constexpr size_t LANE_SIZE = 8192;          //!< number of bytes processed in each of the three interleaved lanes
+
+	std::array<std::array<uint32_t, 256>, 8> m_tables; //!< lookup tables for processing 8 bytes at once in software
+	bool m_hardware = false;                           //!< whether the crc32 instruction is available
+	uint32_t m_laneShift = 0;                          //!< shifts the CRC register over one lane of zero bytes
+	uint32_t m_twoLanesShift = 0;                      //!< shifts the CRC register over two lanes of zero bytes
+
+	/**
+	*   \brief Updates the CRC register with the given data using lookup tables
+	*   \param crc current value of the CRC register
+	*   \param data data to process
+	*   \param size number of bytes of the data
+	*   \return new value of the CRC register
+	*/
+	uint32_t updateSoftware(uint32_t crc, const unsigned char* data, size_t size) const;
+
+	/**
+	*   \brief Updates the CRC register with the given data using the crc32 instruction
+	*   Large inputs are split into three lanes which are processed in an interleaved way and combined at the end,
+	*   so that the latency of the instruction is hidden
+	*   \param crc current value of the CRC register
+	*   \param data data to process
+	*   \param size number of bytes of the data
+	*   \return new value of the CRC register
+	*/
+	uint32_t updateHardware(uint32_t crc, const unsigned char* data, size_t size) const;
+
+	/**
+	*   \brief Multiplies two polynomials modulo the CRC polynomial, in the reversed bit order
+	*   \param a first polynomial
+	*   \param b second polynomial
+	*   \return product modulo the CRC polynomial
+	*/
+	static uint32_t multiplyModulo(uint32_t a, uint32_t b);
+
+	/**
+	*   \brief Computes the polynomial which shifts the CRC register over the given number of zero bytes
+	*   \param size number of bytes
+	*   \return x^(8 * size) modulo the CRC polynomial
+	*/
+	static uint32_t shiftPolynomial(size_t size);
+
+	CRC32C();
+
+public:
+
+	/**
+	*   \brief Returns the shared instance, lookup tables and CPU features are initialized on first use
+	*   \return the shared instance
+	*/
+	static const CRC32C& instance();
+
+	/**
+	*   \brief Continues the checksum over more data
+	*   \param crc checksum of the preceding data, 0 for the beginning of data
+	*   \param data data to process
+	*   \param size number of bytes of the data
+	*   \return checksum of all data so far
+	*/
+	uint32_t update(uint32_t crc, const char* data, size_t size) const;
+
+	/**
+	*   \brief Computes the checksum of a string
+	*   \param str input string
+	*   \return checksum of the string
+	*/
+	uint32_t compute(const std::string& str) const;
+
+	/**
+	*   \brief Returns whether the crc32 instruction is used
+	*   \return true if the crc32 instruction is used
+	*/
+	bool isHardwareAccelerated() const;
+};
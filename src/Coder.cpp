@@ -34,7 +34,7 @@ uint64_t Coder::decodeNumber(const std::string& str) const
 	for (int i = 0; i < str.size(); ++i)
 	{
 		//insert current byte to the end of the output
-		result += static_cast<unsigned char>(str[i]) << (CHAR_BIT * ((str.size() - 1) - i));
+		result += static_cast<uint64_t>(static_cast<unsigned char>(str[i])) << (CHAR_BIT * ((str.size() - 1) - i));
 	}
 
 	return result;
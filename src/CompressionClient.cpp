@@ -0,0 +1,119 @@
+#include "CompressionClient.h"
+
+#include <vector>
+
+#include "CompressionServer.h"
+
+bool CompressionClient::connect(const std::string& path)
+{
+	m_error.clear();
+
+	if (!m_socket.connect(path))
+	{
+		m_error = "the server isn't running";
+		return false;
+	}
+
+	return true;
+}
+
+bool CompressionClient::request(uint8_t op, const std::string& payload, std::string& result, bool memoryFile)
+{
+	m_error.clear();
+	result.clear();
+
+	if (!m_socket.isOpen())
+	{
+		m_error = "not connected";
+		return false;
+	}
+
+	if (payload.size() > CompressionServer::MAX_PAYLOAD_SIZE)
+	{
+		m_error = "the input is too large";
+		return false;
+	}
+
+	uint8_t flags = 0;
+	int sentFile = UnixSocket::NO_DESCRIPTOR;
+	if (memoryFile)
+	{
+		if (!UnixSocket::createMemoryFile(payload, sentFile))
+		{
+			m_error = "memory files aren't supported";
+			return false;
+		}
+
+		flags = CompressionServer::FRAME_MEMORY_FILE;
+	}
+
+	std::string header;
+	header += static_cast<char>(op);
+	header += static_cast<char>(flags);
+	header += encodeNumber(payload.size(), sizeof(uint64_t));
+
+	//the memory file goes with the first byte of the header, the payload follows the header otherwise
+	bool sent = m_socket.sendAll(header.data(), header.size(), sentFile) && (memoryFile || m_socket.sendAll(payload.data(), payload.size(), UnixSocket::NO_DESCRIPTOR));
+	UnixSocket::closeDescriptor(sentFile);
+
+	if (!sent)
+	{
+		m_socket.close();
+		m_error = "the request couldn't be sent";
+		return false;
+	}
+
+	std::vector<int> receivedFiles;
+	char responseHeader[CompressionServer::FRAME_HEADER_SIZE];
+	bool received = m_socket.receiveAll(responseHeader, sizeof(responseHeader), receivedFiles);
+
+	uint8_t status = CompressionServer::STATUS_ERROR;
+	uint64_t size = 0;
+	if (received)
+	{
+		status = static_cast<uint8_t>(responseHeader[0]);
+		flags = static_cast<uint8_t>(responseHeader[1]);
+		size = decodeNumber(std::string(responseHeader + 2, sizeof(uint64_t)));
+
+		if (size > CompressionServer::MAX_PAYLOAD_SIZE)
+		{
+			received = false;
+		}
+		else if (flags & CompressionServer::FRAME_MEMORY_FILE)
+		{
+			received = !receivedFiles.empty() && UnixSocket::readMemoryFile(receivedFiles.front(), size, result);
+		}
+		else
+		{
+			result.resize(size);
+			received = m_socket.receiveAll(&result[0], size, receivedFiles);
+		}
+	}
+
+	for (int receivedFile : receivedFiles)
+	{
+		UnixSocket::closeDescriptor(receivedFile);
+	}
+
+	if (!received)
+	{
+		m_socket.close();
+		result.clear();
+		m_error = "the server didn't answer";
+		return false;
+	}
+
+	if (status != CompressionServer::STATUS_OK)
+	{
+		m_error = result;
+		result.clear();
+		return false;
+	}
+
+	return true;
+}
+
+const std::string& CompressionClient::getError() const
+{
+	return m_error;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Coder.h"
+#include "UnixSocket.h"
+
+/**
+*   Client of a CompressionServer, sends requests over its Unix domain socket and waits for the responses
+*/
+class CompressionClient : public Coder
+{
+private:
+
+	UnixSocket m_socket; //!< connection to the server
+	std::string m_error; //!< reason of the last failure
+
+public:
+
+	/**
+	*   \brief Connects to a server
+	*   \param path path of the socket file of the server
+	*   \return true on success, false on error
+	*/
+	bool connect(const std::string& path);
+
+	/**
+	*   \brief Sends a request and waits for its response
+	*   \param op type of the request, CompressionServer::OP_* value
+	*   \param payload payload of the request
+	*   \param result payload of the response gets saved here if the request succeeded
+	*   \param memoryFile true to pass the payloads in memory files instead of through the socket
+	*   \return true if the server answered with CompressionServer::STATUS_OK, false otherwise, getError() tells why
+	*/
+	bool request(uint8_t op, const std::string& payload, std::string& result, bool memoryFile);
+
+	/**
+	*   \brief Returns the reason of the last failure
+	*   \return message of the server or a description of the error of the connection
+	*/
+	const std::string& getError() const;
+};
@@ -0,0 +1,484 @@
+#include "CompressionServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+CompressionServer::CompressionServer(const BWT_MTF_RLE_Huffman_Coder& coder)
+	: m_coder(coder)
+	, m_batchCoder(coder)
+	, m_receiveBuffer(new char[RECEIVE_CHUNK_SIZE])
+	, m_startTime(std::chrono::steady_clock::now())
+{
+}
+
+CompressionServer::~CompressionServer()
+{
+	for (std::unique_ptr<Connection>& connection : m_connections)
+	{
+		discardConnection(*connection);
+	}
+
+#if !defined(_WIN32)
+	//the socket file is removed only if this server created it
+	if (m_listener.isOpen()) unlink(m_path.c_str());
+#endif
+
+	UnixSocket::closeDescriptor(m_wakePipe[0]);
+	UnixSocket::closeDescriptor(m_wakePipe[1]);
+}
+
+std::string CompressionServer::encodeFrameHeader(uint8_t type, uint8_t flags, uint64_t size) const
+{
+	std::string header;
+	header += static_cast<char>(type);
+	header += static_cast<char>(flags);
+	header += encodeNumber(size, sizeof(uint64_t));
+
+	return header;
+}
+
+bool CompressionServer::listen(const std::string& path)
+{
+	if (m_listener.isOpen()) return false;
+
+#if defined(_WIN32)
+	(void)path;
+	return false;
+#else
+	//stop() only writes into the pipe, which is safe in a signal handler, and the poll loop wakes up
+	if (m_wakePipe[0] == UnixSocket::NO_DESCRIPTOR)
+	{
+		if (pipe(m_wakePipe.data()) != 0)
+		{
+			m_wakePipe = { UnixSocket::NO_DESCRIPTOR, UnixSocket::NO_DESCRIPTOR };
+			return false;
+		}
+
+		for (int descriptor : m_wakePipe)
+		{
+			fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+			fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+		}
+	}
+
+	if (!m_listener.listen(path) || !m_listener.setNonBlocking())
+	{
+		m_listener.close();
+		return false;
+	}
+
+	m_path = path;
+
+	return true;
+#endif
+}
+
+bool CompressionServer::run()
+{
+#if defined(_WIN32)
+	return false;
+#else
+	if (!m_listener.isOpen()) return false;
+
+	std::vector<pollfd> descriptors;
+	std::vector<Request> requests;
+
+	while (true)
+	{
+		descriptors.clear();
+		descriptors.push_back({ m_wakePipe[0], POLLIN, 0 });
+		descriptors.push_back({ m_listener.getDescriptor(), POLLIN, 0 });
+
+		//a connection isn't received from while it has unsent responses, so a client which doesn't read them can't make them pile up
+		for (const std::unique_ptr<Connection>& connection : m_connections)
+		{
+			short events = 0;
+			if (connection->m_receiving && connection->m_responses.empty()) events |= POLLIN;
+			if (!connection->m_responses.empty()) events |= POLLOUT;
+			descriptors.push_back({ connection->m_socket.getDescriptor(), events, 0 });
+		}
+
+		if (poll(descriptors.data(), descriptors.size(), -1) < 0)
+		{
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		//stop() was called, the requests which are still on their way are dropped
+		if (descriptors[0].revents != 0) return true;
+
+		//the connections accepted now have no entry in descriptors yet
+		const size_t connectionCount = m_connections.size();
+		if (descriptors[1].revents & POLLIN) acceptConnections();
+
+		for (size_t i = 0; i < connectionCount; ++i)
+		{
+			Connection& connection = *m_connections[i];
+			const short events = descriptors[i + 2].revents;
+
+			if ((descriptors[i + 2].events & POLLIN) && (events & (POLLIN | POLLHUP | POLLERR)))
+			{
+				receiveRequests(connection, requests);
+			}
+		}
+
+		processRequests(requests);
+
+		//the socket usually takes a response right away, so the responses are sent without waiting for POLLOUT
+		for (std::unique_ptr<Connection>& connection : m_connections)
+		{
+			if (!connection->m_responses.empty()) sendResponses(*connection);
+		}
+
+		//close the connections which broke or which the client closed and which have no more responses to send
+		std::vector<std::unique_ptr<Connection>>::iterator end = std::remove_if(m_connections.begin(), m_connections.end(),
+			[this](std::unique_ptr<Connection>& connection)
+		{
+			if (!connection->m_failed && (connection->m_receiving || !connection->m_responses.empty())) return false;
+
+			discardConnection(*connection);
+			return true;
+		});
+		m_connections.erase(end, m_connections.end());
+	}
+#endif
+}
+
+void CompressionServer::stop()
+{
+#if !defined(_WIN32)
+	if (m_wakePipe[1] != UnixSocket::NO_DESCRIPTOR)
+	{
+		const char byte = 0;
+		ssize_t result = write(m_wakePipe[1], &byte, 1);
+		(void)result;
+	}
+#endif
+}
+
+void CompressionServer::acceptConnections()
+{
+	while (true)
+	{
+		UnixSocket socket = m_listener.accept();
+		if (!socket.isOpen()) break;
+		if (!socket.setNonBlocking()) continue;
+
+		std::unique_ptr<Connection> connection = std::make_unique<Connection>();
+		connection->m_socket = std::move(socket);
+		m_connections.push_back(std::move(connection));
+		m_connectionCount++;
+	}
+}
+
+void CompressionServer::receiveRequests(Connection& connection, std::vector<Request>& requests)
+{
+	while (true)
+	{
+		long long received = connection.m_socket.receive(m_receiveBuffer.get(), RECEIVE_CHUNK_SIZE, connection.m_memoryFiles);
+
+		if (received > 0)
+		{
+			if (connection.m_input.empty()) connection.m_frameStart = std::chrono::steady_clock::now();
+			connection.m_input.append(m_receiveBuffer.get(), static_cast<size_t>(received));
+		}
+		else if (received == 0)
+		{
+			//the client won't send more requests, but it still gets the responses to the ones it sent
+			connection.m_receiving = false;
+			break;
+		}
+		else
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK) connection.m_failed = true;
+			break;
+		}
+	}
+
+	if (connection.m_memoryFiles.size() > MAX_PENDING_MEMORY_FILES) connection.m_failed = true;
+
+	//split the received bytes into frames
+	const std::string& input = connection.m_input;
+	size_t position = 0;
+	while (input.size() - position >= FRAME_HEADER_SIZE)
+	{
+		Request request;
+		request.m_connection = &connection;
+		request.m_op = static_cast<uint8_t>(input[position]);
+		request.m_start = connection.m_frameStart;
+
+		const uint8_t flags = static_cast<uint8_t>(input[position + 1]);
+		const uint64_t size = decodeNumber(input.substr(position + 2, sizeof(uint64_t)));
+		request.m_memoryFile = (flags & FRAME_MEMORY_FILE) != 0;
+
+		//after an invalid frame the boundaries of the following ones are unknown, so it is answered and nothing more is received
+		if ((request.m_op != OP_ENCODE && request.m_op != OP_DECODE && request.m_op != OP_STATS) || (flags & ~FRAME_MEMORY_FILE) != 0
+			|| size > MAX_PAYLOAD_SIZE || (request.m_memoryFile && connection.m_memoryFiles.empty()))
+		{
+			request.m_error = "invalid frame";
+			requests.push_back(std::move(request));
+			connection.m_receiving = false;
+			position = input.size();
+			break;
+		}
+
+		const uint64_t frameSize = FRAME_HEADER_SIZE + (request.m_memoryFile ? 0 : size);
+		if (input.size() - position < frameSize) break;
+
+		if (request.m_memoryFile)
+		{
+			const int memoryFile = connection.m_memoryFiles.front();
+			connection.m_memoryFiles.erase(connection.m_memoryFiles.begin());
+
+			if (!UnixSocket::readMemoryFile(memoryFile, size, request.m_payload)) request.m_error = "the memory file couldn't be read";
+			UnixSocket::closeDescriptor(memoryFile);
+		}
+		else
+		{
+			request.m_payload = input.substr(position + FRAME_HEADER_SIZE, size);
+		}
+
+		requests.push_back(std::move(request));
+		position += frameSize;
+
+		//the next frame arrived with the data received now
+		connection.m_frameStart = std::chrono::steady_clock::now();
+	}
+
+	connection.m_input.erase(0, position);
+}
+
+void CompressionServer::processRequests(std::vector<Request>& requests)
+{
+	std::vector<std::string> encodeInputs;
+	std::vector<std::string> decodeInputs;
+
+	for (Request& request : requests)
+	{
+		//a small stream may decode to a huge output, which must fit into the limit of a payload like the request
+		uint64_t decodedSize = 0;
+		if (request.m_error.empty() && request.m_op == OP_DECODE)
+		{
+			if (!m_batchCoder.getDecodedSize(request.m_payload, decodedSize)) request.m_error = "the input isn't a valid stream";
+			else if (decodedSize > MAX_PAYLOAD_SIZE) request.m_error = "the decoded data would be larger than the maximum payload";
+		}
+
+		if (!request.m_error.empty()) continue;
+
+		if (request.m_op == OP_ENCODE) encodeInputs.push_back(std::move(request.m_payload));
+		if (request.m_op == OP_DECODE) decodeInputs.push_back(std::move(request.m_payload));
+	}
+
+	//all requests of a type are processed by the threads of the batch coder together
+	Log log;
+	std::vector<std::string> encodeOutputs;
+	std::vector<std::string> decodeOutputs;
+	std::vector<bool> decodeSucceeded;
+	bool encodeSucceeded = encodeInputs.empty() || m_batchCoder.encode(log, encodeInputs, encodeOutputs);
+	if (!decodeInputs.empty()) m_batchCoder.decode(log, decodeInputs, decodeOutputs, decodeSucceeded);
+
+	//the responses are queued in the order of the requests
+	size_t encodeIndex = 0;
+	size_t decodeIndex = 0;
+	for (Request& request : requests)
+	{
+		if (!request.m_error.empty())
+		{
+			queueResponse(request, STATUS_ERROR, std::move(request.m_error), request.m_payload.size());
+		}
+		else if (request.m_op == OP_ENCODE)
+		{
+			const size_t i = encodeIndex++;
+			if (encodeSucceeded)
+			{
+				queueResponse(request, STATUS_OK, std::move(encodeOutputs[i]), encodeInputs[i].size());
+			}
+			else
+			{
+				queueResponse(request, STATUS_ERROR, "the parameters of the coder can't be encoded", encodeInputs[i].size());
+			}
+		}
+		else if (request.m_op == OP_DECODE)
+		{
+			const size_t i = decodeIndex++;
+			if (decodeSucceeded[i])
+			{
+				queueResponse(request, STATUS_OK, std::move(decodeOutputs[i]), decodeInputs[i].size());
+			}
+			else
+			{
+				queueResponse(request, STATUS_ERROR, "the input isn't a valid stream or was encoded with a different model", decodeInputs[i].size());
+			}
+		}
+		else
+		{
+			std::ostringstream stats;
+			writeStats(stats);
+			queueResponse(request, STATUS_OK, stats.str(), request.m_payload.size());
+		}
+	}
+
+	requests.clear();
+}
+
+void CompressionServer::queueResponse(const Request& request, uint8_t status, std::string&& payload, uint64_t inputSize)
+{
+	Response response;
+	response.m_op = request.m_op;
+	response.m_success = status == STATUS_OK;
+	response.m_inputSize = inputSize;
+	response.m_outputSize = payload.size();
+	response.m_start = request.m_start;
+
+	//the response to a request in a memory file goes in a memory file too, if one can be created
+	uint8_t flags = 0;
+	if (request.m_memoryFile && UnixSocket::createMemoryFile(payload, response.m_memoryFile))
+	{
+		flags = FRAME_MEMORY_FILE;
+	}
+	else
+	{
+		response.m_payload = std::move(payload);
+	}
+
+	response.m_header = encodeFrameHeader(status, flags, response.m_outputSize);
+	request.m_connection->m_responses.push_back(std::move(response));
+}
+
+void CompressionServer::sendResponses(Connection& connection)
+{
+	while (!connection.m_responses.empty())
+	{
+		Response& response = connection.m_responses.front();
+		const size_t frameSize = response.m_header.size() + response.m_payload.size();
+
+		while (response.m_sentSize < frameSize)
+		{
+			const bool header = response.m_sentSize < response.m_header.size();
+			const std::string& part = header ? response.m_header : response.m_payload;
+			const size_t offset = header ? response.m_sentSize : response.m_sentSize - response.m_header.size();
+
+			long long sent = connection.m_socket.send(part.data() + offset, part.size() - offset, response.m_memoryFile);
+			if (sent < 0)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK) connection.m_failed = true;
+				return;
+			}
+
+			//the client has its own descriptor of the memory file once the first byte was sent
+			UnixSocket::closeDescriptor(response.m_memoryFile);
+			response.m_memoryFile = UnixSocket::NO_DESCRIPTOR;
+			response.m_sentSize += static_cast<size_t>(sent);
+		}
+
+		recordResponse(response);
+		connection.m_responses.pop_front();
+	}
+}
+
+void CompressionServer::recordResponse(const Response& response)
+{
+	if (response.m_op != OP_ENCODE && response.m_op != OP_DECODE && response.m_op != OP_STATS)
+	{
+		m_invalidFrameCount++;
+		return;
+	}
+
+	RequestStats& stats = (response.m_op == OP_ENCODE) ? m_encodeStats : (response.m_op == OP_DECODE) ? m_decodeStats : m_statsStats;
+	const double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - response.m_start).count();
+
+	stats.m_requestCount++;
+	if (!response.m_success) stats.m_failedCount++;
+	stats.m_inputSize += response.m_inputSize;
+	stats.m_outputSize += response.m_outputSize;
+	stats.m_maxLatency = std::max(stats.m_maxLatency, latency);
+
+	//bucket i holds the latencies from 2^(i-1) up to 2^i microseconds
+	const double microseconds = latency * 1e6;
+	int bucket = (microseconds < 1.0) ? 0 : static_cast<int>(std::floor(std::log2(microseconds))) + 1;
+	stats.m_latencyBuckets[std::min(bucket, LATENCY_BUCKET_COUNT - 1)]++;
+}
+
+void CompressionServer::discardConnection(Connection& connection)
+{
+	for (int memoryFile : connection.m_memoryFiles)
+	{
+		UnixSocket::closeDescriptor(memoryFile);
+	}
+	connection.m_memoryFiles.clear();
+
+	for (Response& response : connection.m_responses)
+	{
+		UnixSocket::closeDescriptor(response.m_memoryFile);
+		response.m_memoryFile = UnixSocket::NO_DESCRIPTOR;
+	}
+	connection.m_responses.clear();
+
+	connection.m_socket.close();
+}
+
+double CompressionServer::getLatencyPercentile(const RequestStats& stats, double fraction)
+{
+	if (stats.m_requestCount == 0) return 0.0;
+
+	//nearest-rank method over the buckets, the bucket is represented by its upper bound
+	const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(fraction * stats.m_requestCount)), 1);
+	uint64_t count = 0;
+	for (int bucket = 0; bucket < LATENCY_BUCKET_COUNT - 1; ++bucket)
+	{
+		count += stats.m_latencyBuckets[bucket];
+		if (count >= rank) return std::min(std::ldexp(1e-6, bucket), stats.m_maxLatency);
+	}
+
+	return stats.m_maxLatency;
+}
+
+void CompressionServer::writeRequestStats(std::ostream& outputStream, const std::string& name, const RequestStats& stats) const
+{
+	outputStream << name << "Requests = " << stats.m_requestCount << "\n";
+	outputStream << name << "Failed = " << stats.m_failedCount << "\n";
+	outputStream << name << "InputSize = " << stats.m_inputSize << "\n";
+	outputStream << name << "OutputSize = " << stats.m_outputSize << "\n";
+	outputStream << name << "Latency = " << getLatencyPercentile(stats, 0.5) << "/" << getLatencyPercentile(stats, 0.99) << "/" << stats.m_maxLatency << "\n";
+
+	//upper bound of every non-empty bucket in microseconds and its number of requests
+	outputStream << name << "LatencyHistogram =";
+	for (int bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket)
+	{
+		if (stats.m_latencyBuckets[bucket] == 0) continue;
+
+		outputStream << " ";
+		if (bucket + 1 < LATENCY_BUCKET_COUNT)
+		{
+			outputStream << (uint64_t(1) << bucket);
+		}
+		else
+		{
+			outputStream << "inf";
+		}
+		outputStream << ":" << stats.m_latencyBuckets[bucket];
+	}
+	outputStream << "\n";
+}
+
+void CompressionServer::writeStats(std::ostream& outputStream) const
+{
+	const std::shared_ptr<const EntropyModel> model = m_coder.getModel();
+
+	outputStream << "uptime = " << std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count() << "\n";
+	outputStream << "connectionCount = " << m_connectionCount << "\n";
+	outputStream << "openConnections = " << m_connections.size() << "\n";
+	outputStream << "invalidFrames = " << m_invalidFrameCount << "\n";
+	outputStream << "modelID = " << (model ? model->getID() : 0) << "\n";
+	writeRequestStats(outputStream, "encode", m_encodeStats);
+	writeRequestStats(outputStream, "decode", m_decodeStats);
+	writeRequestStats(outputStream, "stats", m_statsStats);
+}
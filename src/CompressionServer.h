@@ -0,0 +1,237 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BatchCoder.h"
+#include "UnixSocket.h"
+
+/**
+*   Local compression daemon which answers the requests of clients over a Unix domain socket
+*
+*   The coder, its thread pool, the workspaces of the stages and the shared entropy model stay in memory between the requests,
+*   so a request doesn't pay for setting them up like a run of the command-line tool does. A single thread waits for all
+*   connections with poll(2). The requests which arrived together are encoded or decoded in one batch by a BatchCoder,
+*   whose threads spread them over the cores, and the responses of every connection are sent in the order of its requests.
+*
+*   frame: type (1 byte), flags (1 byte), size of the payload (8 bytes), payload (size bytes), all in big-endian order
+*          the type of a request is OP_ENCODE, OP_DECODE or OP_STATS, the type of a response is STATUS_OK or STATUS_ERROR
+*          with FRAME_MEMORY_FILE the payload isn't sent through the socket, a memory file (memfd) which holds it is passed with
+*          the first byte of the frame instead, the response to such a request comes in a memory file too
+*   The payload of OP_ENCODE is uncoded data, of OP_DECODE a complete encoded stream, OP_STATS has none.
+*   The payload of STATUS_OK is the result, the statistics of the server for OP_STATS, the payload of STATUS_ERROR is a message.
+*/
+class CompressionServer : public Coder
+{
+public:
+
+	static constexpr uint8_t OP_ENCODE = 'c'; //!< request to encode the payload into a complete stream
+	static constexpr uint8_t OP_DECODE = 'x'; //!< request to decode the payload, which is a complete stream
+	static constexpr uint8_t OP_STATS = 's';  //!< request for the statistics of the server
+
+	static constexpr uint8_t STATUS_OK = 0;    //!< the request succeeded, the payload is its result
+	static constexpr uint8_t STATUS_ERROR = 1; //!< the request failed, the payload is the reason
+
+	static constexpr uint8_t FRAME_MEMORY_FILE = 0x01; //!< the payload is in a memory file passed with the frame
+
+	static constexpr int FRAME_HEADER_SIZE = 10;                     //!< size of the type, flags and payload size of a frame in bytes
+	static constexpr uint64_t MAX_PAYLOAD_SIZE = uint64_t(1) << 30; //!< maximum size of a payload, larger requests are refused
+
+	static constexpr int LATENCY_BUCKET_COUNT = 32; //!< bucket i of a latency histogram counts latencies below 2^i microseconds, the last one all others
+
+private:
+
+	static constexpr size_t RECEIVE_CHUNK_SIZE = 1 << 16; //!< maximum number of bytes received from a connection at once
+	static constexpr size_t MAX_PENDING_MEMORY_FILES = 64; //!< a connection which passes more memory files than frames is closed, so it can't use up the descriptors
+
+	/**
+	*   statistics of the requests of a single type
+	*/
+	struct RequestStats
+	{
+		uint64_t m_requestCount = 0;  //!< number of answered requests
+		uint64_t m_failedCount = 0;   //!< number of requests answered with STATUS_ERROR
+		uint64_t m_inputSize = 0;     //!< sum of the sizes of the payloads of the requests in bytes
+		uint64_t m_outputSize = 0;    //!< sum of the sizes of the payloads of the responses in bytes
+		double m_maxLatency = 0.0;    //!< highest latency in seconds
+		std::array<uint64_t, LATENCY_BUCKET_COUNT> m_latencyBuckets = {}; //!< histogram of the latencies
+	};
+
+	/**
+	*   response waiting to be sent
+	*/
+	struct Response
+	{
+		std::string m_header;                          //!< header of the frame
+		std::string m_payload;                         //!< payload of the frame, empty if it is in a memory file
+		int m_memoryFile = UnixSocket::NO_DESCRIPTOR;  //!< memory file with the payload, closed once it was sent with the first byte of the header
+		size_t m_sentSize = 0;                         //!< number of bytes of the header and the payload which were sent already
+		uint8_t m_op = 0;                              //!< type of the request
+		bool m_success = false;                        //!< whether the status is STATUS_OK
+		uint64_t m_inputSize = 0;                      //!< size of the payload of the request in bytes
+		uint64_t m_outputSize = 0;                     //!< size of the payload of the response in bytes
+		std::chrono::steady_clock::time_point m_start; //!< arrival of the first byte of the request
+	};
+
+	/**
+	*   connection of a client
+	*/
+	struct Connection
+	{
+		UnixSocket m_socket;                                //!< socket of the connection
+		std::string m_input;                                //!< received bytes which don't form a complete frame yet
+		std::vector<int> m_memoryFiles;                     //!< received memory files which belong to the frames in m_input
+		std::chrono::steady_clock::time_point m_frameStart; //!< arrival of the first byte of the frame at the beginning of m_input
+		std::deque<Response> m_responses;                   //!< responses waiting to be sent, in the order of the requests
+		bool m_receiving = true;                            //!< false once the client closed its side or sent an invalid frame
+		bool m_failed = false;                              //!< whether the connection broke and has to be closed
+	};
+
+	/**
+	*   complete request received from a connection
+	*/
+	struct Request
+	{
+		Connection* m_connection = nullptr;            //!< connection the response goes to
+		uint8_t m_op = 0;                              //!< type of the request
+		bool m_memoryFile = false;                     //!< whether the payload came in a memory file, so the response goes in one too
+		std::string m_payload;                         //!< payload of the request
+		std::string m_error;                           //!< reason why the request can't be processed, it is answered with STATUS_ERROR, empty if it is valid
+		std::chrono::steady_clock::time_point m_start; //!< arrival of the first byte of the request
+	};
+
+	const BWT_MTF_RLE_Huffman_Coder& m_coder; //!< coder whose parameters are used for all requests
+	BatchCoder m_batchCoder;                  //!< coder of the requests, it keeps the threads and workspaces between them
+
+	UnixSocket m_listener;                                     //!< socket at which the clients connect
+	std::string m_path;                                        //!< path of the socket file, removed when the server stops
+	std::array<int, 2> m_wakePipe = { UnixSocket::NO_DESCRIPTOR, UnixSocket::NO_DESCRIPTOR }; //!< pipe whose read end wakes up the poll loop, written by stop()
+	std::vector<std::unique_ptr<Connection>> m_connections;    //!< open connections
+	std::unique_ptr<char[]> m_receiveBuffer;                   //!< buffer of RECEIVE_CHUNK_SIZE bytes the connections are received into
+
+	std::chrono::steady_clock::time_point m_startTime; //!< start of the server
+	uint64_t m_connectionCount = 0;                    //!< number of accepted connections
+	uint64_t m_invalidFrameCount = 0;                  //!< number of frames which weren't valid requests
+	RequestStats m_encodeStats;                        //!< statistics of OP_ENCODE
+	RequestStats m_decodeStats;                        //!< statistics of OP_DECODE
+	RequestStats m_statsStats;                         //!< statistics of OP_STATS
+
+	/**
+	*   \brief Encodes the header of a frame
+	*   \param type type of the frame, OP_* for requests, STATUS_* for responses
+	*   \param flags combination of FRAME_* values
+	*   \param size size of the payload in bytes
+	*   \return encoded header
+	*/
+	std::string encodeFrameHeader(uint8_t type, uint8_t flags, uint64_t size) const;
+
+	/**
+	*   \brief Accepts all waiting connections
+	*/
+	void acceptConnections();
+
+	/**
+	*   \brief Receives everything available from a connection and splits it into requests
+	*   An invalid frame is answered with STATUS_ERROR and the connection stops receiving.
+	*   \param connection connection to receive from
+	*   \param requests complete requests get appended here
+	*/
+	void receiveRequests(Connection& connection, std::vector<Request>& requests);
+
+	/**
+	*   \brief Processes the requests and queues their responses, the encoded and the decoded ones in one batch each
+	*   \param requests requests to process, their payloads are moved out
+	*/
+	void processRequests(std::vector<Request>& requests);
+
+	/**
+	*   \brief Queues the response to a request
+	*   \param request request which is answered
+	*   \param status STATUS_OK or STATUS_ERROR
+	*   \param payload payload of the response
+	*   \param inputSize size of the payload of the request in bytes
+	*/
+	void queueResponse(const Request& request, uint8_t status, std::string&& payload, uint64_t inputSize);
+
+	/**
+	*   \brief Sends as many waiting responses of a connection as the socket takes
+	*   \param connection connection to send to
+	*/
+	void sendResponses(Connection& connection);
+
+	/**
+	*   \brief Adds a sent response to the statistics of the type of its request
+	*   \param response sent response
+	*/
+	void recordResponse(const Response& response);
+
+	/**
+	*   \brief Closes the memory files of a connection which weren't sent or used yet
+	*   \param connection connection which is closed
+	*/
+	void discardConnection(Connection& connection);
+
+	/**
+	*   \brief Writes the statistics of a type of requests
+	*   \param outputStream output stream
+	*   \param name name of the type of requests, the prefix of the written names
+	*   \param stats statistics of the requests
+	*/
+	void writeRequestStats(std::ostream& outputStream, const std::string& name, const RequestStats& stats) const;
+
+	/**
+	*   \brief Computes a percentile of the latencies from their histogram
+	*   \param stats statistics of the requests
+	*   \param fraction fraction of the requests, e.g. 0.99 for the 99th percentile
+	*   \return upper bound of the bucket which contains the percentile in seconds, 0 if there are no requests
+	*/
+	static double getLatencyPercentile(const RequestStats& stats, double fraction);
+
+public:
+
+	/**
+	*   \brief Sets up the batch coder and its threads for the parameters of the coder
+	*   \param coder coder whose parameters are used for all requests, it must outlive the server and mustn't change
+	*/
+	explicit CompressionServer(const BWT_MTF_RLE_Huffman_Coder& coder);
+
+	CompressionServer(const CompressionServer& other) = delete;
+
+	CompressionServer& operator=(const CompressionServer& other) = delete;
+
+	/**
+	*   \brief Closes all connections and removes the socket file
+	*/
+	~CompressionServer();
+
+	/**
+	*   \brief Creates the socket at which the clients connect
+	*   \param path path of the socket file
+	*   \return true on success, false if the socket couldn't be created or the server is already listening
+	*/
+	bool listen(const std::string& path);
+
+	/**
+	*   \brief Answers requests until stop() is called
+	*   \return true if the server was stopped, false on error
+	*/
+	bool run();
+
+	/**
+	*   \brief Makes run() return after the current batch, may be called from a signal handler or another thread
+	*/
+	void stop();
+
+	/**
+	*   \brief Writes the statistics of the server as lines in the format name = value
+	*   The latency of a request runs from the arrival of its first byte until the last byte of its response was sent.
+	*   \param outputStream output stream
+	*/
+	void writeStats(std::ostream& outputStream) const;
+};
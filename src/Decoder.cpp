@@ -0,0 +1,155 @@
+#include "Decoder.h"
+
+#include "MemoryBuffer.h"
+#include "StageTimer.h"
+
+#include <algorithm>
+
+Decoder::Decoder(const BWT_MTF_RLE_Huffman_Coder& coder, Sink sink)
+	: m_coder(coder), m_sink(std::move(sink))
+{
+	//blocks are decoded one by one, the block size is given by the stream, so the memory budget can't be enforced
+	m_log.m_threadCount = 1;
+	m_log.m_memoryBudget = coder.getMemoryBudget();
+}
+
+void Decoder::addReadTime(const StageLog& readLog)
+{
+	m_readLog.m_wallTime += readLog.m_wallTime;
+	m_readLog.m_CPUTime += readLog.m_CPUTime;
+	m_readLog.m_outputSize += readLog.m_outputSize;
+}
+
+bool Decoder::processBlock()
+{
+	//perform all the decoding steps on the block
+	BlockLog blockLog;
+	if (!m_coder.decodeBlock(m_streamHeader, m_blockHeader, m_buffer, m_output, blockLog, m_workspace, m_streamBlockCount, m_dedupCache)) return false;
+
+	//update decoded data size
+	m_log.m_uncodedSize += m_output.size();
+
+	//pass the decoded block on
+	StageTimer timer;
+	blockLog.m_stages[STAGE_IO] = m_readLog;
+	m_readLog = StageLog();
+	if (!m_sink(m_output.data(), m_output.size())) return false;
+
+	timer.stop(blockLog.m_stages[STAGE_IO], m_output.size());
+	m_log.m_blocks.push_back(blockLog);
+
+	return true;
+}
+
+bool Decoder::processPart()
+{
+	const StreamFormat& streamFormat = m_coder.m_streamFormat;
+
+	MemoryBuffer buffer(m_buffer);
+	std::istream partStream(&buffer);
+
+	//the coded size counts every part of the stream once it is complete
+	m_log.m_codedSize += m_buffer.size();
+
+	switch (m_state)
+	{
+	case STATE_STREAM_HEADER:
+		if (!streamFormat.readStreamHeader(partStream, m_streamHeader)) return false;
+		m_log.m_blockSize = std::max(m_log.m_blockSize, m_streamHeader.m_blockSize);
+		m_streamBlockCount = 0;
+		m_dedupCache.clear();
+		m_state = STATE_BLOCK_HEADER;
+		m_neededSize = streamFormat.getBlockHeaderSize(m_streamHeader);
+		break;
+	case STATE_BLOCK_HEADER:
+		if (!streamFormat.readBlockHeader(partStream, m_streamHeader, m_blockHeader)) return false;
+
+		//no more blocks, only the footer follows
+		if (m_blockHeader.m_flags & StreamFormat::BLOCK_END)
+		{
+			m_state = STATE_FOOTER_COUNT;
+			m_neededSize = sizeof(uint64_t);
+			break;
+		}
+
+		//the encoded block must fit into its maximum size, so that a corrupted header can't make us collect a huge buffer
+		if (m_blockHeader.m_codedSize > m_coder.getMaxCodedBlockSize(m_streamHeader, m_blockHeader.m_uncodedSize)) return false;
+		m_state = STATE_BLOCK;
+		m_neededSize = m_blockHeader.m_codedSize;
+		break;
+	case STATE_BLOCK:
+		if (!processBlock()) return false;
+		m_streamBlockCount++;
+		m_state = STATE_BLOCK_HEADER;
+		m_neededSize = streamFormat.getBlockHeaderSize(m_streamHeader);
+		break;
+	case STATE_FOOTER_COUNT:
+		//the index has an entry for every block, the count is checked before the rest of the footer is collected
+		if (decodeNumber(m_buffer) != m_streamBlockCount) return false;
+		m_log.m_codedSize -= m_buffer.size();
+		m_state = STATE_FOOTER;
+		m_neededSize = sizeof(uint64_t) + m_streamBlockCount * StreamFormat::INDEX_ENTRY_SIZE + StreamFormat::FOOTER_TRAILER_SIZE;
+		//the count stays in the buffer, because the footer is read as a whole
+		return true;
+	case STATE_FOOTER:
+		{
+			//the block index isn't needed for sequential decoding
+			std::vector<BlockIndexEntry> index;
+			if (!streamFormat.readFooter(partStream, index)) return false;
+			m_state = STATE_END;
+			m_neededSize = StreamFormat::STREAM_HEADER_SIZE;
+		}
+		break;
+	case STATE_END:
+		return false;
+	}
+
+	m_buffer.clear();
+
+	return true;
+}
+
+bool Decoder::write(const char* data, size_t size)
+{
+	if (m_failed) return false;
+
+	while (true)
+	{
+		//a part may be complete without new data, for example an empty block
+		if (m_state != STATE_END && m_buffer.size() == m_neededSize)
+		{
+			if (!processPart())
+			{
+				m_failed = true;
+				return false;
+			}
+
+			continue;
+		}
+
+		if (size == 0) break;
+
+		//only another stream may follow the footer
+		if (m_state == STATE_END)
+		{
+			m_state = STATE_STREAM_HEADER;
+		}
+
+		size_t count = static_cast<size_t>(std::min<uint64_t>(size, m_neededSize - m_buffer.size()));
+		m_buffer.append(data, count);
+		data += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool Decoder::finish()
+{
+	return !m_failed && m_state == STATE_END;
+}
+
+const Log& Decoder::getLog() const
+{
+	return m_log;
+}
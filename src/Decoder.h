@@ -0,0 +1,104 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "BWT_MTF_RLE_Huffman_Coder.h"
+
+/**
+*   Streaming decoder which is given the encoded stream piece by piece instead of reading it from a stream
+*
+*   Every block is decoded as soon as all its data has been written and the decoded block is passed to the sink.
+*   Streams written one after another, e.g. by concatenating encoded files, are decoded as a single one.
+*   BWT_MTF_RLE_Huffman_Coder::decode is implemented on top of this class.
+*   The coder must outlive the decoder.
+*/
+class Decoder : public Coder
+{
+public:
+
+	/**
+	*   receives the decoded data in order, returns false if the data couldn't be accepted
+	*/
+	using Sink = std::function<bool(const char* data, size_t size)>;
+
+private:
+
+	friend class BWT_MTF_RLE_Huffman_Coder;
+
+	/**
+	*   part of the encoded stream which is expected next
+	*/
+	enum State
+	{
+		STATE_STREAM_HEADER, //!< header of the stream
+		STATE_BLOCK_HEADER,  //!< header of a block or of the end of blocks
+		STATE_BLOCK,         //!< encoded data of a block
+		STATE_FOOTER_COUNT,  //!< number of blocks at the beginning of the footer
+		STATE_FOOTER,        //!< rest of the footer
+		STATE_END            //!< nothing or the header of another stream, the stream is complete
+	};
+
+	const BWT_MTF_RLE_Huffman_Coder& m_coder; //!< coder which decodes the blocks
+	Sink m_sink;                              //!< receives the decoded data
+
+	State m_state = STATE_STREAM_HEADER; //!< part of the stream being collected
+	std::string m_buffer;                //!< collected bytes of the current part
+	uint64_t m_neededSize = StreamFormat::STREAM_HEADER_SIZE; //!< number of bytes of the current part
+	StreamHeader m_streamHeader;         //!< describes the encoded stream
+	uint64_t m_streamBlockCount = 0;     //!< number of decoded blocks of the current stream, the log has the blocks of all streams
+	BlockHeader m_blockHeader;           //!< describes the current block
+	std::string m_output;                //!< decoded blocks are saved here
+	BWT_MTF_RLE_Huffman_Coder::Workspace m_workspace; //!< memory reused by the decoding of all blocks
+	DeduplicationCache<std::string> m_dedupCache{ StreamFormat::DEDUP_WINDOW }; //!< decoded blocks of the current stream which references can reach
+	StageLog m_readLog;                  //!< time of receiving the data of the current block
+	Log m_log;                           //!< log of the decoding process
+	bool m_failed = false;               //!< set on the first error, all later calls fail
+
+	/**
+	*   \brief Processes the collected part of the stream and chooses the next part
+	*   \return true on success, false if the part isn't valid or the decoded data couldn't be passed to the sink
+	*/
+	bool processPart();
+
+	/**
+	*   \brief Decodes the collected block and passes it to the sink
+	*   \return true on success, false on error
+	*/
+	bool processBlock();
+
+	/**
+	*   \brief Adds time spent by the caller on getting the data to the current block, used by BWT_MTF_RLE_Huffman_Coder::decode
+	*   \param readLog time of reading and the number of read bytes
+	*/
+	void addReadTime(const StageLog& readLog);
+
+public:
+
+	/**
+	*   \brief Prepares decoding of a stream
+	*   \param coder coder which decodes the blocks
+	*   \param sink receives the decoded data
+	*/
+	Decoder(const BWT_MTF_RLE_Huffman_Coder& coder, Sink sink);
+
+	/**
+	*   \brief Adds data of the encoded stream, every complete block is decoded and passed to the sink
+	*   \param data encoded data
+	*   \param size number of bytes of data
+	*   \return true on success, false if the stream isn't valid, isn't followed by another stream after its footer or the sink failed
+	*/
+	bool write(const char* data, size_t size);
+
+	/**
+	*   \brief Checks that the whole stream including its footer has been written
+	*   \return true if the stream and all streams which followed it are complete and no error occurred, false otherwise
+	*/
+	bool finish();
+
+	/**
+	*   \brief Returns the log of the decoding process
+	*   \return log of the decoding process
+	*/
+	const Log& getLog() const;
+};
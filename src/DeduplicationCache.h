@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+*   Blocks of a stream which a block with the BLOCK_REFERENCE flag may refer to, with a value kept for every block
+*
+*   The cache holds the most recently used blocks up to a total uncoded size, the least recently used are evicted first.
+*   Which blocks are in the cache depends only on the numbers and sizes of the inserted and used blocks, so the encoder,
+*   which keeps hashes, and the decoders, which keep decoded data, agree on the blocks a reference can reach without
+*   storing anything about it in the stream.
+*/
+template<typename T>
+class DeduplicationCache
+{
+private:
+
+	/**
+	*   block in the cache
+	*/
+	struct Entry
+	{
+		T m_value;                                //!< value kept for the block
+		uint64_t m_size = 0;                      //!< uncoded size of the block
+		std::list<uint64_t>::iterator m_position; //!< position of the block in m_order
+	};
+
+	uint64_t m_capacity;                            //!< maximum total uncoded size of the blocks in the cache
+	uint64_t m_size = 0;                            //!< total uncoded size of the blocks in the cache
+	std::list<uint64_t> m_order;                    //!< numbers of the blocks in the cache, the most recently used first
+	std::unordered_map<uint64_t, Entry> m_entries;  //!< blocks in the cache by their numbers
+
+public:
+
+	/**
+	*   \brief Constructor
+	*   \param capacity maximum total uncoded size of the blocks in the cache
+	*/
+	explicit DeduplicationCache(uint64_t capacity)
+		: m_capacity(capacity)
+	{
+	}
+
+	/**
+	*   \brief Removes all blocks, at the beginning of every stream
+	*/
+	void clear()
+	{
+		m_size = 0;
+		m_order.clear();
+		m_entries.clear();
+	}
+
+	/**
+	*   \brief Adds a block which isn't a reference as the most recently used one and evicts the least recently used blocks over the capacity
+	*   A block larger than the capacity is evicted right away
+	*   \param block number of the block in its stream
+	*   \param size uncoded size of the block
+	*   \param value value kept for the block
+	*   \param evicted values of the evicted blocks get added here
+	*/
+	void insert(uint64_t block, uint64_t size, T value, std::vector<T>& evicted)
+	{
+		m_order.push_front(block);
+		m_entries[block] = { std::move(value), size, m_order.begin() };
+		m_size += size;
+
+		while (m_size > m_capacity)
+		{
+			auto it = m_entries.find(m_order.back());
+			m_size -= it->second.m_size;
+			evicted.push_back(std::move(it->second.m_value));
+			m_entries.erase(it);
+			m_order.pop_back();
+		}
+	}
+
+	/**
+	*   \brief Finds a block for a reference and makes it the most recently used one
+	*   \param block number of the block in its stream
+	*   \param size uncoded size of the reference, which must match that of the block
+	*   \return value kept for the block, nullptr if the block isn't in the cache or its size doesn't match
+	*/
+	const T* use(uint64_t block, uint64_t size)
+	{
+		auto it = m_entries.find(block);
+		if (it == m_entries.end() || it->second.m_size != size) return nullptr;
+
+		m_order.splice(m_order.begin(), m_order, it->second.m_position);
+
+		return &it->second.m_value;
+	}
+};
@@ -0,0 +1,293 @@
+#include "Encoder.h"
+
+#include "CRC32C.h"
+#include "StageTimer.h"
+
+#include <algorithm>
+
+Encoder::Encoder(const BWT_MTF_RLE_Huffman_Coder& coder, Sink sink)
+	: m_coder(coder), m_sink(std::move(sink))
+{
+	coder.fitEncodeBudget(m_blockSize, m_threadCount, m_sorter);
+	m_threadPool = std::make_unique<ThreadPool>(m_threadCount);
+	m_streamHeader = coder.getStreamHeader(m_blockSize);
+	m_deduplication = (m_streamHeader.m_flags & StreamFormat::FLAG_DEDUP) != 0;
+	if (coder.m_minBlockSize > 0) m_splitter = std::make_unique<BlockSplitter>(coder.m_minBlockSize);
+
+	//initialize the log values
+	m_log.m_blockSize = m_blockSize;
+	m_log.m_threadCount = m_threadCount;
+	m_log.m_memoryBudget = coder.getMemoryBudget();
+
+	//the block size must fit into the block headers and large blocks can't have a search index
+	const uint16_t flags = m_streamHeader.m_flags;
+	if (m_blockSize == 0 || m_blockSize > coder.m_streamFormat.getMaxBlockSize(flags)) m_failed = true;
+	if ((flags & StreamFormat::FLAG_LARGE_BLOCKS) && (flags & StreamFormat::FLAG_SEARCH_INDEX)) m_failed = true;
+}
+
+bool Encoder::resume(const StreamHeader& streamHeader, const std::vector<BlockIndexEntry>& index, uint64_t streamOffset)
+{
+	if (m_started) return false;
+
+	//the blocks must fit into the block size of the existing stream, smaller blocks are allowed
+	m_blockSize = std::min(m_blockSize, streamHeader.m_blockSize);
+	m_streamHeader = streamHeader;
+	m_log.m_blockSize = m_blockSize;
+
+	//the parameters of the existing stream replace those of the coder, which were checked by the constructor
+	const uint16_t flags = streamHeader.m_flags;
+	m_failed = m_blockSize == 0 || m_blockSize > m_coder.m_streamFormat.getMaxBlockSize(flags);
+	if ((flags & StreamFormat::FLAG_LARGE_BLOCKS) && (flags & StreamFormat::FLAG_SEARCH_INDEX)) m_failed = true;
+	if (m_failed) return false;
+
+	m_index = index;
+	m_streamOffset = streamOffset;
+	m_deduplication = false;
+	m_started = true;
+
+	return true;
+}
+
+bool Encoder::output(const std::string& data)
+{
+	if (!m_sink(data.data(), data.size())) m_failed = true;
+
+	return !m_failed;
+}
+
+bool Encoder::start()
+{
+	if (m_failed || m_finished) return false;
+	if (m_started) return true;
+
+	m_started = true;
+
+	std::string header = m_coder.m_streamFormat.encodeStreamHeader(m_streamHeader);
+	m_log.m_codedSize += header.size();
+
+	return output(header);
+}
+
+void Encoder::addReadTime(const StageLog& readLog)
+{
+	m_readLog.m_wallTime += readLog.m_wallTime;
+	m_readLog.m_CPUTime += readLog.m_CPUTime;
+	m_readLog.m_outputSize += readLog.m_outputSize;
+}
+
+bool Encoder::submitBlock()
+{
+	//the next block is analyzed from its beginning
+	if (m_splitter) m_splitter->reset();
+
+	if (m_block.empty()) return true;
+
+	//update uncoded data size
+	m_log.m_uncodedSize += m_block.size();
+
+	m_pending.emplace_back();
+	PendingBlock& pending = m_pending.back();
+	pending.m_block = std::move(m_block);
+	pending.m_readLog = m_readLog;
+	m_block = std::string();
+	m_readLog = StageLog();
+
+	//perform all the encoding steps on the block, unless it repeats an earlier one
+	if (m_deduplication && deduplicate(pending))
+	{
+		//the uncoded data isn't needed any more
+		pending.m_block = std::string();
+	}
+	else
+	{
+		pending.m_result = m_threadPool->submit([this, &pending]()
+		{
+			return m_coder.encodeBlock(m_streamHeader, m_sorter, pending.m_block, pending.m_blockHeader, pending.m_blockLog);
+		});
+	}
+
+	//all threads have work while the number of blocks in memory stays bounded, the next block is being filled meanwhile
+	while (m_pending.size() >= 2 * m_threadCount)
+	{
+		if (!outputBlock()) return false;
+	}
+
+	return true;
+}
+
+bool Encoder::deduplicate(PendingBlock& pending)
+{
+	//the blocks before the pending ones are already in the index
+	const uint64_t blockNumber = m_index.size() + m_pending.size() - 1;
+	const uint64_t size = pending.m_block.size();
+
+	StageTimer timer;
+	const MurmurHash3::Hash hash = MurmurHash3::compute(pending.m_block);
+
+	auto it = m_dedupBlocks.find(hash);
+	if (it == m_dedupBlocks.end())
+	{
+		//the decoders keep the same blocks, because they insert and use them in the same order
+		std::vector<MurmurHash3::Hash> evicted;
+		m_dedupCache.insert(blockNumber, size, hash, evicted);
+		m_dedupBlocks[hash] = blockNumber;
+
+		for (const MurmurHash3::Hash& evictedHash : evicted)
+		{
+			m_dedupBlocks.erase(evictedHash);
+		}
+
+		timer.stop(pending.m_dedupLog, 0);
+		return false;
+	}
+
+	//a block of a different size with the same hash is encoded, but not kept, so that every hash stays unique in the cache
+	if (m_dedupCache.use(it->second, size) == nullptr)
+	{
+		timer.stop(pending.m_dedupLog, 0);
+		return false;
+	}
+
+	BlockHeader& blockHeader = pending.m_blockHeader;
+	blockHeader.m_flags = StreamFormat::BLOCK_REFERENCE;
+	blockHeader.m_uncodedSize = size;
+	blockHeader.m_codedSize = StreamFormat::REFERENCE_SIZE;
+
+	std::promise<std::string> result;
+	result.set_value(encodeNumber(it->second, StreamFormat::REFERENCE_SIZE));
+	pending.m_result = result.get_future();
+	timer.stop(pending.m_dedupLog, StreamFormat::REFERENCE_SIZE);
+
+	BlockLog& blockLog = pending.m_blockLog;
+	blockLog.m_uncodedSize = size;
+	blockLog.m_codedSize = StreamFormat::REFERENCE_SIZE;
+	blockLog.m_flags = blockHeader.m_flags;
+
+	//the checksum of the block itself, so that the decoder finds a collision of the hashes
+	if (m_streamHeader.m_flags & StreamFormat::FLAG_CHECKSUM)
+	{
+		StageTimer checksumTimer;
+		blockHeader.m_checksum = CRC32C::instance().compute(pending.m_block);
+		checksumTimer.stop(blockLog.m_stages[STAGE_CHECKSUM], sizeof(blockHeader.m_checksum));
+	}
+
+	return true;
+}
+
+bool Encoder::outputBlock()
+{
+	PendingBlock& pending = m_pending.front();
+	std::string block = pending.m_result.get();
+
+	StageTimer timer;
+	pending.m_blockLog.m_stages[STAGE_IO] = pending.m_readLog;
+	pending.m_blockLog.m_stages[STAGE_DEDUP] = pending.m_dedupLog;
+
+	//the header with the sizes of the block goes before the encoded block
+	std::string header = m_coder.m_streamFormat.encodeBlockHeader(m_streamHeader, pending.m_blockHeader);
+
+	m_index.push_back({ m_streamOffset + static_cast<uint64_t>(m_log.m_codedSize), pending.m_blockHeader.m_uncodedSize, pending.m_blockHeader.m_codedSize });
+
+	//update the size of encoded data in the log
+	m_log.m_codedSize += header.size() + block.size();
+
+	if (!output(header) || !output(block)) return false;
+
+	timer.stop(pending.m_blockLog.m_stages[STAGE_IO], header.size() + block.size());
+	m_log.m_blocks.push_back(pending.m_blockLog);
+	m_pending.pop_front();
+
+	return true;
+}
+
+bool Encoder::write(const char* data, size_t size)
+{
+	if (!start()) return false;
+
+	//the latency of a flush is measured from the oldest byte it writes out
+	if (size > 0 && !m_unflushed)
+	{
+		m_unflushed = true;
+		m_unflushedSince = std::chrono::steady_clock::now();
+	}
+	m_flushUncodedSize += size;
+
+	while (size > 0)
+	{
+		//the buffer grows with the data, so that a short input doesn't allocate a whole large block
+		size_t count = static_cast<size_t>(std::min<uint64_t>(size, m_blockSize - m_block.size()));
+		m_block.append(data, count);
+		data += count;
+		size -= count;
+
+		//the data after a shift of the content starts the next block, which may shift again
+		while (m_splitter)
+		{
+			uint64_t boundary = m_splitter->findBoundary(m_block);
+			if (boundary == 0) break;
+
+			std::string next = m_block.substr(static_cast<size_t>(boundary));
+			m_block.resize(static_cast<size_t>(boundary));
+			if (!submitBlock()) return false;
+			m_block = std::move(next);
+		}
+
+		if (m_block.size() == m_blockSize && !submitBlock()) return false;
+	}
+
+	return true;
+}
+
+bool Encoder::outputAll()
+{
+	if (!start() || !submitBlock()) return false;
+
+	//write the encoded blocks in their original order
+	while (!m_pending.empty())
+	{
+		if (!outputBlock()) return false;
+	}
+
+	return true;
+}
+
+bool Encoder::flush()
+{
+	if (!outputAll()) return false;
+
+	if (m_unflushed)
+	{
+		FlushLog flushLog;
+		flushLog.m_latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_unflushedSince).count();
+		flushLog.m_uncodedSize = m_flushUncodedSize;
+		flushLog.m_codedSize = m_log.m_codedSize - m_flushCodedStart;
+		m_log.m_flushes.push_back(flushLog);
+	}
+
+	m_unflushed = false;
+	m_flushUncodedSize = 0;
+	m_flushCodedStart = m_log.m_codedSize;
+
+	return true;
+}
+
+bool Encoder::finish()
+{
+	if (!outputAll()) return false;
+
+	m_finished = true;
+
+	//mark the end of blocks and write the footer with the block index
+	BlockHeader endHeader;
+	endHeader.m_flags = StreamFormat::BLOCK_END;
+	std::string footer = m_coder.m_streamFormat.encodeBlockHeader(m_streamHeader, endHeader) + m_coder.m_streamFormat.encodeFooter(m_index);
+
+	m_log.m_codedSize += footer.size();
+
+	return output(footer);
+}
+
+const Log& Encoder::getLog() const
+{
+	return m_log;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BWT_MTF_RLE_Huffman_Coder.h"
+#include "BlockSplitter.h"
+#include "MurmurHash3.h"
+#include "ThreadPool.h"
+
+/**
+*   Streaming encoder which is given the uncoded data piece by piece instead of reading it from a stream
+*
+*   The data is collected into blocks of the block size of the coder, or into shorter ones ended by BlockSplitter if the coder
+*   has a minimum block size. Complete blocks are encoded in parallel and the encoded stream is passed to the sink in order. The output is the same stream as written by
+*   BWT_MTF_RLE_Huffman_Coder::encode, which is implemented on top of this class.
+*   The coder must outlive the encoder and its parameters mustn't change while the encoder exists.
+*/
+class Encoder : public Coder
+{
+public:
+
+	/**
+	*   receives the encoded stream in order, returns false if the data couldn't be accepted
+	*/
+	using Sink = std::function<bool(const char* data, size_t size)>;
+
+private:
+
+	friend class BWT_MTF_RLE_Huffman_Coder;
+
+	/**
+	*   block submitted for encoding which hasn't been passed to the sink yet
+	*/
+	struct PendingBlock
+	{
+		std::string m_block;                 //!< uncoded data of the block
+		BlockHeader m_blockHeader;           //!< header of the encoded block, set by the encoding task
+		BlockLog m_blockLog;                 //!< statistics of the block, set by the encoding task
+		StageLog m_readLog;                  //!< time of receiving the data of the block, kept apart because encodeBlock resets the block log
+		StageLog m_dedupLog;                 //!< time of looking for an earlier identical block, kept apart like m_readLog
+		std::future<std::string> m_result;   //!< encoded block
+	};
+
+	const BWT_MTF_RLE_Huffman_Coder& m_coder; //!< coder which encodes the blocks
+	Sink m_sink;                              //!< receives the encoded stream
+
+	StreamHeader m_streamHeader;                                   //!< describes the encoded stream to the decoder
+	uint64_t m_blockSize = 0;                                      //!< block size which fits into the memory budget
+	unsigned m_threadCount = 0;                                    //!< number of threads which fits into the memory budget
+	BWTCoder::Sorter m_sorter = BWTCoder::Sorter::INDUCED_SORTING; //!< sorter of the BWT stage which fits into the memory budget
+	std::vector<BlockIndexEntry> m_index;                          //!< position and sizes of every written block, saved in the footer
+	uint64_t m_streamOffset = 0;                                   //!< size of the part of the stream written before this encoder, when continuing an existing stream
+	Log m_log;                                                     //!< log of the encoding process
+
+	std::string m_block;                  //!< block being filled
+	std::unique_ptr<BlockSplitter> m_splitter; //!< ends the block being filled where its content shifts, nullptr for blocks of fixed size
+	StageLog m_readLog;                   //!< time of receiving the data of the block being filled
+	std::deque<PendingBlock> m_pending;   //!< blocks being encoded in the order of the stream, references stay valid at both ends
+
+	bool m_deduplication = false;                                                      //!< whether repeated blocks are stored as references, only in new streams with FLAG_DEDUP
+	DeduplicationCache<MurmurHash3::Hash> m_dedupCache{ StreamFormat::DEDUP_WINDOW };   //!< hashes of the blocks which references can reach
+	std::unordered_map<MurmurHash3::Hash, uint64_t, MurmurHash3::Hasher> m_dedupBlocks; //!< numbers of the blocks in m_dedupCache by their hashes
+
+	bool m_unflushed = false;                              //!< set when data has been written since the last flush
+	std::chrono::steady_clock::time_point m_unflushedSince; //!< arrival of the oldest data written since the last flush
+	uint64_t m_flushUncodedSize = 0;                       //!< number of bytes written since the last flush
+	int64_t m_flushCodedStart = 0;                         //!< coded size of the stream at the last flush
+
+	bool m_started = false;  //!< set when the stream header has been passed to the sink
+	bool m_finished = false; //!< set when the footer has been passed to the sink
+	bool m_failed = false;   //!< set on the first error, all later calls fail
+
+	std::unique_ptr<ThreadPool> m_threadPool; //!< declared last, so that it finishes the running tasks before their blocks are destroyed
+
+	/**
+	*   \brief Passes data to the sink
+	*   \param data data of the encoded stream
+	*   \return true on success, false if the sink didn't accept the data
+	*/
+	bool output(const std::string& data);
+
+	/**
+	*   \brief Passes the stream header to the sink if it hasn't been passed yet
+	*   \return true on success, false on error
+	*/
+	bool start();
+
+	/**
+	*   \brief Submits the block being filled for encoding, if it isn't empty
+	*   If too many blocks are pending, the oldest are passed to the sink first
+	*   \return true on success, false on error
+	*/
+	bool submitBlock();
+
+	/**
+	*   \brief Looks for an earlier block identical to a pending block, which then becomes a reference to it
+	*   Otherwise the block is added to the blocks which later references can reach
+	*   \param pending newest pending block, not submitted for encoding yet
+	*   \return true if the block has become a reference and doesn't need to be encoded
+	*/
+	bool deduplicate(PendingBlock& pending);
+
+	/**
+	*   \brief Waits for the oldest pending block and passes it to the sink with its header
+	*   \return true on success, false on error
+	*/
+	bool outputBlock();
+
+	/**
+	*   \brief Submits the block being filled and passes all encoded blocks to the sink
+	*   \return true on success, false on error
+	*/
+	bool outputAll();
+
+	/**
+	*   \brief Adds time spent by the caller on getting the data to the block being filled, used by BWT_MTF_RLE_Huffman_Coder::encode
+	*   \param readLog time of reading and the number of read bytes
+	*/
+	void addReadTime(const StageLog& readLog);
+
+public:
+
+	/**
+	*   \brief Chooses the block size and the number of threads of the coder within its memory budget
+	*   Nothing is passed to the sink until the first call of write, flush or finish
+	*   \param coder coder which encodes the blocks, its parameters are used for the whole stream
+	*   \param sink receives the encoded stream
+	*/
+	Encoder(const BWT_MTF_RLE_Huffman_Coder& coder, Sink sink);
+
+	Encoder(const Encoder& other) = delete;
+
+	Encoder& operator=(const Encoder& other) = delete;
+
+	/**
+	*   \brief Continues an existing stream instead of starting a new one, must be called before write, flush and finish
+	*   The stream header isn't passed to the sink, the blocks are encoded with the block size and the flags of the existing stream
+	*   and the footer written by finish indexes the existing blocks too. The new blocks don't refer to earlier blocks, which aren't read. The sink must receive the data in place of the block
+	*   header with the BLOCK_END flag of the existing stream.
+	*   \param streamHeader header of the existing stream
+	*   \param index block index of the existing stream
+	*   \param streamOffset position of the block header with the BLOCK_END flag in the existing stream
+	*   \return true on success, false if the stream has already been started or its parameters can't be used
+	*/
+	bool resume(const StreamHeader& streamHeader, const std::vector<BlockIndexEntry>& index, uint64_t streamOffset);
+
+	/**
+	*   \brief Adds uncoded data to the stream, every full block is submitted for encoding
+	*   \param data uncoded data
+	*   \param size number of bytes of data
+	*   \return true on success, false on error or after finish
+	*/
+	bool write(const char* data, size_t size);
+
+	/**
+	*   \brief Ends the block being filled early and passes all encoded blocks to the sink
+	*   Everything written so far can then be decoded from the output, the stream goes on with a new block
+	*   If data was written since the last flush, the latency of its oldest byte is added to the flushes of the log
+	*   \return true on success, false on error or after finish
+	*/
+	bool flush();
+
+	/**
+	*   \brief Flushes the stream and passes the end of blocks and the footer to the sink
+	*   \return true on success, false on error or if the stream has already been finished
+	*/
+	bool finish();
+
+	/**
+	*   \brief Returns the log of the encoding process, which is complete after finish
+	*   \return log of the encoding process
+	*/
+	const Log& getLog() const;
+};
@@ -0,0 +1,95 @@
+#include "EntropyModel.h"
+
+#include "CRC32C.h"
+
+#include <algorithm>
+
+std::string EntropyModel::encodeCounts() const
+{
+	std::string output;
+	output.reserve((UCHAR_MAX + 1) * COUNT_SIZE);
+
+	for (uint32_t count : m_counts)
+	{
+		output += encodeNumber(count, COUNT_SIZE);
+	}
+
+	return output;
+}
+
+void EntropyModel::update()
+{
+	//0 marks blocks which store their own histogram
+	m_ID = std::max(CRC32C::instance().compute(encodeCounts()), uint32_t(1));
+
+	std::array<uint64_t, UCHAR_MAX + 1> histogram;
+	std::copy(m_counts.begin(), m_counts.end(), histogram.begin());
+	m_huffmanTree.build(histogram);
+}
+
+void EntropyModel::build(const std::array<uint64_t, UCHAR_MAX + 1>& histogram)
+{
+	uint64_t total = 0;
+	for (uint64_t count : histogram)
+	{
+		total += count;
+	}
+
+	//byte values missing in the sample still need a code, the scaling keeps the counts within COUNT_SIZE bytes
+	for (int i = 0; i <= UCHAR_MAX; ++i)
+	{
+		uint64_t count = (total == 0) ? 0 : static_cast<uint64_t>(static_cast<double>(histogram[i]) * COUNT_SCALE / total + 0.5);
+		m_counts[i] = static_cast<uint32_t>(std::max<uint64_t>(count, 1));
+	}
+
+	update();
+}
+
+bool EntropyModel::read(std::istream& inputStream)
+{
+	std::string data(FILE_SIZE, '\0');
+	inputStream.read(data.data(), FILE_SIZE);
+	if (inputStream.gcount() != FILE_SIZE) return false;
+
+	if (data.compare(0, MAGIC_SIZE, MAGIC, MAGIC_SIZE) != 0) return false;
+	if (decodeNumber(data.substr(MAGIC_SIZE, 1)) != VERSION) return false;
+
+	const size_t countsPosition = MAGIC_SIZE + 1 + sizeof(uint32_t);
+	for (int i = 0; i <= UCHAR_MAX; ++i)
+	{
+		m_counts[i] = static_cast<uint32_t>(decodeNumber(data.substr(countsPosition + i * COUNT_SIZE, COUNT_SIZE)));
+
+		//every byte value must have a code
+		if (m_counts[i] == 0) return false;
+	}
+
+	update();
+
+	//a damaged model would decode the blocks wrongly
+	return decodeNumber(data.substr(MAGIC_SIZE + 1, sizeof(uint32_t))) == m_ID;
+}
+
+bool EntropyModel::write(std::ostream& outputStream) const
+{
+	std::string output;
+	output.reserve(FILE_SIZE);
+
+	output.append(MAGIC, MAGIC_SIZE);
+	output += encodeNumber(VERSION, 1);
+	output += encodeNumber(m_ID, sizeof(uint32_t));
+	output += encodeCounts();
+
+	outputStream.write(output.data(), output.size());
+
+	return static_cast<bool>(outputStream);
+}
+
+uint32_t EntropyModel::getID() const
+{
+	return m_ID;
+}
+
+const HuffmanTree& EntropyModel::getHuffmanTree() const
+{
+	return m_huffmanTree;
+}
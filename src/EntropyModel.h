@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+
+#include "Coder.h"
+#include "HuffmanTree.h"
+
+/**
+*   Shared entropy model of the Huffman stage, trained on a sample corpus
+*
+*   Blocks encoded with the model store only its ID instead of their own histogram, which for small blocks is often bigger
+*   than the data it describes. The model gives every byte value a code, so any block can be encoded with it.
+*
+*   file: magic "BWTM", version (1 byte), ID (4 bytes), count of every byte value (4 bytes each), all in big-endian order
+*   The ID is CRC-32C of the counts, so that a decoder can tell whether it has the model a stream was encoded with.
+*/
+class EntropyModel : public Coder
+{
+public:
+
+	static constexpr char MAGIC[] = "BWTM"; //!< first bytes of every model file
+	static constexpr int MAGIC_SIZE = 4;    //!< size of the magic value in bytes
+	static constexpr uint8_t VERSION = 1;   //!< version of the file written by this implementation
+	static constexpr int COUNT_SIZE = sizeof(uint32_t); //!< size of a stored count in bytes
+	static constexpr int FILE_SIZE = MAGIC_SIZE + 1 + sizeof(uint32_t) + (UCHAR_MAX + 1) * COUNT_SIZE; //!< size of a model file in bytes
+
+	static constexpr uint64_t COUNT_SCALE = 1 << 16; //!< the trained counts are scaled to about this sum, which keeps the codes short
+
+private:
+
+	std::array<uint32_t, UCHAR_MAX + 1> m_counts = {}; //!< scaled number of occurences of every byte value, at least 1
+	uint32_t m_ID = 0;                                 //!< identifies the model in the block headers, 0 if the model is empty
+	HuffmanTree m_huffmanTree;                         //!< tree built from the counts
+
+	/**
+	*   \brief Encodes the counts as they are stored in the file
+	*   \return counts encoded as a string of bytes
+	*/
+	std::string encodeCounts() const;
+
+	/**
+	*   \brief Computes the ID and builds the Huffman tree from the counts
+	*/
+	void update();
+
+public:
+
+	/**
+	*   \brief Builds the model from the histogram of a sample, every byte value gets at least the count 1
+	*   \param histogram vector t where t[character] = number of occurences of character in the input of the Huffman stage
+	*/
+	void build(const std::array<uint64_t, UCHAR_MAX + 1>& histogram);
+
+	/**
+	*   \brief Reads and validates a model file
+	*   \param inputStream stream positioned at the beginning of the model
+	*   \return true on success, false if the model couldn't be read or isn't valid
+	*/
+	bool read(std::istream& inputStream);
+
+	/**
+	*   \brief Writes the model file
+	*   \param outputStream output stream
+	*   \return true on success, false on error
+	*/
+	bool write(std::ostream& outputStream) const;
+
+	/**
+	*   \brief Returns the ID stored in the headers of the blocks encoded with the model
+	*   \return ID of the model, never 0 once the model has been built or read
+	*/
+	uint32_t getID() const;
+
+	/**
+	*   \brief Returns the Huffman tree of the model
+	*   \return tree which has a leaf for every byte value
+	*/
+	const HuffmanTree& getHuffmanTree() const;
+};
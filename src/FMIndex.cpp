@@ -0,0 +1,259 @@
+#include "FMIndex.h"
+
+#include "BWTCoder.h"
+
+#include <algorithm>
+
+uint32_t FMIndex::occurences(unsigned char character, uint32_t row) const
+{
+	uint32_t checkpoint = row / OCC_INTERVAL; //last checkpoint at or before the row
+
+	uint32_t count = 0;
+	if (checkpoint > 0)
+	{
+		count = m_checkpoints[(checkpoint - 1) * (UCHAR_MAX + 1) + character];
+	}
+
+	//count the rest of the occurences between the checkpoint and the row
+	return count + std::count(m_bwt.begin() + checkpoint * OCC_INTERVAL, m_bwt.begin() + row, static_cast<char>(character));
+}
+
+uint32_t FMIndex::lastToFirst(uint32_t row) const
+{
+	//a row outside the block maps to itself, which is outside the block too
+	if (row >= m_bwt.size()) return row;
+
+	unsigned char character = m_bwt[row];
+
+	return m_firstRows[character] + occurences(character, row);
+}
+
+std::pair<uint32_t, uint32_t> FMIndex::findRows(const std::string& pattern) const
+{
+	uint32_t first = 0;
+	uint32_t last = m_bwt.size();
+
+	//extend the match by one character to the left at a time
+	for (auto it = pattern.rbegin(); it != pattern.rend() && first < last; ++it)
+	{
+		unsigned char character = *it;
+
+		first = m_firstRows[character] + occurences(character, first);
+		last = m_firstRows[character] + occurences(character, last);
+	}
+
+	if (first > last) last = first;
+
+	//rows outside the block can only come from a corrupted index, nothing is found then
+	if (last > m_bwt.size()) first = last = 0;
+
+	return { first, last };
+}
+
+uint64_t FMIndex::getMaxIndexSize(uint64_t size) const
+{
+	//header with all characters present, then the checkpoints and the samples
+	return 2 * sizeof(uint32_t) + sizeof(uint16_t) + (UCHAR_MAX + 1)
+		+ ((size / OCC_INTERVAL) * (UCHAR_MAX + 1) + (size + SAMPLE_RATE - 1) / SAMPLE_RATE) * sizeof(uint32_t);
+}
+
+std::string FMIndex::build(const std::string& bwt) const
+{
+	const std::string last = bwt.substr(BWTCoder::INDEX_SIZE); //last column of sorted permutation matrix
+	const uint32_t primaryIndex = decodeNumber(bwt.substr(0, BWTCoder::INDEX_SIZE));
+	const uint32_t size = last.size();
+
+	//compute histogram and the first row of the matrix for every character
+	std::array<uint32_t, UCHAR_MAX + 1> hist = {};
+	for (unsigned char ch : last)
+	{
+		hist[ch]++;
+	}
+
+	std::array<uint32_t, UCHAR_MAX + 1> firstRows = {};
+	for (int i = 1; i <= UCHAR_MAX; ++i)
+	{
+		firstRows[i] = firstRows[i - 1] + hist[i - 1];
+	}
+
+	//only the characters which are present in the block are stored in the checkpoints
+	std::string symbols;
+	for (int i = 0; i <= UCHAR_MAX; ++i)
+	{
+		if (hist[i] > 0) symbols += static_cast<char>(i);
+	}
+
+	std::string output;
+	output += encodeNumber(OCC_INTERVAL, sizeof(uint32_t));
+	output += encodeNumber(SAMPLE_RATE, sizeof(uint32_t));
+	output += encodeNumber(symbols.size(), sizeof(uint16_t));
+	output += symbols;
+
+	//compute the checkpoints and the mapping of every row to the row of the permutation which starts one position earlier
+	std::vector<uint32_t> lastToFirst(size);
+	std::array<uint32_t, UCHAR_MAX + 1> counts = {};
+
+	for (uint32_t row = 0; row < size; ++row)
+	{
+		if (row > 0 && row % OCC_INTERVAL == 0)
+		{
+			for (unsigned char symbol : symbols)
+			{
+				output += encodeNumber(counts[symbol], sizeof(uint32_t));
+			}
+		}
+
+		unsigned char character = last[row];
+		lastToFirst[row] = firstRows[character] + counts[character]++;
+	}
+
+	if (size > 0 && size % OCC_INTERVAL == 0)
+	{
+		for (unsigned char symbol : symbols)
+		{
+			output += encodeNumber(counts[symbol], sizeof(uint32_t));
+		}
+	}
+
+	//walk the block backwards from its first position and remember the row of every SAMPLE_RATE-th position
+	std::vector<uint32_t> sampledRows((size + SAMPLE_RATE - 1) / SAMPLE_RATE);
+
+	uint32_t row = primaryIndex;
+	for (uint32_t position = size; position > 0; --position)
+	{
+		if ((position % size) % SAMPLE_RATE == 0)
+		{
+			sampledRows[(position % size) / SAMPLE_RATE] = row;
+		}
+
+		row = lastToFirst[row];
+	}
+
+	for (uint32_t sampledRow : sampledRows)
+	{
+		output += encodeNumber(sampledRow, sizeof(uint32_t));
+	}
+
+	return output;
+}
+
+bool FMIndex::load(const std::string& bwt, const std::string& index)
+{
+	const size_t headerSize = 2 * sizeof(uint32_t) + sizeof(uint16_t);
+
+	if (bwt.size() < BWTCoder::INDEX_SIZE || index.size() < headerSize) return false;
+
+	m_bwt = bwt.substr(BWTCoder::INDEX_SIZE);
+	const uint32_t primaryIndex = decodeNumber(bwt.substr(0, BWTCoder::INDEX_SIZE));
+
+	const uint32_t size = m_bwt.size();
+	const uint32_t occInterval = decodeNumber(index.substr(0, sizeof(uint32_t)));
+	const uint32_t sampleRate = decodeNumber(index.substr(sizeof(uint32_t), sizeof(uint32_t)));
+	const uint32_t symbolCount = decodeNumber(index.substr(2 * sizeof(uint32_t), sizeof(uint16_t)));
+
+	//the index must have been built with the same parameters and must have the expected size
+	const uint64_t checkpointCount = size / OCC_INTERVAL;
+	const uint64_t sampleCount = (size + SAMPLE_RATE - 1) / SAMPLE_RATE;
+
+	if (occInterval != OCC_INTERVAL || sampleRate != SAMPLE_RATE || primaryIndex >= std::max<uint32_t>(size, 1)) return false;
+	if (index.size() != headerSize + symbolCount + (checkpointCount * symbolCount + sampleCount) * sizeof(uint32_t)) return false;
+
+	const std::string symbols = index.substr(headerSize, symbolCount);
+	size_t position = headerSize + symbolCount;
+
+	//expand the checkpoints to all characters
+	m_checkpoints.assign(checkpointCount * (UCHAR_MAX + 1), 0);
+	for (uint64_t checkpoint = 0; checkpoint < checkpointCount; ++checkpoint)
+	{
+		for (unsigned char symbol : symbols)
+		{
+			m_checkpoints[checkpoint * (UCHAR_MAX + 1) + symbol] = decodeNumber(index.substr(position, sizeof(uint32_t)));
+			position += sizeof(uint32_t);
+		}
+	}
+
+	//the checksum of the block doesn't cover the index, a wrong count would lead the backward search to rows outside the block,
+	//so every checkpoint must match the counts of the BWT
+	std::array<uint32_t, UCHAR_MAX + 1> counts = {};
+	for (uint64_t checkpoint = 0; checkpoint < checkpointCount; ++checkpoint)
+	{
+		for (uint32_t row = checkpoint * OCC_INTERVAL; row < (checkpoint + 1) * OCC_INTERVAL; ++row)
+		{
+			counts[static_cast<unsigned char>(m_bwt[row])]++;
+		}
+
+		if (!std::equal(counts.begin(), counts.end(), m_checkpoints.begin() + checkpoint * (UCHAR_MAX + 1))) return false;
+	}
+
+	m_samples.clear();
+	m_samples.reserve(sampleCount);
+	for (uint64_t sample = 0; sample < sampleCount; ++sample)
+	{
+		uint32_t row = decodeNumber(index.substr(position, sizeof(uint32_t)));
+		position += sizeof(uint32_t);
+
+		if (row >= size) return false;
+
+		m_samples.push_back({ row, static_cast<uint32_t>(sample * SAMPLE_RATE) });
+	}
+
+	std::sort(m_samples.begin(), m_samples.end());
+
+	//first row of the matrix for every character
+	std::array<uint32_t, UCHAR_MAX + 1> hist = {};
+	for (unsigned char ch : m_bwt)
+	{
+		hist[ch]++;
+	}
+
+	m_firstRows[0] = 0;
+	for (int i = 1; i <= UCHAR_MAX; ++i)
+	{
+		m_firstRows[i] = m_firstRows[i - 1] + hist[i - 1];
+	}
+
+	return true;
+}
+
+std::vector<uint32_t> FMIndex::locate(const std::string& pattern) const
+{
+	std::vector<uint32_t> positions;
+
+	const uint32_t size = m_bwt.size();
+	if (pattern.empty() || pattern.size() > size) return positions;
+
+	std::pair<uint32_t, uint32_t> rows = findRows(pattern);
+
+	for (uint32_t row = rows.first; row < rows.second; ++row)
+	{
+		//walk backwards through the block until a sampled position is reached
+		uint32_t current = row;
+		uint32_t steps = 0;
+
+		auto it = std::lower_bound(m_samples.begin(), m_samples.end(), std::make_pair(current, uint32_t(0)));
+		while ((it == m_samples.end() || it->first != current) && steps < SAMPLE_RATE)
+		{
+			//a row outside the block can only come from a corrupted index
+			if (current >= size) break;
+
+			current = lastToFirst(current);
+			steps++;
+			it = std::lower_bound(m_samples.begin(), m_samples.end(), std::make_pair(current, uint32_t(0)));
+		}
+
+		//a sampled position is always reached within SAMPLE_RATE steps, unless the index is corrupted
+		if (it == m_samples.end() || it->first != current) continue;
+
+		uint32_t position = (it->second + steps) % size;
+
+		//the permutation matrix contains rotations of the block, skip matches which wrap around its end
+		if (position + pattern.size() <= size)
+		{
+			positions.push_back(position);
+		}
+	}
+
+	std::sort(positions.begin(), positions.end());
+
+	return positions;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Coder.h"
+
+#include <array>
+#include <climits>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+*   FM-index of a single block, allows counting and locating substrings by backward search over the BWT of the block
+*
+*   The index is built from the output of BWTCoder and stored next to the encoded block. It contains:
+*   rank checkpoints - numbers of occurences of every character present in the block in the BWT before every OCC_INTERVAL-th row
+*   position samples - row of the sorted permutation matrix for every SAMPLE_RATE-th position of the block
+*   The BWT itself isn't stored, it is obtained by decoding the encoded block up to the BWT stage.
+*/
+class FMIndex : public Coder
+{
+private:
+
+	std::string m_bwt;                                    //!< last column of the sorted permutation matrix
+	std::array<uint32_t, UCHAR_MAX + 1> m_firstRows = {}; //!< m_firstRows[character] = first row of the matrix which starts with character
+	std::vector<uint32_t> m_checkpoints;                  //!< (UCHAR_MAX + 1) numbers of occurences of characters for each checkpoint
+	std::vector<std::pair<uint32_t, uint32_t>> m_samples; //!< sampled pairs (row, position in the block) ordered by row
+
+	/**
+	*   \brief Returns the number of occurences of a character in the BWT before the given row
+	*   \param character character to count
+	*   \param row row of the sorted permutation matrix
+	*   \return number of occurences of character in rows [0, row)
+	*/
+	uint32_t occurences(unsigned char character, uint32_t row) const;
+
+	/**
+	*   \brief Maps a row of the sorted permutation matrix to the row of the permutation which starts one position earlier
+	*   \param row row of the sorted permutation matrix
+	*   \return row of the permutation which starts one position earlier in the block, the given row if it is outside the block
+	*/
+	uint32_t lastToFirst(uint32_t row) const;
+
+	/**
+	*   \brief Finds the rows of the sorted permutation matrix which start with the pattern
+	*   \param pattern searched string
+	*   \return range [first, last) of the rows
+	*/
+	std::pair<uint32_t, uint32_t> findRows(const std::string& pattern) const;
+
+public:
+
+	static constexpr uint32_t OCC_INTERVAL = 8192; //!< number of rows between two rank checkpoints
+	static constexpr uint32_t SAMPLE_RATE = 64;    //!< number of positions in the block between two position samples
+
+	/**
+	*   \brief Returns the maximum size of the index of a block
+	*   \param size number of bytes of the block
+	*   \return maximum size of the index in bytes
+	*/
+	uint64_t getMaxIndexSize(uint64_t size) const;
+
+	/**
+	*   \brief Builds the index of a block
+	*   \param bwt output of BWTCoder::encode for the block
+	*   \return index encoded as a string of bytes
+	*/
+	std::string build(const std::string& bwt) const;
+
+	/**
+	*   \brief Loads the index of a block for searching
+	*   \param bwt output of BWTCoder::encode for the block
+	*   \param index index of the block created by build
+	*   \return true on success, false if the index doesn't match the BWT, including rank checkpoints which differ from the counts in the BWT
+	*/
+	bool load(const std::string& bwt, const std::string& index);
+
+	/**
+	*   \brief Finds all occurences of the pattern in the block
+	*   Occurences which would continue past the end of the block aren't reported
+	*   \param pattern searched string, must not be empty
+	*   \return positions of all occurences of the pattern in the block in ascending order
+	*/
+	std::vector<uint32_t> locate(const std::string& pattern) const;
+};
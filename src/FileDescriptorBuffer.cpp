@@ -0,0 +1,247 @@
+#include "FileDescriptorBuffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	/**
+	*   \brief Reads from a file descriptor with read(2) or its Windows equivalent
+	*   \param descriptor file descriptor
+	*   \param data read bytes get saved here
+	*   \param size maximum number of bytes to read
+	*   \return number of read bytes, 0 at the end of the file, -1 on error
+	*/
+	int64_t readDescriptor(int descriptor, char* data, unsigned size)
+	{
+#if defined(_WIN32)
+		return _read(descriptor, data, size);
+#else
+		return read(descriptor, data, size);
+#endif
+	}
+
+	/**
+	*   \brief Writes to a file descriptor with write(2) or its Windows equivalent
+	*   \param descriptor file descriptor
+	*   \param data bytes to write
+	*   \param size number of bytes to write
+	*   \return number of written bytes, -1 on error
+	*/
+	int64_t writeDescriptor(int descriptor, const char* data, unsigned size)
+	{
+#if defined(_WIN32)
+		return _write(descriptor, data, size);
+#else
+		return write(descriptor, data, size);
+#endif
+	}
+
+	/**
+	*   \brief Moves the position of a file descriptor with lseek(2) or its Windows equivalent
+	*   \param descriptor file descriptor
+	*   \param offset offset from the position given by whence
+	*   \param whence SEEK_SET, SEEK_CUR or SEEK_END
+	*   \return new position from the beginning of the file, -1 on error or if the descriptor isn't seekable
+	*/
+	int64_t seekDescriptor(int descriptor, int64_t offset, int whence)
+	{
+#if defined(_WIN32)
+		return _lseeki64(descriptor, offset, whence);
+#else
+		return lseek(descriptor, offset, whence);
+#endif
+	}
+}
+
+FileDescriptorBuffer::FileDescriptorBuffer(int descriptor, std::ios_base::openmode mode, size_t bufferSize)
+	: m_descriptor(descriptor)
+	, m_mode(mode)
+	, m_bufferSize(std::max<size_t>((bufferSize + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT, 1) * BUFFER_ALIGNMENT)
+	, m_buffer(new (std::align_val_t(BUFFER_ALIGNMENT)) char[m_bufferSize])
+{
+	if (m_mode & std::ios_base::out)
+	{
+		setp(m_buffer, m_buffer + m_bufferSize);
+	}
+	else
+	{
+		setg(m_buffer, m_buffer, m_buffer);
+	}
+}
+
+int FileDescriptorBuffer::getDescriptor() const
+{
+	return m_descriptor;
+}
+
+FileDescriptorBuffer::~FileDescriptorBuffer()
+{
+	if (m_mode & std::ios_base::out) flushBuffer();
+
+	operator delete[](m_buffer, std::align_val_t(BUFFER_ALIGNMENT));
+}
+
+std::streamsize FileDescriptorBuffer::readSome(char* data, std::streamsize size)
+{
+	while (true)
+	{
+		auto count = readDescriptor(m_descriptor, data, static_cast<unsigned>(std::min<std::streamsize>(size, MAX_TRANSFER_SIZE)));
+		if (count >= 0 || errno != EINTR) return count;
+	}
+}
+
+bool FileDescriptorBuffer::writeAll(const char* data, std::streamsize size)
+{
+	while (size > 0)
+	{
+		auto count = writeDescriptor(m_descriptor, data, static_cast<unsigned>(std::min<std::streamsize>(size, MAX_TRANSFER_SIZE)));
+
+		if (count < 0)
+		{
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		data += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool FileDescriptorBuffer::flushBuffer()
+{
+	if (!(m_mode & std::ios_base::out)) return true;
+
+	bool success = writeAll(pbase(), pptr() - pbase());
+	setp(m_buffer, m_buffer + m_bufferSize);
+
+	return success;
+}
+
+FileDescriptorBuffer::int_type FileDescriptorBuffer::underflow()
+{
+	if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+	if (!(m_mode & std::ios_base::in)) return traits_type::eof();
+
+	std::streamsize count = readSome(m_buffer, m_bufferSize);
+	if (count <= 0) return traits_type::eof();
+
+	setg(m_buffer, m_buffer, m_buffer + count);
+
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize FileDescriptorBuffer::xsgetn(char_type* data, std::streamsize count)
+{
+	//the buffered bytes come first
+	std::streamsize copied = std::min<std::streamsize>(count, egptr() - gptr());
+	std::memcpy(data, gptr(), copied);
+	gbump(static_cast<int>(copied));
+
+	while (copied < count)
+	{
+		//large reads go directly into the destination, without copying through the buffer
+		if (count - copied >= static_cast<std::streamsize>(m_bufferSize))
+		{
+			std::streamsize received = readSome(data + copied, count - copied);
+			if (received <= 0) break;
+			copied += received;
+		}
+		else
+		{
+			if (traits_type::eq_int_type(underflow(), traits_type::eof())) break;
+
+			std::streamsize part = std::min<std::streamsize>(count - copied, egptr() - gptr());
+			std::memcpy(data + copied, gptr(), part);
+			gbump(static_cast<int>(part));
+			copied += part;
+		}
+	}
+
+	return copied;
+}
+
+FileDescriptorBuffer::int_type FileDescriptorBuffer::overflow(int_type character)
+{
+	if (!(m_mode & std::ios_base::out) || !flushBuffer()) return traits_type::eof();
+
+	if (!traits_type::eq_int_type(character, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(character);
+		pbump(1);
+	}
+
+	return traits_type::not_eof(character);
+}
+
+std::streamsize FileDescriptorBuffer::xsputn(const char_type* data, std::streamsize count)
+{
+	if (!(m_mode & std::ios_base::out)) return 0;
+
+	if (count <= epptr() - pptr())
+	{
+		std::memcpy(pptr(), data, count);
+		pbump(static_cast<int>(count));
+		return count;
+	}
+
+	if (!flushBuffer()) return 0;
+
+	//large writes go directly from the source, without copying through the buffer
+	if (count >= static_cast<std::streamsize>(m_bufferSize))
+	{
+		return writeAll(data, count) ? count : 0;
+	}
+
+	std::memcpy(pptr(), data, count);
+	pbump(static_cast<int>(count));
+
+	return count;
+}
+
+int FileDescriptorBuffer::sync()
+{
+	return flushBuffer() ? 0 : -1;
+}
+
+FileDescriptorBuffer::pos_type FileDescriptorBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode)
+{
+	int whence = SEEK_SET;
+	if (direction == std::ios_base::cur) whence = SEEK_CUR;
+	if (direction == std::ios_base::end) whence = SEEK_END;
+
+	//the position of the file descriptor is ahead of the stream by the buffered input and behind it by the buffered output
+	if (m_mode & std::ios_base::out)
+	{
+		if (!flushBuffer()) return pos_type(off_type(-1));
+	}
+	else if (direction == std::ios_base::cur)
+	{
+		offset -= egptr() - gptr();
+	}
+
+	auto position = seekDescriptor(m_descriptor, offset, whence);
+	if (position < 0) return pos_type(off_type(-1));
+
+	//the buffered input doesn't belong to the new position
+	if (m_mode & std::ios_base::in) setg(m_buffer, m_buffer, m_buffer);
+
+	return pos_type(off_type(position));
+}
+
+FileDescriptorBuffer::pos_type FileDescriptorBuffer::seekpos(pos_type position, std::ios_base::openmode which)
+{
+	return seekoff(off_type(position), std::ios_base::beg, which);
+}
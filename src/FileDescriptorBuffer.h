@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <ios>
+#include <streambuf>
+
+/**
+*   Stream buffer which reads or writes a file descriptor directly with read(2) and write(2)
+*
+*   Used for the standard input and output instead of std::cin and std::cout, which are synchronized with stdio.
+*   Small transfers go through a large page-aligned buffer, transfers of at least the buffer size bypass it.
+*   Seeking is supported if the file descriptor is seekable, e.g. when a file is redirected to the standard input.
+*/
+class FileDescriptorBuffer : public std::streambuf
+{
+private:
+
+	static constexpr size_t BUFFER_ALIGNMENT = 1 << 12;  //!< alignment of the buffer, the usual page size
+	static constexpr size_t MAX_TRANSFER_SIZE = 1 << 30; //!< maximum number of bytes passed to a single read(2) or write(2)
+
+	int m_descriptor;               //!< file descriptor which is read or written, not owned
+	std::ios_base::openmode m_mode; //!< std::ios_base::in for reading, std::ios_base::out for writing
+	size_t m_bufferSize;            //!< size of the buffer in bytes
+	char* m_buffer;                 //!< buffer of m_bufferSize bytes
+
+	/**
+	*   \brief Reads at most the given number of bytes from the file descriptor, retries if interrupted by a signal
+	*   \param data read bytes get saved here
+	*   \param size maximum number of bytes to read
+	*   \return number of read bytes, 0 at the end of the file, -1 on error
+	*/
+	std::streamsize readSome(char* data, std::streamsize size);
+
+	/**
+	*   \brief Writes all given bytes to the file descriptor, continues after partial writes and signals
+	*   \param data bytes to write
+	*   \param size number of bytes to write
+	*   \return true on success, false on error
+	*/
+	bool writeAll(const char* data, std::streamsize size);
+
+	/**
+	*   \brief Writes the content of the buffer to the file descriptor and empties the buffer
+	*   \return true on success, false on error
+	*/
+	bool flushBuffer();
+
+protected:
+
+	int_type underflow() override;
+
+	std::streamsize xsgetn(char_type* data, std::streamsize count) override;
+
+	int_type overflow(int_type character) override;
+
+	std::streamsize xsputn(const char_type* data, std::streamsize count) override;
+
+	int sync() override;
+
+	pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override;
+
+	pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+public:
+
+	static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20; //!< size of the buffer in bytes if none is given
+
+	/**
+	*   \brief Creates the buffer
+	*   \param descriptor open file descriptor, it isn't closed by the buffer
+	*   \param mode std::ios_base::in for reading, std::ios_base::out for writing
+	*   \param bufferSize size of the buffer in bytes, rounded up to BUFFER_ALIGNMENT
+	*/
+	FileDescriptorBuffer(int descriptor, std::ios_base::openmode mode, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+	FileDescriptorBuffer(const FileDescriptorBuffer& other) = delete;
+
+	FileDescriptorBuffer& operator=(const FileDescriptorBuffer& other) = delete;
+
+	/**
+	*   \brief Gets the file descriptor which is read or written
+	*   \return file descriptor
+	*/
+	int getDescriptor() const;
+
+	/**
+	*   \brief Writes the remaining buffered bytes and frees the buffer
+	*/
+	~FileDescriptorBuffer() override;
+};
@@ -2,10 +2,10 @@
 
 #include <climits>
 
-std::array<uint32_t, UCHAR_MAX + 1> HuffmanCoder::computeHistogram(const std::string& str) const
+std::array<uint64_t, UCHAR_MAX + 1> HuffmanCoder::computeHistogram(const std::string& str) const
 {
 	//allocate space for histogram
-	std::array<uint32_t, UCHAR_MAX + 1> hist = {};
+	std::array<uint64_t, UCHAR_MAX + 1> hist = {};
 
 	//compute histogram
 	for (unsigned char ch : str)
@@ -16,27 +16,10 @@ std::array<uint32_t, UCHAR_MAX + 1> HuffmanCoder::computeHistogram(const std::st
 	return hist;
 }
 
-std::string HuffmanCoder::encode(const std::string& input) const
+void HuffmanCoder::encodeValues(const std::string& input, const HuffmanTree& huffmanTree, std::string& output) const
 {
-	std::string output;
-
-	//compute histogram from input string
-	std::array<uint32_t, UCHAR_MAX + 1> hist = computeHistogram(input);
-
-	//encode the histogram at the beginning of output
-	for (uint32_t histValue : hist)
-	{
-		output += encodeNumber(histValue, sizeof(uint32_t));
-	}
-
-	//encode the size of input string
-	output += encodeNumber(input.size(), sizeof(uint32_t));
-
-	//build Huffman tree from the histogram
-	HuffmanTree huffmanTree = HuffmanTree(hist);
-
 	//create mapping of characters to Huffman codes
-	const std::unordered_map<unsigned char, HuffmanCode>& codeMap = huffmanTree.getCodes();
+	const std::array<HuffmanCode, UCHAR_MAX + 1>& codeMap = huffmanTree.getCodes();
 
 	//encode the input using the mapping
 
@@ -46,17 +29,19 @@ std::string HuffmanCoder::encode(const std::string& input) const
 	//for all input values
 	for (unsigned char inputValue : input)
 	{
+		const HuffmanCode& huffmanCode = codeMap[inputValue];
+
 		if (index == 0) //add new byte at the end of output
 		{
-			output += codeMap.at(inputValue).m_code;
-			index = codeMap.at(inputValue).m_bitCount % CHAR_BIT;
+			output += huffmanCode.m_code;
+			index = huffmanCode.m_bitCount % CHAR_BIT;
 		}
 		else
 		{
-			int remainingBits = codeMap.at(inputValue).m_bitCount; //number of bits that need to be written to output
+			int remainingBits = huffmanCode.m_bitCount; //number of bits that need to be written to output
 
 			//for all bytes of Huffman code
-			for (unsigned char code : codeMap.at(inputValue).m_code)
+			for (unsigned char code : huffmanCode.m_code)
 			{
 				//add bits at the end of the last byte of output
 				output.back() += code >> index;
@@ -73,61 +58,95 @@ std::string HuffmanCoder::encode(const std::string& input) const
 					if (remainingBits < 0) remainingBits = 0;
 				}
 
-				index = (index + codeMap.at(inputValue).m_bitCount - remainingBits) % CHAR_BIT;
+				index = (index + huffmanCode.m_bitCount - remainingBits) % CHAR_BIT;
 			}
 		}
 	}
+}
 
-	return output;
+std::string HuffmanCoder::encode(const std::string& input) const
+{
+	return encode(input, COUNT_SIZE);
 }
 
-std::string HuffmanCoder::decode(const std::string& input) const
+std::string HuffmanCoder::encode(const std::string& input, int countSize) const
 {
-	//get histogram from the beginning of input
-	//allocate space for histogram
-	std::array<uint32_t, UCHAR_MAX + 1> hist;
-	for (int i = 0; i <= UCHAR_MAX; ++i)
+	HuffmanTree huffmanTree;
+
+	return encode(input, countSize, huffmanTree);
+}
+
+std::string HuffmanCoder::encode(const std::string& input, int countSize, HuffmanTree& huffmanTree) const
+{
+	std::string output;
+
+	//the codes are shorter than the input values unless the input is incompressible, the output grows only then
+	output.reserve((UCHAR_MAX + 2) * countSize + input.size());
+
+	//compute histogram from input string
+	std::array<uint64_t, UCHAR_MAX + 1> hist = computeHistogram(input);
+
+	//encode the histogram at the beginning of output
+	for (uint64_t histValue : hist)
 	{
-		hist[i] = decodeNumber(input.substr(i * sizeof(uint32_t), sizeof(uint32_t)));
+		output += encodeNumber(histValue, countSize);
 	}
 
+	//encode the size of input string
+	output += encodeNumber(input.size(), countSize);
+
 	//build Huffman tree from the histogram
-	HuffmanTree huffmanTree = HuffmanTree(hist);
+	huffmanTree.build(hist);
 
-	//read the number of bytes of uncoded data
-	uint32_t size = decodeNumber(input.substr((UCHAR_MAX + 1) * sizeof(uint32_t), sizeof(uint32_t)));
+	encodeValues(input, huffmanTree, output);
+
+	return output;
+}
 
+std::string HuffmanCoder::decodeValues(const std::string& input, size_t headerSize, uint64_t size, const HuffmanTree& huffmanTree) const
+{
 	//decode the output using Huffman tree
 
 	std::string output;
+
+	//every value takes at least one bit and there must be something to build the tree from, otherwise the input is corrupted
+	const HuffmanTreeNode* root = huffmanTree.getRoot();
+	const HuffmanTreeNode* node = root; //current Huffman tree node
+	if (node == nullptr || size > (input.size() - headerSize) * CHAR_BIT)
+	{
+		return output;
+	}
+
 	output.reserve(size);
 
-	int globalBit = ((UCHAR_MAX + 2) * sizeof(uint32_t)) * CHAR_BIT; //order of the current bit in the entire input
-	const HuffmanTreeNode* node = huffmanTree.getRoot(); //current Huffman tree node
-	while (output.size() < size) //while all values haven't been decoded
+	const std::vector<HuffmanTreeNode>& nodes = huffmanTree.getNodes();
+
+	uint64_t globalBit = headerSize * CHAR_BIT;                  //order of the current bit in the entire input
+	const uint64_t bitCount = uint64_t(input.size()) * CHAR_BIT; //number of bits of the entire input
+	while (output.size() < size && globalBit < bitCount) //while all values haven't been decoded
 	{
-		int byte = globalBit / CHAR_BIT; //order of the current byte of input
+		uint64_t byte = globalBit / CHAR_BIT; //order of the current byte of input
 		int localBit = globalBit % CHAR_BIT; //order of the current bit in the current byte
 
 		//determine if current bit is 1
 		bool one = (static_cast<unsigned char>(input[byte]) & (1 << (CHAR_BIT - 1 - localBit)) && 1);
 
 		//if current bit is 0 and current Huffman tree node has corresponding child
-		if (!one && node->m_zero != nullptr)
+		if (!one && node->m_zero != HuffmanTreeNode::NO_CHILD)
 		{
-			node = node->m_zero.get(); //move to the child
+			node = &nodes[node->m_zero]; //move to the child
 		}
 		//if current bit is 1 and current Huffman tree node has corresponding child
-		else if (one && node->m_one != nullptr)
+		else if (one && node->m_one != HuffmanTreeNode::NO_CHILD)
 		{
-			node = node->m_one.get(); //move to the child
+			node = &nodes[node->m_one]; //move to the child
 		}
 
 		//we reached a leaf node of the Huffman tree
-		if (node->m_zero == nullptr && node->m_one == nullptr)
+		if (node->m_zero == HuffmanTreeNode::NO_CHILD && node->m_one == HuffmanTreeNode::NO_CHILD)
 		{
 			output += *node->m_value; //send the value stored in the leaf node to output
-			node = huffmanTree.getRoot(); //go back to the root of Huffman tree
+			node = root; //go back to the root of Huffman tree
 		}
 
 		globalBit++; //go to the next bit of input
@@ -135,3 +154,94 @@ std::string HuffmanCoder::decode(const std::string& input) const
 
 	return output;
 }
+
+std::string HuffmanCoder::decode(const std::string& input) const
+{
+	return decode(input, COUNT_SIZE);
+}
+
+std::string HuffmanCoder::decode(const std::string& input, int countSize) const
+{
+	HuffmanTree huffmanTree;
+
+	return decode(input, countSize, huffmanTree);
+}
+
+std::string HuffmanCoder::decode(const std::string& input, int countSize, HuffmanTree& huffmanTree) const
+{
+	const size_t headerSize = (UCHAR_MAX + 2) * countSize; //size of the histogram and the number of encoded values
+
+	//the input must contain at least the histogram and the number of encoded values, otherwise it is corrupted
+	if (input.size() < headerSize)
+	{
+		return std::string();
+	}
+
+	//get histogram from the beginning of input
+	//allocate space for histogram
+	std::array<uint64_t, UCHAR_MAX + 1> hist;
+	for (int i = 0; i <= UCHAR_MAX; ++i)
+	{
+		hist[i] = decodeNumber(input.substr(i * countSize, countSize));
+	}
+
+	//build Huffman tree from the histogram
+	huffmanTree.build(hist);
+
+	//read the number of bytes of uncoded data
+	uint64_t size = decodeNumber(input.substr((UCHAR_MAX + 1) * countSize, countSize));
+
+	return decodeValues(input, headerSize, size, huffmanTree);
+}
+
+std::string HuffmanCoder::encodeShared(const std::string& input, int countSize, const HuffmanTree& sharedTree) const
+{
+	std::string output;
+	output.reserve(countSize + input.size());
+
+	//only the size of input string is stored, the decoder has the same tree
+	output += encodeNumber(input.size(), countSize);
+
+	encodeValues(input, sharedTree, output);
+
+	return output;
+}
+
+std::string HuffmanCoder::decodeShared(const std::string& input, int countSize, const HuffmanTree& sharedTree) const
+{
+	//the input must contain at least the number of encoded values, otherwise it is corrupted
+	if (input.size() < static_cast<size_t>(countSize))
+	{
+		return std::string();
+	}
+
+	uint64_t size = decodeNumber(input.substr(0, countSize));
+
+	return decodeValues(input, countSize, size, sharedTree);
+}
+
+uint64_t HuffmanCoder::getCodedBitCount(const std::array<uint64_t, UCHAR_MAX + 1>& histogram, const HuffmanTree& huffmanTree) const
+{
+	const std::array<HuffmanCode, UCHAR_MAX + 1>& codes = huffmanTree.getCodes();
+
+	uint64_t bitCount = 0;
+	for (int i = 0; i <= UCHAR_MAX; ++i)
+	{
+		bitCount += histogram[i] * codes[i].m_bitCount;
+	}
+
+	return bitCount;
+}
+
+uint64_t HuffmanCoder::getEncodedSize(const std::string& input, int countSize, HuffmanTree& huffmanTree) const
+{
+	std::array<uint64_t, UCHAR_MAX + 1> hist = computeHistogram(input);
+	huffmanTree.build(hist);
+
+	return (UCHAR_MAX + 2) * countSize + (getCodedBitCount(hist, huffmanTree) + CHAR_BIT - 1) / CHAR_BIT;
+}
+
+uint64_t HuffmanCoder::getSharedEncodedSize(const std::string& input, int countSize, const HuffmanTree& sharedTree) const
+{
+	return countSize + (getCodedBitCount(computeHistogram(input), sharedTree) + CHAR_BIT - 1) / CHAR_BIT;
+}
@@ -16,10 +16,41 @@ private:
 	*   \return vector t where t[character] = number of occurences of character in the input string,
 	*	        vector has values for all possible values of unsigned char type
 	*/
-	std::array<uint32_t, UCHAR_MAX + 1> computeHistogram(const std::string& str) const;
+	std::array<uint64_t, UCHAR_MAX + 1> computeHistogram(const std::string& str) const;
+
+	/**
+	*   \brief Appends the Huffman codes of all input values to the output
+	*   \param input input string (uncoded)
+	*   \param huffmanTree tree which has a code for every value of the input
+	*   \param output encoded values are appended here, it must end at a whole byte
+	*/
+	void encodeValues(const std::string& input, const HuffmanTree& huffmanTree, std::string& output) const;
+
+	/**
+	*   \brief Decodes the Huffman codes which follow the header of the input
+	*   \param input input string (encoded)
+	*   \param headerSize number of bytes in front of the codes
+	*   \param size number of values to decode
+	*   \param huffmanTree tree the values were encoded with
+	*   \return decoded string, shorter than size if the input is corrupted
+	*/
+	std::string decodeValues(const std::string& input, size_t headerSize, uint64_t size, const HuffmanTree& huffmanTree) const;
+
+	/**
+	*   \brief Computes the number of bits of the codes of all values of a histogram
+	*   \param histogram vector t where t[character] = number of occurences of character
+	*   \param huffmanTree tree which has a code for every character of the histogram
+	*   \return number of bits
+	*/
+	uint64_t getCodedBitCount(const std::array<uint64_t, UCHAR_MAX + 1>& histogram, const HuffmanTree& huffmanTree) const;
 
 public:
 
+	/**
+	*   size of every value of the histogram and of the number of encoded values stored in front of the encoded data in bytes
+	*/
+	static constexpr int COUNT_SIZE = sizeof(uint32_t);
+
 	/**
 	*   \brief Encodes the input string using static Huffman coding
 	*   \param input input string (uncoded)
@@ -27,10 +58,80 @@ public:
 	*/
 	std::string encode(const std::string& input) const override;
 
+	/**
+	*   \brief Encodes the input string using static Huffman coding
+	*   \param input input string (uncoded)
+	*   \param countSize size of the stored histogram values and number of encoded values in bytes, COUNT_SIZE or more for large inputs
+	*   \return encoded string
+	*/
+	std::string encode(const std::string& input, int countSize) const;
+
+	/**
+	*   \brief Encodes the input string using static Huffman coding
+	*   \param input input string (uncoded)
+	*   \param countSize size of the stored histogram values and number of encoded values in bytes, COUNT_SIZE or more for large inputs
+	*   \param huffmanTree tree which is rebuilt for the input, reusing it for many inputs saves its allocations
+	*   \return encoded string
+	*/
+	std::string encode(const std::string& input, int countSize, HuffmanTree& huffmanTree) const;
+
 	/**
 	*   \brief Decodes the input string using static Huffman coding
 	*   \param input input string (encoded)
 	*   \return decoded string
 	*/
 	std::string decode(const std::string& input) const override;
+
+	/**
+	*   \brief Decodes the input string using static Huffman coding
+	*   \param input input string (encoded)
+	*   \param countSize size of the stored histogram values and number of encoded values in bytes, the same as used for encoding
+	*   \return decoded string
+	*/
+	std::string decode(const std::string& input, int countSize) const;
+
+	/**
+	*   \brief Decodes the input string using static Huffman coding
+	*   \param input input string (encoded)
+	*   \param countSize size of the stored histogram values and number of encoded values in bytes, the same as used for encoding
+	*   \param huffmanTree tree which is rebuilt for the input, reusing it for many inputs saves its allocations
+	*   \return decoded string
+	*/
+	std::string decode(const std::string& input, int countSize, HuffmanTree& huffmanTree) const;
+
+	/**
+	*   \brief Encodes the input string using a Huffman tree which the decoder already has, so no histogram is stored
+	*   \param input input string (uncoded)
+	*   \param countSize size of the stored number of encoded values in bytes
+	*   \param sharedTree tree which has a code for every byte value, such as the tree of an EntropyModel
+	*   \return encoded string
+	*/
+	std::string encodeShared(const std::string& input, int countSize, const HuffmanTree& sharedTree) const;
+
+	/**
+	*   \brief Decodes the input string encoded by encodeShared
+	*   \param input input string (encoded)
+	*   \param countSize size of the stored number of encoded values in bytes, the same as used for encoding
+	*   \param sharedTree the tree used for encoding
+	*   \return decoded string
+	*/
+	std::string decodeShared(const std::string& input, int countSize, const HuffmanTree& sharedTree) const;
+
+	/**
+	*   \brief Computes the size of the output of encode without encoding
+	*   \param input input string (uncoded)
+	*   \param countSize size of the stored histogram values and number of encoded values in bytes
+	*   \param huffmanTree tree which is rebuilt for the input
+	*   \return number of bytes of the encoded string
+	*/
+	uint64_t getEncodedSize(const std::string& input, int countSize, HuffmanTree& huffmanTree) const;
+
+	/**
+	*   \brief Computes the size of the output of encodeShared without encoding
+	*   \param input input string (uncoded)
+	*   \param countSize size of the stored number of encoded values in bytes
+	*   \param sharedTree tree which has a code for every byte value
+	*   \return number of bytes of the encoded string
+	*/
+	uint64_t getSharedEncodedSize(const std::string& input, int countSize, const HuffmanTree& sharedTree) const;
 };
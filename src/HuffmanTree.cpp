@@ -33,97 +33,59 @@ bool operator>=(const HuffmanTreeNode& lhs, const HuffmanTreeNode& rhs)
 	return (lhs.m_count >= rhs.m_count);
 }
 
-std::unique_ptr<HuffmanTreeNode> HuffmanTree::copyTree(const std::unique_ptr<HuffmanTreeNode>& root) const
+void HuffmanTree::computeHuffmanCodes(int root)
 {
-	if (root == nullptr)
-	{
-		return nullptr;
-	}
-
-	std::unique_ptr<HuffmanTreeNode> newRoot = std::make_unique<HuffmanTreeNode>();
-	newRoot->m_value = root->m_value;
-	newRoot->m_count = root->m_count;
-	newRoot->m_zero = copyTree(root->m_zero);
-	newRoot->m_one = copyTree(root->m_one);
-
-	return newRoot;
-}
-
-void HuffmanTree::computeHuffmanCodes(const std::unique_ptr<HuffmanTreeNode>& root, HuffmanCode currentCode) 
-{
-	if (root == nullptr)
-	{
-		return;
-	}
+	const HuffmanTreeNode& node = m_nodes[root];
 
 	//we are not in a leaf node
-	if (root->m_zero != nullptr && root->m_one != nullptr)
+	if (node.m_zero != HuffmanTreeNode::NO_CHILD && node.m_one != HuffmanTreeNode::NO_CHILD)
 	{
-		//position of current bit in the last byte of currentCode (from the left), 0 if new byte needs to be added
-		int pos = currentCode.m_bitCount % CHAR_BIT;
+		//position of current bit in the last byte of the current code (from the left), 0 if new byte needs to be added
+		int pos = m_currentCode.m_bitCount % CHAR_BIT;
 
 		//add 0
-		HuffmanCode zeroCode = currentCode;
 		if (pos == 0) //new byte needs to be added (all 0s)
 		{
-			zeroCode.m_code.push_back(0);
+			m_currentCode.m_code.push_back(0);
 		}
-		zeroCode.m_bitCount++;
+		m_currentCode.m_bitCount++;
 
 		//continue in the zero subtree
-		computeHuffmanCodes(root->m_zero, zeroCode);
+		computeHuffmanCodes(node.m_zero);
 
-		//add 1
-		HuffmanCode oneCode = currentCode;
-		if (pos == 0) //new byte needs to be added (with 1 on the left)
-		{
-			oneCode.m_code.push_back(1 << (CHAR_BIT - 1));
-		}
-		else //add 1 to the end
-		{
-			oneCode.m_code.back() += (1 << (CHAR_BIT - 1 - pos));
-		}
-		oneCode.m_bitCount++;
+		//replace the 0 by 1
+		m_currentCode.m_code.back() += (1 << (CHAR_BIT - 1 - pos));
 
 		//continue in the one subtree
-		computeHuffmanCodes(root->m_one, oneCode);
+		computeHuffmanCodes(node.m_one);
+
+		//remove the bit again, so that the caller gets its code back
+		m_currentCode.m_code.back() -= (1 << (CHAR_BIT - 1 - pos));
+		if (pos == 0)
+		{
+			m_currentCode.m_code.pop_back();
+		}
+		m_currentCode.m_bitCount--;
 	}
 	//we are in a leaf node
 	else
 	{
-		//save the resulting Huffman code 
-		m_codes[*root->m_value] = currentCode;
+		//save the resulting Huffman code, the string keeps its memory from the previous tree
+		m_codes[*node.m_value] = m_currentCode;
 	}
 }
 
-HuffmanTree::HuffmanTree(const std::array<uint32_t, UCHAR_MAX + 1>& histogram)
+HuffmanTree::HuffmanTree(const std::array<uint64_t, UCHAR_MAX + 1>& histogram)
 {
 	build(histogram);
 }
 
-HuffmanTree::HuffmanTree(const HuffmanTree& other)
-	: m_root(copyTree(other.m_root))
-	, m_codes(other.m_codes)
-{
-}
-
-HuffmanTree& HuffmanTree::operator=(const HuffmanTree& other)
-{
-	if (this == &other)
-	{
-		return *this;
-	}
-
-	m_root = copyTree(other.m_root);
-	m_codes = other.m_codes;
-
-	return *this;
-}
-
-void HuffmanTree::build(const std::array<uint32_t, UCHAR_MAX + 1>& histogram)
+void HuffmanTree::build(const std::array<uint64_t, UCHAR_MAX + 1>& histogram)
 {
-	std::vector<std::unique_ptr<HuffmanTreeNode>> nodes;  //vector of nodes which haven't been connected yet
-	nodes.reserve(UCHAR_MAX + 1);
+	m_nodes.clear();
+	m_nodes.reserve(MAX_NODE_COUNT);
+	m_queue.clear();
+	m_queue.reserve(UCHAR_MAX + 1);
 
 	//create leaf nodes for all possible characters of unsigned char type
 	for (int i = 0; i <= UCHAR_MAX; ++i)
@@ -131,64 +93,78 @@ void HuffmanTree::build(const std::array<uint32_t, UCHAR_MAX + 1>& histogram)
 		if (histogram[i] == 0) continue;  //don't create leaf nodes for characters which have 0 occurences
 
 		//create a leaf node for a given character
-		std::unique_ptr<HuffmanTreeNode> newNode = std::make_unique<HuffmanTreeNode>();
-		newNode->m_zero = nullptr;
-		newNode->m_one = nullptr;
-		newNode->m_value = i;
-		newNode->m_count = histogram[i];
-		nodes.push_back(std::move(newNode));
+		HuffmanTreeNode newNode;
+		newNode.m_value = i;
+		newNode.m_count = histogram[i];
+		m_queue.push_back(static_cast<int>(m_nodes.size()));
+		m_nodes.push_back(newNode);
 	}
 
 	//sort the leaf nodes in ascending order according to the number of occurences of each character
-	std::sort(nodes.begin(), nodes.end(), [](const std::unique_ptr<HuffmanTreeNode>& node1, const std::unique_ptr<HuffmanTreeNode>& node2) 
+	std::sort(m_queue.begin(), m_queue.end(), [this](int node1, int node2)
 	{
-		return *node1 < *node2;
+		return m_nodes[node1] < m_nodes[node2];
 	});
 
 	//while all nodes haven't been joined
-	while (nodes.size() > 1)
+	while (m_queue.size() > 1)
 	{
-		//create a new node, it's children will be the first two nodes from the vector (they have the smallest number of occurences of their characters)
-		std::unique_ptr<HuffmanTreeNode> newNode = std::make_unique<HuffmanTreeNode>();
-		newNode->m_zero = std::move(nodes[0]);
-		newNode->m_one = std::move(nodes[1]);
+		//create a new node, it's children will be the first two nodes from the queue (they have the smallest number of occurences of their characters)
+		HuffmanTreeNode newNode;
+		newNode.m_zero = m_queue[0];
+		newNode.m_one = m_queue[1];
 		//the new node will have a number of occurences equal to the sum of numbers of occurences of it's children
-		newNode->m_count = newNode->m_zero->m_count + newNode->m_one->m_count;
-		//erase these two children from the vector
-		nodes.erase(nodes.begin(), nodes.begin() + 2);
+		newNode.m_count = m_nodes[newNode.m_zero].m_count + m_nodes[newNode.m_one].m_count;
+		//erase these two children from the queue
+		m_queue.erase(m_queue.begin(), m_queue.begin() + 2);
 
-		//insert the new node to it's proper place in the vector (according to it's number of occurences)
-		auto it = std::find_if(nodes.begin(), nodes.end(), [&newNode](const std::unique_ptr<HuffmanTreeNode>& node)
+		//insert the new node to it's proper place in the queue (according to it's number of occurences)
+		auto it = std::find_if(m_queue.begin(), m_queue.end(), [this, &newNode](int node)
 		{
-			return *node >= *newNode;
+			return m_nodes[node] >= newNode;
 		});
-		nodes.insert(it, std::move(newNode));
+		m_queue.insert(it, static_cast<int>(m_nodes.size()));
+		m_nodes.push_back(newNode);
 	}
 
-	//the last remaining node in the vector is the root of the Huffman tree
-	m_root = std::move(nodes[0]);
-
-	//compute the mapping of characters to Huffman codes 
+	//compute the mapping of characters to Huffman codes, the last node is the root
 	computeHuffmanCodes();
 }
 
-const std::unordered_map<unsigned char, HuffmanCode>& HuffmanTree::getCodes() const
+const std::array<HuffmanCode, UCHAR_MAX + 1>& HuffmanTree::getCodes() const
 {
 	return m_codes;
 }
 
 const HuffmanTreeNode* HuffmanTree::getRoot() const
 {
-	return m_root.get();
+	//the histogram was empty, so is the tree
+	if (m_nodes.empty())
+	{
+		return nullptr;
+	}
+
+	return &m_nodes.back();
+}
+
+const std::vector<HuffmanTreeNode>& HuffmanTree::getNodes() const
+{
+	return m_nodes;
 }
 
 void HuffmanTree::computeHuffmanCodes() 
 {
-	m_codes.clear();
+	for (HuffmanCode& code : m_codes)
+	{
+		code.m_code.clear();
+		code.m_bitCount = 0;
+	}
 
 	//compute the mapping of characters to Huffman codes 
-	HuffmanCode startCode;
-	computeHuffmanCodes(m_root, startCode);
+	if (!m_nodes.empty())
+	{
+		m_currentCode.m_code.clear();
+		m_currentCode.m_bitCount = 0;
+		computeHuffmanCodes(static_cast<int>(m_nodes.size()) - 1);
+	}
 }
-
-
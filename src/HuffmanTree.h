@@ -1,9 +1,8 @@
 #pragma once
 
 #include <array>
+#include <climits>
 #include <cstdint>
-#include <unordered_map>
-#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -16,10 +15,12 @@ struct HuffmanCode
 
 struct HuffmanTreeNode
 {
-	std::unique_ptr<HuffmanTreeNode> m_zero; //!< pointer to a child along the 0 edge
-	std::unique_ptr<HuffmanTreeNode> m_one;  //!< pointer to a child along the 1 edge
-	std::optional<unsigned char> m_value;    //!< if it is a leaf node, character is stored here
-	uint32_t m_count = 0;                    //!< sum of the numbers of occurences of characters which are stored in the leaf nodes of the subtree rooted in this node
+	static constexpr int NO_CHILD = -1; //!< value of a child index of a leaf node
+
+	int m_zero = NO_CHILD;                //!< index of a child along the 0 edge in the nodes of the tree
+	int m_one = NO_CHILD;                 //!< index of a child along the 1 edge in the nodes of the tree
+	std::optional<unsigned char> m_value; //!< if it is a leaf node, character is stored here
+	uint64_t m_count = 0;                 //!< sum of the numbers of occurences of characters which are stored in the leaf nodes of the subtree rooted in this node
 };
 
 //comparisons of Huffman tree nodes based on their count values
@@ -36,10 +37,18 @@ bool operator>(const HuffmanTreeNode& lhs, const HuffmanTreeNode& rhs);
 
 bool operator>=(const HuffmanTreeNode& lhs, const HuffmanTreeNode& rhs);
 
+/**
+*   Huffman tree stored in a single array of nodes, children are referenced by their index
+*
+*   Building the tree again reuses the memory of the previous tree, so a tree which is kept
+*   by the caller doesn't allocate anything when it is built for many small inputs
+*/
 class HuffmanTree
 {
 public:
 
+	static constexpr int MAX_NODE_COUNT = 2 * (UCHAR_MAX + 1) - 1; //!< number of nodes of a tree with leaves for all characters
+
 	HuffmanTree() = default;
 
 	/**
@@ -47,30 +56,20 @@ public:
 	*   \param histogram vector t where t[character] = number of occurences of character, 
 	*		             vector has elements for all possible values of unsigned char type
 	*/
-	explicit HuffmanTree(const std::array<uint32_t, UCHAR_MAX + 1>& histogram);
-
-	HuffmanTree(const HuffmanTree& other);
-
-	HuffmanTree(HuffmanTree&& other) = default;
-
-	HuffmanTree& operator=(const HuffmanTree& other);
-
-	HuffmanTree& operator=(HuffmanTree&& other) = default;
-
-	~HuffmanTree() = default;
+	explicit HuffmanTree(const std::array<uint64_t, UCHAR_MAX + 1>& histogram);
 
 	/**
-	*   \brief Constructs Huffman tree from histogram
+	*   \brief Constructs Huffman tree from histogram, replacing the previous tree
 	*   \param histogram vector t where t[character] = number of occurences of character,
 	*		             vector has elements for all possible values of unsigned char type
 	*/
-	void build(const std::array<uint32_t, UCHAR_MAX + 1>& histogram);
+	void build(const std::array<uint64_t, UCHAR_MAX + 1>& histogram);
 
 	/**
 	*   \brief Returns the mapping of characters to Huffman codes
-	*   \return mapping of characters to Huffman codes
+	*   \return array t where t[character] = Huffman code of character, characters which aren't in the tree have codes with 0 bits
 	*/
-	const std::unordered_map<unsigned char, HuffmanCode>& getCodes() const;
+	const std::array<HuffmanCode, UCHAR_MAX + 1>& getCodes() const;
 
 	/**
 	*   \brief Returns a const pointer to the root of the tree or nullptr if tree is empty
@@ -78,17 +77,18 @@ public:
 	*/
 	const HuffmanTreeNode* getRoot() const;
 
-private:
-
-	std::unique_ptr<HuffmanTreeNode> m_root;                     //!< pointer to the root node of this Huffman tree
-	std::unordered_map<unsigned char, HuffmanCode> m_codes;      //!< mapping of characters to Huffman codes
-
 	/**
-	*   \brief Performs a deep copy of a Huffman tree
-	*   \param root pointer to the root node of the Huffman tree which is to be copied
-	*   \return pointer to the root node of the newly created copy
+	*   \brief Returns all nodes of the tree, the children of a node are found by their indices
+	*   \return nodes of the tree
 	*/
-	std::unique_ptr<HuffmanTreeNode> copyTree(const std::unique_ptr<HuffmanTreeNode>& root) const;
+	const std::vector<HuffmanTreeNode>& getNodes() const;
+
+private:
+
+	std::vector<HuffmanTreeNode> m_nodes;           //!< leaf nodes followed by inner nodes, the root is the last node
+	std::array<HuffmanCode, UCHAR_MAX + 1> m_codes; //!< mapping of characters to Huffman codes
+	std::vector<int> m_queue;                       //!< indices of the nodes which haven't been connected yet, kept to reuse its memory
+	HuffmanCode m_currentCode;                      //!< the Huffman code of the current path is created here during recursive traversal
 
 	/**
 	*   \brief Computes the mapping of characters to Huffman codes by recursively traversing this Huffman tree
@@ -97,8 +97,8 @@ private:
 
 	/**
 	*   \brief Computes the mapping of characters to Huffman codes by recursively traversing a Huffman subtree
-	*   \param root pointer to the root node of a Huffman subtree
-	*   \param currentCode the Huffman code of the current path is created here during recursive traversal of a Huffman subtree
+	*   The code of the path to the root of the subtree is in m_currentCode, which is restored on return
+	*   \param root index of the root node of a Huffman subtree
 	*/
-	void computeHuffmanCodes(const std::unique_ptr<HuffmanTreeNode>& root, HuffmanCode currentCode);
+	void computeHuffmanCodes(int root);
 };
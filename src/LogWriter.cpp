@@ -0,0 +1,263 @@
+#include "LogWriter.h"
+
+#include "StreamFormat.h"
+
+#include <algorithm>
+#include <cmath>
+
+LogWriter::Distribution LogWriter::getDistribution(std::vector<double>& values)
+{
+	Distribution distribution;
+	if (values.empty()) return distribution;
+
+	std::sort(values.begin(), values.end());
+
+	//nearest rank, the smallest value which isn't exceeded by the given fraction of values
+	auto percentile = [&values](double fraction)
+	{
+		size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+		return values[std::max<size_t>(rank, 1) - 1];
+	};
+
+	distribution.m_min = values.front();
+	distribution.m_p50 = percentile(0.5);
+	distribution.m_p99 = percentile(0.99);
+
+	return distribution;
+}
+
+LogWriter::StageSummary LogWriter::getStageSummary(const Log& log, Stage stage)
+{
+	StageSummary summary;
+	std::vector<double> wallTimes;
+
+	for (const BlockLog& block : log.m_blocks)
+	{
+		const StageLog& stageLog = block.m_stages[stage];
+
+		//skipped stages aren't counted, so that they don't distort the distribution
+		if (stageLog.m_wallTime == 0.0 && stageLog.m_outputSize == 0) continue;
+
+		summary.m_total.m_wallTime += stageLog.m_wallTime;
+		summary.m_total.m_CPUTime += stageLog.m_CPUTime;
+		summary.m_total.m_outputSize += stageLog.m_outputSize;
+		summary.m_blockCount++;
+		summary.m_inputSize += block.m_uncodedSize;
+		wallTimes.push_back(stageLog.m_wallTime);
+	}
+
+	summary.m_blockWallTime = getDistribution(wallTimes);
+
+	return summary;
+}
+
+LogWriter::Distribution LogWriter::getBlockWallTime(const Log& log)
+{
+	std::vector<double> wallTimes;
+
+	for (const BlockLog& block : log.m_blocks)
+	{
+		double wallTime = 0.0;
+		for (const StageLog& stageLog : block.m_stages)
+		{
+			wallTime += stageLog.m_wallTime;
+		}
+
+		wallTimes.push_back(wallTime);
+	}
+
+	return getDistribution(wallTimes);
+}
+
+LogWriter::DedupSummary LogWriter::getDedupSummary(const Log& log)
+{
+	DedupSummary summary;
+
+	for (const BlockLog& block : log.m_blocks)
+	{
+		if (!(block.m_flags & StreamFormat::BLOCK_REFERENCE)) continue;
+
+		summary.m_blockCount++;
+		summary.m_savedSize += block.m_uncodedSize;
+	}
+
+	if (!log.m_blocks.empty()) summary.m_hitRate = static_cast<double>(summary.m_blockCount) / log.m_blocks.size();
+
+	return summary;
+}
+
+LogWriter::Distribution LogWriter::getFlushLatency(const Log& log)
+{
+	std::vector<double> latencies;
+
+	for (const FlushLog& flush : log.m_flushes)
+	{
+		latencies.push_back(flush.m_latency);
+	}
+
+	return getDistribution(latencies);
+}
+
+double LogWriter::getThroughput(uint64_t size, double time)
+{
+	return (time > 0.0) ? size / time / 1e6 : 0.0;
+}
+
+std::string LogWriter::getStageList(uint8_t flags)
+{
+	if (flags & StreamFormat::BLOCK_RAW) return "raw";
+	if (flags & StreamFormat::BLOCK_REFERENCE) return "reference";
+
+	std::string stages = "BWT";
+	if (!(flags & StreamFormat::BLOCK_SKIP_MTF)) stages += ",MTF";
+	if (!(flags & StreamFormat::BLOCK_SKIP_RLE0)) stages += ",RLE";
+	stages += ",Huffman";
+
+	return stages;
+}
+
+void LogWriter::writeText(std::ostream& outputStream, const Log& log) const
+{
+	outputStream << "uncodedSize = " << log.m_uncodedSize << "\n";
+	outputStream << "codedSize = " << log.m_codedSize << "\n";
+	outputStream << "blockSize = " << log.m_blockSize << "\n";
+	outputStream << "threadCount = " << log.m_threadCount << "\n";
+	outputStream << "memoryBudget = " << log.m_memoryBudget << "\n";
+	outputStream << "peakMemory = " << log.m_peakMemory << "\n";
+	outputStream << "wallTime = " << log.m_wallTime << "\n";
+	outputStream << "CPUTime = " << log.m_CPUTime << "\n";
+	outputStream << "throughput = " << getThroughput(log.m_uncodedSize, log.m_wallTime) << "\n";
+
+	//latency of the flushes of partial blocks
+	if (!log.m_flushes.empty())
+	{
+		Distribution flushLatency = getFlushLatency(log);
+		outputStream << "flushCount = " << log.m_flushes.size() << "\n";
+		outputStream << "flushLatency = " << flushLatency.m_min << "/" << flushLatency.m_p50 << "/" << flushLatency.m_p99 << "\n";
+	}
+
+	//statistics of the processed blocks and the stages used for each of them
+	if (log.m_blocks.empty()) return;
+
+	size_t rawCount = 0;
+	size_t skippedMTFCount = 0;
+	size_t skippedRLE0Count = 0;
+
+	for (const BlockLog& block : log.m_blocks)
+	{
+		if (block.m_flags & StreamFormat::BLOCK_RAW) rawCount++;
+		if (block.m_flags & StreamFormat::BLOCK_SKIP_MTF) skippedMTFCount++;
+		if (block.m_flags & StreamFormat::BLOCK_SKIP_RLE0) skippedRLE0Count++;
+	}
+
+	DedupSummary dedup = getDedupSummary(log);
+
+	outputStream << "blockCount = " << log.m_blocks.size() << "\n";
+	outputStream << "rawBlocks = " << rawCount << "\n";
+	outputStream << "skippedMTF = " << skippedMTFCount << "\n";
+	outputStream << "skippedRLE0 = " << skippedRLE0Count << "\n";
+	outputStream << "dedupBlocks = " << dedup.m_blockCount << "\n";
+	outputStream << "dedupHitRate = " << dedup.m_hitRate << "\n";
+	outputStream << "dedupSavedSize = " << dedup.m_savedSize << "\n";
+
+	Distribution blockWallTime = getBlockWallTime(log);
+	outputStream << "blockWallTime = " << blockWallTime.m_min << "/" << blockWallTime.m_p50 << "/" << blockWallTime.m_p99 << "\n";
+
+	for (int stage = 0; stage < STAGE_COUNT; ++stage)
+	{
+		StageSummary summary = getStageSummary(log, static_cast<Stage>(stage));
+		if (summary.m_blockCount == 0) continue;
+
+		outputStream << "stage " << STAGE_NAMES[stage] << ": blockCount = " << summary.m_blockCount
+			<< ", wallTime = " << summary.m_total.m_wallTime << ", CPUTime = " << summary.m_total.m_CPUTime
+			<< ", outputSize = " << summary.m_total.m_outputSize
+			<< ", throughput = " << getThroughput(summary.m_inputSize, summary.m_total.m_wallTime)
+			<< ", blockWallTime = " << summary.m_blockWallTime.m_min << "/" << summary.m_blockWallTime.m_p50 << "/" << summary.m_blockWallTime.m_p99 << "\n";
+	}
+
+	for (size_t i = 0; i < log.m_blocks.size(); ++i)
+	{
+		const BlockLog& block = log.m_blocks[i];
+
+		outputStream << "block " << i << ": uncodedSize = " << block.m_uncodedSize << ", codedSize = " << block.m_codedSize
+			<< ", stages = " << getStageList(block.m_flags) << ", BWTEntropy = " << block.m_BWTEntropy << ", MTFEntropy = " << block.m_MTFEntropy
+			<< ", zeroRuns = " << block.m_zeroRuns << ", escapes = " << block.m_escapes << "\n";
+	}
+}
+
+void LogWriter::writeJSON(std::ostream& outputStream, const Log& log) const
+{
+	auto writeDistribution = [&outputStream](const Distribution& distribution)
+	{
+		outputStream << "{\"min\": " << distribution.m_min << ", \"p50\": " << distribution.m_p50 << ", \"p99\": " << distribution.m_p99 << "}";
+	};
+
+	outputStream << "{\n";
+	outputStream << "  \"uncodedSize\": " << log.m_uncodedSize << ",\n";
+	outputStream << "  \"codedSize\": " << log.m_codedSize << ",\n";
+	outputStream << "  \"blockSize\": " << log.m_blockSize << ",\n";
+	outputStream << "  \"threadCount\": " << log.m_threadCount << ",\n";
+	outputStream << "  \"memoryBudget\": " << log.m_memoryBudget << ",\n";
+	outputStream << "  \"peakMemory\": " << log.m_peakMemory << ",\n";
+	outputStream << "  \"wallTime\": " << log.m_wallTime << ",\n";
+	outputStream << "  \"CPUTime\": " << log.m_CPUTime << ",\n";
+	outputStream << "  \"throughput\": " << getThroughput(log.m_uncodedSize, log.m_wallTime) << ",\n";
+	outputStream << "  \"flushCount\": " << log.m_flushes.size() << ",\n";
+	outputStream << "  \"flushLatency\": ";
+	writeDistribution(getFlushLatency(log));
+	outputStream << ",\n";
+	outputStream << "  \"blockCount\": " << log.m_blocks.size() << ",\n";
+
+	DedupSummary dedup = getDedupSummary(log);
+	outputStream << "  \"dedupBlocks\": " << dedup.m_blockCount << ",\n";
+	outputStream << "  \"dedupHitRate\": " << dedup.m_hitRate << ",\n";
+	outputStream << "  \"dedupSavedSize\": " << dedup.m_savedSize << ",\n";
+	outputStream << "  \"blockWallTime\": ";
+	writeDistribution(getBlockWallTime(log));
+	outputStream << ",\n";
+
+	//every stage is listed, even if no block went through it, so that the readers of the log don't need to check for missing keys
+	outputStream << "  \"stages\": {\n";
+	for (int stage = 0; stage < STAGE_COUNT; ++stage)
+	{
+		StageSummary summary = getStageSummary(log, static_cast<Stage>(stage));
+
+		outputStream << "    \"" << STAGE_NAMES[stage] << "\": {\"blockCount\": " << summary.m_blockCount
+			<< ", \"wallTime\": " << summary.m_total.m_wallTime << ", \"CPUTime\": " << summary.m_total.m_CPUTime
+			<< ", \"outputSize\": " << summary.m_total.m_outputSize
+			<< ", \"throughput\": " << getThroughput(summary.m_inputSize, summary.m_total.m_wallTime)
+			<< ", \"blockWallTime\": ";
+		writeDistribution(summary.m_blockWallTime);
+		outputStream << "}" << (stage + 1 < STAGE_COUNT ? "," : "") << "\n";
+	}
+	outputStream << "  },\n";
+
+	outputStream << "  \"blocks\": [";
+	for (size_t i = 0; i < log.m_blocks.size(); ++i)
+	{
+		const BlockLog& block = log.m_blocks[i];
+
+		outputStream << (i > 0 ? ",\n" : "\n") << "    {\"uncodedSize\": " << block.m_uncodedSize << ", \"codedSize\": " << block.m_codedSize
+			<< ", \"stages\": \"" << getStageList(block.m_flags) << "\", \"BWTEntropy\": " << block.m_BWTEntropy << ", \"MTFEntropy\": " << block.m_MTFEntropy
+			<< ", \"zeroRuns\": " << block.m_zeroRuns << ", \"escapes\": " << block.m_escapes << ", \"wallTime\": {";
+
+		for (int stage = 0; stage < STAGE_COUNT; ++stage)
+		{
+			outputStream << (stage > 0 ? ", " : "") << "\"" << STAGE_NAMES[stage] << "\": " << block.m_stages[stage].m_wallTime;
+		}
+
+		outputStream << "}}";
+	}
+	outputStream << (log.m_blocks.empty() ? "],\n" : "\n  ],\n");
+
+	outputStream << "  \"flushes\": [";
+	for (size_t i = 0; i < log.m_flushes.size(); ++i)
+	{
+		const FlushLog& flush = log.m_flushes[i];
+
+		outputStream << (i > 0 ? ",\n" : "\n") << "    {\"latency\": " << flush.m_latency << ", \"uncodedSize\": " << flush.m_uncodedSize
+			<< ", \"codedSize\": " << flush.m_codedSize << "}";
+	}
+	outputStream << (log.m_flushes.empty() ? "]\n" : "\n  ]\n");
+	outputStream << "}\n";
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "StreamCoder.h"
+
+/**
+*   Writes the log of the encoding/decoding process as plain text or as JSON
+*
+*   Besides the totals, the log contains the wall time, CPU time and output size of every stage summed over all blocks,
+*   the throughput of every stage and the distribution (min, median, 99th percentile) of the time of a stage per block
+*   and of the latency of the flushes
+*/
+class LogWriter
+{
+private:
+
+	/**
+	*   minimum, median and 99th percentile of a set of values
+	*/
+	struct Distribution
+	{
+		double m_min = 0.0; //!< smallest value
+		double m_p50 = 0.0; //!< median
+		double m_p99 = 0.0; //!< 99th percentile
+	};
+
+	/**
+	*   statistics of a stage over all blocks
+	*/
+	struct StageSummary
+	{
+		StageLog m_total;             //!< time and output size summed over all blocks
+		uint64_t m_blockCount = 0;    //!< number of blocks which went through the stage
+		uint64_t m_inputSize = 0;     //!< uncoded size of the blocks which went through the stage in bytes
+		Distribution m_blockWallTime; //!< distribution of the wall time of the stage per block
+	};
+
+	/**
+	*   statistics of the blocks stored as references to earlier identical blocks
+	*/
+	struct DedupSummary
+	{
+		uint64_t m_blockCount = 0; //!< number of references
+		double m_hitRate = 0.0;    //!< fraction of all blocks which are references
+		uint64_t m_savedSize = 0;  //!< uncoded size of the references in bytes, which didn't go through the stages
+	};
+
+	/**
+	*   \brief Computes the distribution of a set of values using the nearest-rank method
+	*   \param values values, they get sorted
+	*   \return distribution of the values, all 0 for no values
+	*/
+	static Distribution getDistribution(std::vector<double>& values);
+
+	/**
+	*   \brief Computes the statistics of a stage over all blocks of the log
+	*   \param log log of the encoding/decoding process
+	*   \param stage stage to summarize
+	*   \return statistics of the stage
+	*/
+	static StageSummary getStageSummary(const Log& log, Stage stage);
+
+	/**
+	*   \brief Computes the distribution of the total time of a block, summed over all its stages
+	*   \param log log of the encoding/decoding process
+	*   \return distribution of the wall time per block
+	*/
+	static Distribution getBlockWallTime(const Log& log);
+
+	/**
+	*   \brief Computes the statistics of the references over all blocks of the log
+	*   \param log log of the encoding/decoding process
+	*   \return statistics of the references
+	*/
+	static DedupSummary getDedupSummary(const Log& log);
+
+	/**
+	*   \brief Computes the distribution of the latency of the flushes
+	*   \param log log of the encoding process
+	*   \return distribution of the latency per flush
+	*/
+	static Distribution getFlushLatency(const Log& log);
+
+	/**
+	*   \brief Computes the throughput
+	*   \param size number of processed bytes
+	*   \param time time in seconds
+	*   \return throughput in MB/s, 0 if no time was measured
+	*/
+	static double getThroughput(uint64_t size, double time);
+
+	/**
+	*   \brief Returns the list of stages used for a block
+	*   \param flags block flags, combination of StreamFormat::BLOCK_* values
+	*   \return comma separated names of the stages, "raw" for raw blocks, "reference" for references to earlier blocks
+	*/
+	static std::string getStageList(uint8_t flags);
+
+public:
+
+	/**
+	*   \brief Writes the log as lines in the format name = value
+	*   \param outputStream output stream
+	*   \param log log of the encoding/decoding process
+	*/
+	void writeText(std::ostream& outputStream, const Log& log) const;
+
+	/**
+	*   \brief Writes the log as a single JSON object
+	*   \param outputStream output stream
+	*   \param log log of the encoding/decoding process
+	*/
+	void writeJSON(std::ostream& outputStream, const Log& log) const;
+};
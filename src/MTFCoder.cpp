@@ -1,36 +1,32 @@
 #include "MTFCoder.h"
 
 #include <algorithm>
+#include <array>
 #include <climits>
+#include <numeric>
 
 std::string MTFCoder::encode(const std::string& input) const
 {
-	//allocate space for alphabet
-	std::string alphabet;
-	alphabet.reserve(UCHAR_MAX + 1);
-
-	//the alphabet contains all possible characters of unsigned char type
-	for (int i = 0; i <= UCHAR_MAX; ++i)
-	{
-		alphabet += i;
-	}
+	//the alphabet contains all possible characters of unsigned char type, it lives on the stack, so short inputs don't pay for allocating it
+	std::array<unsigned char, UCHAR_MAX + 1> alphabet;
+	std::iota(alphabet.begin(), alphabet.end(), 0);
 
 	//allocate space for output
 	std::string output;
 	output.reserve(input.size());
 
 	//for all input characters
-	for (uint32_t i = 0; i < input.size(); ++i)
+	for (size_t i = 0; i < input.size(); ++i)
 	{
 		//find current input character in the alphabet
-		std::string::iterator it = std::find(alphabet.begin(), alphabet.end(), input[i]);
+		unsigned char c = static_cast<unsigned char>(input[i]);
+		auto it = std::find(alphabet.begin(), alphabet.end(), c);
 
-		output += it - alphabet.begin(); //output the number of characters which precede the current input character in the alphabet
+		output += static_cast<char>(it - alphabet.begin()); //output the number of characters which precede the current input character in the alphabet
 
 		//move the current input character to the beginning of the alphabet
-		char c = *it;
-		alphabet.erase(it);
-		alphabet.insert(alphabet.begin(), c);
+		std::copy_backward(alphabet.begin(), it, it + 1);
+		alphabet[0] = c;
 	}
 
 	return output;
@@ -38,30 +34,25 @@ std::string MTFCoder::encode(const std::string& input) const
 
 std::string MTFCoder::decode(const std::string& input) const
 {
-	//allocate space for alphabet
-	std::string alphabet;
-	alphabet.reserve(UCHAR_MAX + 1);
-
 	//the alphabet contains all possible characters of unsigned char type
-	for (int i = 0; i <= UCHAR_MAX; ++i)
-	{
-		alphabet += i;
-	}
+	std::array<unsigned char, UCHAR_MAX + 1> alphabet;
+	std::iota(alphabet.begin(), alphabet.end(), 0);
 
 	//allocate space for output
 	std::string output;
 	output.reserve(input.size());
 
 	//for all input characters
-	for (uint32_t i = 0; i < input.size(); ++i)
+	for (size_t i = 0; i < input.size(); ++i)
 	{
 		//the input value is the number of characters which precede the corresponding decoded character in the alphabet
 		unsigned char index = static_cast<unsigned char>(input[i]);
-		output += alphabet[index];
+		unsigned char c = alphabet[index];
+		output += static_cast<char>(c);
 
 		//move the decoded character to the beginning of the alphabet
-		alphabet.erase(index, 1);
-		alphabet.insert(alphabet.begin(), output[i]);
+		std::copy_backward(alphabet.begin(), alphabet.begin() + index, alphabet.begin() + index + 1);
+		alphabet[0] = c;
 	}
 
 	return output;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <streambuf>
+#include <string>
+
+/**
+*   Read-only stream buffer over bytes already in memory, so that they can be parsed by StreamFormat without copying them
+*/
+class MemoryBuffer : public std::streambuf
+{
+public:
+
+	/**
+	*   \brief Makes the whole string readable
+	*   \param data bytes to read, must outlive the buffer
+	*/
+	explicit MemoryBuffer(const std::string& data)
+	{
+		char* begin = const_cast<char*>(data.data());
+		setg(begin, begin, begin + data.size());
+	}
+};
@@ -0,0 +1,195 @@
+#include "MemoryUsage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> currentUsage(0); //number of currently allocated bytes
+	std::atomic<uint64_t> peakUsage(0);    //highest number of allocated bytes
+
+	/**
+	*   \brief Allocates memory and accounts it
+	*   The size of the allocation and the size of the header are stored right in front of the returned pointer
+	*   \param size number of bytes requested by the caller
+	*   \param alignment required alignment of the returned pointer
+	*   \return pointer to the allocated memory or nullptr on failure
+	*/
+	void* allocate(size_t size, size_t alignment)
+	{
+		const size_t headerSize = std::max(alignof(std::max_align_t), alignment);
+
+		void* memory = nullptr;
+		if (alignment <= alignof(std::max_align_t))
+		{
+			memory = std::malloc(headerSize + size);
+		}
+		else
+		{
+			//aligned_alloc requires the size to be a multiple of the alignment
+			memory = std::aligned_alloc(alignment, (headerSize + size + alignment - 1) / alignment * alignment);
+		}
+
+		if (memory == nullptr) return nullptr;
+
+		size_t* header = reinterpret_cast<size_t*>(static_cast<char*>(memory) + headerSize);
+		header[-1] = size;
+		header[-2] = headerSize;
+
+		uint64_t usage = currentUsage.fetch_add(size, std::memory_order_relaxed) + size;
+		uint64_t peak = peakUsage.load(std::memory_order_relaxed);
+		while (usage > peak && !peakUsage.compare_exchange_weak(peak, usage, std::memory_order_relaxed))
+		{
+		}
+
+		return header;
+	}
+
+	/**
+	*   \brief Allocates memory and accounts it, throws std::bad_alloc on failure
+	*   \param size number of bytes requested by the caller
+	*   \param alignment required alignment of the returned pointer
+	*   \return pointer to the allocated memory
+	*/
+	void* allocateOrThrow(size_t size, size_t alignment)
+	{
+		void* pointer = allocate(size, alignment);
+		if (pointer == nullptr) throw std::bad_alloc();
+
+		return pointer;
+	}
+
+	/**
+	*   \brief Frees memory allocated by allocate
+	*   \param pointer pointer returned by allocate or nullptr
+	*/
+	void release(void* pointer)
+	{
+		if (pointer == nullptr) return;
+
+		size_t* header = static_cast<size_t*>(pointer);
+		currentUsage.fetch_sub(header[-1], std::memory_order_relaxed);
+
+		std::free(static_cast<char*>(pointer) - header[-2]);
+	}
+}
+
+uint64_t MemoryUsage::getCurrent()
+{
+	return currentUsage.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryUsage::getPeak()
+{
+	return peakUsage.load(std::memory_order_relaxed);
+}
+
+void MemoryUsage::resetPeak()
+{
+	peakUsage.store(currentUsage.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+//replacements of the global allocation functions
+
+void* operator new(size_t size)
+{
+	return allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size)
+{
+	return allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+*   Accounts the heap memory of the whole program
+*
+*   The global operator new and operator delete are replaced in MemoryUsage.cpp, every allocation is prefixed
+*   by its size, so that it can be subtracted again when it is freed. Memory allocated without operator new,
+*   such as the stacks of threads, isn't counted.
+*/
+class MemoryUsage
+{
+public:
+
+	/**
+	*   \brief Returns the number of bytes currently allocated by operator new
+	*   \return number of allocated bytes
+	*/
+	static uint64_t getCurrent();
+
+	/**
+	*   \brief Returns the highest number of bytes allocated by operator new at once since the start or since the last reset
+	*   \return peak number of allocated bytes
+	*/
+	static uint64_t getPeak();
+
+	/**
+	*   \brief Sets the peak to the number of currently allocated bytes
+	*/
+	static void resetPeak();
+};
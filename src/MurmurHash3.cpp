@@ -0,0 +1,106 @@
+#include "MurmurHash3.h"
+
+#include <algorithm>
+#include <cstring>
+
+uint64_t MurmurHash3::rotate(uint64_t value, int count)
+{
+	return (value << count) | (value >> (64 - count));
+}
+
+uint64_t MurmurHash3::finalize(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCD;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53;
+	value ^= value >> 33;
+
+	return value;
+}
+
+MurmurHash3::Hash MurmurHash3::compute(const char* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	//the body is processed in two lanes of 8 bytes
+	const size_t bodySize = size - size % 16;
+	for (size_t i = 0; i < bodySize; i += 16)
+	{
+		uint64_t k1;
+		uint64_t k2;
+		std::memcpy(&k1, bytes + i, sizeof(k1));
+		std::memcpy(&k2, bytes + i + 8, sizeof(k2));
+
+		k1 *= C1;
+		k1 = rotate(k1, 31);
+		k1 *= C2;
+		h1 ^= k1;
+
+		h1 = rotate(h1, 27);
+		h1 += h2;
+		h1 = h1 * 5 + 0x52DCE729;
+
+		k2 *= C2;
+		k2 = rotate(k2, 33);
+		k2 *= C1;
+		h2 ^= k2;
+
+		h2 = rotate(h2, 31);
+		h2 += h1;
+		h2 = h2 * 5 + 0x38495AB5;
+	}
+
+	//the remaining bytes are gathered in little-endian order, the first 8 of them into the first lane
+	const unsigned char* tail = bytes + bodySize;
+	const size_t tailSize = size - bodySize;
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+
+	for (size_t i = tailSize; i-- > 8;)
+	{
+		k2 ^= static_cast<uint64_t>(tail[i]) << ((i - 8) * 8);
+	}
+
+	for (size_t i = std::min<size_t>(tailSize, 8); i-- > 0;)
+	{
+		k1 ^= static_cast<uint64_t>(tail[i]) << (i * 8);
+	}
+
+	if (tailSize > 8)
+	{
+		k2 *= C2;
+		k2 = rotate(k2, 33);
+		k2 *= C1;
+		h2 ^= k2;
+	}
+
+	if (tailSize > 0)
+	{
+		k1 *= C1;
+		k1 = rotate(k1, 31);
+		k1 *= C2;
+		h1 ^= k1;
+	}
+
+	h1 ^= size;
+	h2 ^= size;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = finalize(h1);
+	h2 = finalize(h2);
+
+	h1 += h2;
+	h2 += h1;
+
+	return { h1, h2 };
+}
+
+MurmurHash3::Hash MurmurHash3::compute(const std::string& str)
+{
+	return compute(str.data(), str.size());
+}
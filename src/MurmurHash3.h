@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+*   Computes the 128-bit MurmurHash3 (x64 variant by Austin Appleby), a fast non-cryptographic hash
+*   The hash is only compared within a single process and never stored, so the byte order of the platform doesn't matter.
+*/
+class MurmurHash3
+{
+public:
+
+	/**
+	*   128-bit hash value
+	*/
+	struct Hash
+	{
+		uint64_t m_low = 0;  //!< lower half of the hash
+		uint64_t m_high = 0; //!< upper half of the hash
+
+		bool operator==(const Hash& other) const
+		{
+			return m_low == other.m_low && m_high == other.m_high;
+		}
+	};
+
+	/**
+	*   hash function for using Hash as a key of unordered containers, the halves are already well mixed
+	*/
+	struct Hasher
+	{
+		size_t operator()(const Hash& hash) const
+		{
+			return static_cast<size_t>(hash.m_low);
+		}
+	};
+
+private:
+
+	static constexpr uint64_t C1 = 0x87C37B91114253D5; //!< multiplier of the first lane
+	static constexpr uint64_t C2 = 0x4CF5AD432745937F; //!< multiplier of the second lane
+
+	/**
+	*   \brief Rotates the bits of a number to the left
+	*   \param value number to rotate
+	*   \param count number of bits, between 1 and 63
+	*   \return rotated number
+	*/
+	static uint64_t rotate(uint64_t value, int count);
+
+	/**
+	*   \brief Mixes the bits of a number so that every input bit affects every output bit
+	*   \param value number to mix
+	*   \return mixed number
+	*/
+	static uint64_t finalize(uint64_t value);
+
+public:
+
+	/**
+	*   \brief Computes the hash of data
+	*   \param data data to hash
+	*   \param size number of bytes of the data
+	*   \param seed starting value of both lanes
+	*   \return hash of the data
+	*/
+	static Hash compute(const char* data, size_t size, uint64_t seed = 0);
+
+	/**
+	*   \brief Computes the hash of a string
+	*   \param str input string
+	*   \return hash of the string
+	*/
+	static Hash compute(const std::string& str);
+};
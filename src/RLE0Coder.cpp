@@ -7,7 +7,7 @@ std::string RLE0Coder::encode(const std::string& input) const
 	std::string output;
 
 	//for all input characters
-	for (uint32_t i = 0; i < input.size(); ++i)
+	for (size_t i = 0; i < input.size(); ++i)
 	{
 		//if it is a special symbol
 		if (input[i] == '@')
@@ -20,9 +20,9 @@ std::string RLE0Coder::encode(const std::string& input) const
 		{
 			//find out the number of repeated 0s
 
-			uint32_t repeatCount = 1;
+			uint64_t repeatCount = 1;
 
-			uint32_t j = 0;
+			size_t j = 0;
 
 			for (j = i + 1; j < input.size(); j++)
 			{
@@ -37,8 +37,8 @@ std::string RLE0Coder::encode(const std::string& input) const
 			//it is worth to encode only if there are at least 6 repeats
 			if (repeatCount > 5)
 			{
-				uint32_t bitCount = floor(log2(repeatCount + 1));    //number of bits needed to encode the sequence
-				uint32_t number = repeatCount + 1 - (1 << bitCount); //value which will get encoded by bitCount of bits
+				uint32_t bitCount = floor(log2(repeatCount + 1));              //number of bits needed to encode the sequence
+				uint64_t number = repeatCount + 1 - (uint64_t(1) << bitCount); //value which will get encoded by bitCount of bits
 
 				output += '@';  //special symbol which indicates possible beginning of encoded sequence
 				output += '\1'; //indicates that this is the beginning of encoded sequence
@@ -78,17 +78,27 @@ std::string RLE0Coder::encode(const std::string& input) const
 }
 
 std::string RLE0Coder::decode(const std::string& input) const
+{
+	return decode(input, UINT32_MAX);
+}
+
+std::string RLE0Coder::decode(const std::string& input, uint64_t maxOutputSize) const
 {
 	std::string output;
 
 	//for all input characters
-	for (uint32_t i = 0; i < input.size(); ++i)
+	for (size_t i = 0; i < input.size(); ++i)
 	{
 		//if it is a special symbol
 		if (input[i] == '@')
 		{
+			//the special symbol can't be the last value, the input is corrupted
+			if (i + 1 >= input.size())
+			{
+				break;
+			}
 			//if the next value is '\0' then it isn't the beginning of encoded sequence of 0s but just a single '@' value
-			if (input[i + 1] == '\0')
+			else if (input[i + 1] == '\0')
 			{
 				output += input[i]; //just copy input to output
 				i++; //skip the '\0' indicator
@@ -96,11 +106,11 @@ std::string RLE0Coder::decode(const std::string& input) const
 			//if the next value is '\1' then it is the beginning of encoded sequence of 0s
 			else
 			{
-				uint32_t number = 0;   //value which is encoded by bitCount of bits
+				uint64_t number = 0;   //value which is encoded by bitCount of bits
 				uint32_t bitCount = 0; //number of bits which encode the sequence
 
 				//read values until the special symbol which denotes the end of the sequence, decode the value and count number of bits
-				for (uint32_t j = i + 2; j < input.size(); ++j)
+				for (size_t j = i + 2; j < input.size(); ++j)
 				{
 					if (input[j] == '@')
 					{
@@ -119,8 +129,20 @@ std::string RLE0Coder::decode(const std::string& input) const
 					bitCount++;
 				}
 
+				//a sequence of 0s can't be longer than the 64bit value it was counted in, the input is corrupted
+				if (bitCount >= 64)
+				{
+					break;
+				}
+
 				//compute the length of the sequence of 0s from the decoded value
-				uint32_t repeatCount = (1 << bitCount) + number - 1;
+				uint64_t repeatCount = (uint64_t(1) << bitCount) + number - 1;
+
+				//the sequence doesn't fit into the output, the input is corrupted
+				if (output.size() > maxOutputSize || repeatCount > maxOutputSize - output.size())
+				{
+					break;
+				}
 
 				//add the computed number of 0s to the output
 				output.append(repeatCount, '\0');
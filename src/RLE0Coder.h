@@ -22,4 +22,12 @@ public:
 	*   \return decoded string
 	*/
 	std::string decode(const std::string& input) const override;
+
+	/**
+	*   \brief Decodes the input string using RLE0 coding, decoding stops if the output would get longer than the given size
+	*   \param input input string (encoded)
+	*   \param maxOutputSize maximum size of the decoded string, longer output means the input is corrupted
+	*   \return decoded string
+	*/
+	std::string decode(const std::string& input, uint64_t maxOutputSize) const;
 };
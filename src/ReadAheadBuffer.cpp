@@ -0,0 +1,171 @@
+#include "ReadAheadBuffer.h"
+
+#include "FileDescriptorBuffer.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+ReadAheadBuffer::ReadAheadBuffer(std::streambuf* source, size_t chunkSize)
+	: m_source(source), m_chunkSize(std::max<size_t>(chunkSize, 1))
+{
+	setg(nullptr, nullptr, nullptr);
+
+#if !defined(_WIN32)
+	//only a file descriptor can be polled, without the pipe the source is read directly like any other
+	const FileDescriptorBuffer* descriptorBuffer = dynamic_cast<const FileDescriptorBuffer*>(source);
+	if (descriptorBuffer != nullptr && pipe(m_wakePipe) == 0)
+	{
+		m_descriptor = descriptorBuffer->getDescriptor();
+	}
+#endif
+
+	m_thread = std::thread(&ReadAheadBuffer::run, this);
+}
+
+ReadAheadBuffer::~ReadAheadBuffer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+
+#if !defined(_WIN32)
+	//a poll of the file descriptor ends with the byte in the pipe, a read blocked in any other source can't be interrupted,
+	//it ends with the next data or the end of the source
+	if (m_descriptor >= 0)
+	{
+		const char wake = 0;
+		while (write(m_wakePipe[1], &wake, 1) < 0 && errno == EINTR)
+		{
+		}
+	}
+#endif
+
+	m_thread.join();
+
+#if !defined(_WIN32)
+	if (m_descriptor >= 0)
+	{
+		close(m_wakePipe[0]);
+		close(m_wakePipe[1]);
+	}
+#endif
+}
+
+bool ReadAheadBuffer::waitForSource()
+{
+#if !defined(_WIN32)
+	//data buffered by the source is read without waiting
+	if (m_descriptor < 0 || m_source->in_avail() > 0) return true;
+
+	pollfd descriptors[2] = { { m_descriptor, POLLIN, 0 }, { m_wakePipe[0], POLLIN, 0 } };
+	while (poll(descriptors, 2, -1) < 0)
+	{
+		//if the descriptor can't be polled, it is read directly
+		if (errno != EINTR) return true;
+	}
+
+	return (descriptors[1].revents & POLLIN) == 0;
+#else
+	return true;
+#endif
+}
+
+void ReadAheadBuffer::run()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stop || m_chunks.size() < CHUNK_COUNT; });
+			if (m_stop) return;
+		}
+
+		if (!waitForSource()) return;
+
+		std::string chunk;
+		chunk.resize(m_chunkSize);
+		size_t size = 0;
+
+		//wait for at least one byte, then take only what is available without waiting again
+		if (!traits_type::eq_int_type(m_source->sgetc(), traits_type::eof()))
+		{
+			while (size < m_chunkSize)
+			{
+				std::streamsize available = m_source->in_avail();
+				if (available <= 0) break;
+
+				size += static_cast<size_t>(m_source->sgetn(&chunk[size], std::min<std::streamsize>(available, static_cast<std::streamsize>(m_chunkSize - size))));
+			}
+		}
+
+		chunk.resize(size);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (chunk.empty())
+		{
+			m_end = true;
+			m_condition.notify_all();
+			return;
+		}
+
+		m_chunks.push_back(std::move(chunk));
+		m_condition.notify_all();
+	}
+}
+
+ReadAheadBuffer::int_type ReadAheadBuffer::underflow()
+{
+	if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this]() { return m_end || !m_chunks.empty(); });
+
+	if (m_chunks.empty()) return traits_type::eof();
+
+	m_current = std::move(m_chunks.front());
+	m_chunks.pop_front();
+	m_condition.notify_all();
+
+	setg(&m_current[0], &m_current[0], &m_current[0] + m_current.size());
+
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize ReadAheadBuffer::showmanyc()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::streamsize available = 0;
+	for (const std::string& chunk : m_chunks)
+	{
+		available += chunk.size();
+	}
+
+	return (available == 0 && m_end) ? -1 : available;
+}
+
+bool ReadAheadBuffer::waitForData(std::chrono::steady_clock::time_point deadline)
+{
+	if (gptr() < egptr()) return true;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto ready = [this]() { return m_end || !m_chunks.empty(); };
+
+	//waiting until the largest time point could overflow in the conversion to the clock of the condition variable
+	if (deadline == std::chrono::steady_clock::time_point::max())
+	{
+		m_condition.wait(lock, ready);
+		return true;
+	}
+
+	return m_condition.wait_until(lock, deadline, ready);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+/**
+*   Stream buffer which reads another stream buffer ahead in a background thread
+*
+*   The background thread keeps up to CHUNK_COUNT chunks read, so the reader only copies data which is already in memory
+*   while the next reads wait for the disk or the pipe. A chunk is handed over as soon as no more data is immediately
+*   available, so that a slow producer isn't delayed until a whole chunk is filled. Seeking isn't supported.
+*   A FileDescriptorBuffer source is polled together with a wake-up pipe before it is read, so that the destructor
+*   doesn't wait for a stalled pipe, e.g. when an error ends the process while the standard input is still open.
+*/
+class ReadAheadBuffer : public std::streambuf
+{
+private:
+
+	static constexpr size_t CHUNK_COUNT = 2; //!< number of chunks read ahead
+
+	std::streambuf* m_source;            //!< stream buffer which is read, not owned
+	size_t m_chunkSize;                  //!< maximum number of bytes in a single chunk
+	std::deque<std::string> m_chunks;    //!< chunks read ahead, in order
+	std::string m_current;               //!< chunk being read by the get area
+	std::mutex m_mutex;                  //!< protects m_chunks, m_end and m_stop
+	std::condition_variable m_condition; //!< signals new chunks to the reader and free space to the background thread
+	bool m_end = false;                  //!< set when the source has no more data
+	bool m_stop = false;                 //!< set when the buffer is being destroyed
+	int m_descriptor = -1;               //!< file descriptor under the source which is polled before reading, -1 if the source is read directly
+	int m_wakePipe[2] = { -1, -1 };      //!< pipe written by the destructor to end the poll of the background thread
+	std::thread m_thread;                //!< reads the source ahead
+
+	/**
+	*   \brief Main loop of the background thread, reads chunks until the end of the source or until stopped
+	*/
+	void run();
+
+	/**
+	*   \brief Waits until the source can be read without blocking or until the destructor wakes the background thread
+	*   \return true if the source can be read, false if the buffer is being destroyed
+	*/
+	bool waitForSource();
+
+protected:
+
+	int_type underflow() override;
+
+	std::streamsize showmanyc() override;
+
+public:
+
+	static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20; //!< maximum number of bytes in a single chunk if none is given
+
+	/**
+	*   \brief Starts reading the source ahead
+	*   \param source stream buffer to read, it mustn't be used by anything else while this buffer exists, a FileDescriptorBuffer is polled
+	*   \param chunkSize maximum number of bytes in a single chunk, at most CHUNK_COUNT + 2 chunks are in memory, including the ones being read and consumed
+	*/
+	explicit ReadAheadBuffer(std::streambuf* source, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+	ReadAheadBuffer(const ReadAheadBuffer& other) = delete;
+
+	ReadAheadBuffer& operator=(const ReadAheadBuffer& other) = delete;
+
+	/**
+	*   \brief Waits until data can be read without blocking or the end of the source is reached
+	*   After a successful wait, in_avail returns the number of bytes which can be read without blocking, -1 at the end
+	*   \param deadline time at which the wait is given up
+	*   \return true if data or the end is available, false if the deadline passed first
+	*/
+	bool waitForData(std::chrono::steady_clock::time_point deadline);
+
+	/**
+	*   \brief Stops the background thread, the data read ahead is lost
+	*   A background thread waiting for a FileDescriptorBuffer source is woken, other sources are waited for
+	*/
+	~ReadAheadBuffer() override;
+};
@@ -0,0 +1,40 @@
+#include "StageTimer.h"
+
+#include <ctime>
+
+StageTimer::StageTimer()
+	: m_wallStart(std::chrono::steady_clock::now())
+	, m_CPUStart(getThreadCPUTime())
+{
+}
+
+void StageTimer::stop(StageLog& stageLog, uint64_t outputSize)
+{
+	std::chrono::steady_clock::time_point wallEnd = std::chrono::steady_clock::now();
+	double CPUEnd = getThreadCPUTime();
+
+	stageLog.m_wallTime += std::chrono::duration<double>(wallEnd - m_wallStart).count();
+	stageLog.m_CPUTime += CPUEnd - m_CPUStart;
+	stageLog.m_outputSize += outputSize;
+
+	m_wallStart = wallEnd;
+	m_CPUStart = CPUEnd;
+}
+
+double StageTimer::getThreadCPUTime()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	timespec time;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+	{
+		return time.tv_sec + time.tv_nsec * 1e-9;
+	}
+#endif
+
+	return getProcessCPUTime();
+}
+
+double StageTimer::getProcessCPUTime()
+{
+	return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
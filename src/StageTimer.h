@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+
+#include "StreamCoder.h"
+
+/**
+*   Measures the wall time and the CPU time of the calling thread spent in the stages of processing a block
+*/
+class StageTimer
+{
+private:
+
+	std::chrono::steady_clock::time_point m_wallStart; //!< wall clock at the start of the current stage
+	double m_CPUStart = 0.0;                           //!< CPU time of the thread at the start of the current stage
+
+public:
+
+	/**
+	*   \brief Starts measuring the first stage
+	*/
+	StageTimer();
+
+	/**
+	*   \brief Adds the time since the start of the current stage to its log and starts the next stage
+	*   \param stageLog log of the current stage
+	*   \param outputSize number of bytes produced by the current stage, added to its log
+	*/
+	void stop(StageLog& stageLog, uint64_t outputSize = 0);
+
+	/**
+	*   \brief Returns the CPU time consumed by the calling thread
+	*   Falls back to the CPU time of the whole process where the time of a thread can't be queried
+	*   \return CPU time in seconds
+	*/
+	static double getThreadCPUTime();
+
+	/**
+	*   \brief Returns the CPU time consumed by all threads of the process
+	*   \return CPU time in seconds
+	*/
+	static double getProcessCPUTime();
+};
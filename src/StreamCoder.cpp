@@ -1,11 +1,31 @@
 #include "StreamCoder.h"
 
-void StreamCoder::setBlockSize(int blockSize)
+void StreamCoder::setBlockSize(uint64_t blockSize)
 {
 	m_blockSize = blockSize;
 }
 
-int StreamCoder::getBlockSize() const
+uint64_t StreamCoder::getBlockSize() const
 {
 	return m_blockSize;
 }
+
+void StreamCoder::setThreadCount(unsigned threadCount)
+{
+	m_threadCount = std::max(threadCount, 1u);
+}
+
+unsigned StreamCoder::getThreadCount() const
+{
+	return m_threadCount;
+}
+
+void StreamCoder::setMemoryBudget(uint64_t memoryBudget)
+{
+	m_memoryBudget = memoryBudget;
+}
+
+uint64_t StreamCoder::getMemoryBudget() const
+{
+	return m_memoryBudget;
+}
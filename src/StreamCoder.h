@@ -2,15 +2,84 @@
 
 #include "Coder.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+*   stages of processing a block which are measured separately
+*/
+enum Stage
+{
+	STAGE_ANALYSIS,     //!< estimating the compressibility and choosing the stages
+	STAGE_BWT,          //!< Burrows-Wheeler transform or its inverse
+	STAGE_MTF,          //!< move-to-front coding or decoding
+	STAGE_RLE0,         //!< run-length coding or decoding of 0s
+	STAGE_HUFFMAN,      //!< Huffman coding or decoding
+	STAGE_SEARCH_INDEX, //!< building or querying the FM-index
+	STAGE_CHECKSUM,     //!< computing CRC-32C of the uncoded block
+	STAGE_DEDUP,        //!< hashing the block to find an earlier identical one, or copying the block a reference repeats
+	STAGE_IO,           //!< reading and writing the streams
+	STAGE_COUNT         //!< number of stages
+};
+
+/**
+*   names of the stages in the log, STAGE_NAMES[stage]
+*/
+inline constexpr const char* STAGE_NAMES[STAGE_COUNT] = { "analysis", "BWT", "MTF", "RLE0", "Huffman", "searchIndex", "checksum", "dedup", "IO" };
+
+/**
+*   time spent in a single stage and the size of its output
+*/
+struct StageLog
+{
+	double m_wallTime = 0.0;   //!< wall time in seconds
+	double m_CPUTime = 0.0;    //!< CPU time of the thread which processed the block in seconds
+	uint64_t m_outputSize = 0; //!< number of bytes produced by the stage, for IO the number of bytes read and written
+};
+
+/**
+*   statistics of a single block and the decisions made for it
+*/
+struct BlockLog
+{
+	uint64_t m_uncodedSize = 0; //!< size of the block before encoding in bytes
+	uint64_t m_codedSize = 0;   //!< size of the block after encoding in bytes, without its header
+	uint8_t m_flags = 0;        //!< block flags, combination of StreamFormat::BLOCK_* values
+	double m_BWTEntropy = 0.0;  //!< order-0 entropy of the BWT output in bits per byte, only when encoding
+	double m_MTFEntropy = 0.0;  //!< order-0 entropy of the MTF output in bits per byte, only when encoding
+	uint64_t m_zeroRuns = 0;    //!< number of runs of 0s long enough to be encoded by RLE, only when encoding
+	uint64_t m_escapes = 0;     //!< number of special symbols which RLE has to escape, only when encoding
+	std::array<StageLog, STAGE_COUNT> m_stages; //!< time and output size of every stage, m_stages[stage]
+};
+
+/**
+*   data written out by a single flush of a partial block
+*/
+struct FlushLog
+{
+	double m_latency = 0.0;     //!< time in seconds from the arrival of the oldest flushed byte until the sink received its encoded block
+	uint64_t m_uncodedSize = 0; //!< number of uncoded bytes which arrived since the previous flush
+	uint64_t m_codedSize = 0;   //!< number of encoded bytes passed to the sink since the previous flush
+};
 
 /**
 *   log of the encoding/decoding process
 */
 struct Log
 {
-	int64_t m_uncodedSize = 0; //!< size of uncoded data in bytes
-	int64_t m_codedSize = 0;   //!< size of encoded data in bytes
+	int64_t m_uncodedSize = 0;      //!< size of uncoded data in bytes
+	int64_t m_codedSize = 0;        //!< size of encoded data in bytes
+	uint64_t m_blockSize = 0;       //!< block size which was used, may be smaller than the set one because of the memory budget
+	unsigned m_threadCount = 0;     //!< number of blocks which were processed in parallel
+	uint64_t m_memoryBudget = 0;    //!< memory budget in bytes, 0 if unlimited
+	uint64_t m_peakMemory = 0;      //!< highest number of bytes allocated at once, measured by the caller
+	double m_wallTime = 0.0;        //!< wall time of the whole process in seconds, measured by the caller
+	double m_CPUTime = 0.0;         //!< CPU time of all threads in seconds, measured by the caller
+	std::vector<BlockLog> m_blocks; //!< statistics of every processed block in the order of the stream
+	std::vector<FlushLog> m_flushes; //!< every flush of the encoded stream in order, only when encoding with flush points
 };
 
 /**
@@ -20,7 +89,9 @@ class StreamCoder : public Coder
 {
 protected:
 
-	int m_blockSize = 500000; //!< maximum number of bytes to encode/decode at once in a single iteration
+	uint64_t m_blockSize = 500000; //!< maximum number of bytes to encode/decode at once in a single iteration
+	unsigned m_threadCount = std::max(std::thread::hardware_concurrency(), 1u); //!< maximum number of blocks processed in parallel
+	uint64_t m_memoryBudget = 0; //!< maximum number of bytes of memory used for the data being processed, 0 if unlimited
 
 public:
 
@@ -28,13 +99,38 @@ public:
 	*   \brief Sets the maximum number of bytes to encode/decode at once in a single iteration
 	*   \param blockSize maximum number of bytes to encode/decode at once in a single iteration
 	*/
-	void setBlockSize(int blockSize);
+	void setBlockSize(uint64_t blockSize);
 
 	/**
 	*   \brief Gets the maximum number of bytes to encode/decode at once in a single iteration
 	*   \return maximum number of bytes to encode/decode at once in a single iteration
 	*/
-	int getBlockSize() const;
+	uint64_t getBlockSize() const;
+
+	/**
+	*   \brief Sets the maximum number of blocks processed in parallel
+	*   \param threadCount maximum number of blocks processed in parallel
+	*/
+	void setThreadCount(unsigned threadCount);
+
+	/**
+	*   \brief Gets the maximum number of blocks processed in parallel
+	*   \return maximum number of blocks processed in parallel
+	*/
+	unsigned getThreadCount() const;
+
+	/**
+	*   \brief Sets the maximum amount of memory used for the data being processed
+	*   The block size and the number of blocks processed in parallel are lowered, so that the estimated memory fits into the budget
+	*   \param memoryBudget maximum number of bytes, 0 for unlimited
+	*/
+	void setMemoryBudget(uint64_t memoryBudget);
+
+	/**
+	*   \brief Gets the maximum amount of memory used for the data being processed
+	*   \return maximum number of bytes, 0 if unlimited
+	*/
+	uint64_t getMemoryBudget() const;
 
 	/**
 	*   \brief Encodes a stream of data
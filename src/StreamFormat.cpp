@@ -0,0 +1,337 @@
+#include "StreamFormat.h"
+
+bool StreamFormat::readBytes(std::istream& inputStream, std::string& str, uint64_t count) const
+{
+	str.resize(count);
+	inputStream.read(str.data(), count);
+
+	return inputStream.gcount() == static_cast<std::streamsize>(count);
+}
+
+int StreamFormat::getSizeFieldSize(const StreamHeader& streamHeader) const
+{
+	return (streamHeader.m_flags & FLAG_LARGE_BLOCKS) ? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+int StreamFormat::getBlockHeaderSize(const StreamHeader& streamHeader) const
+{
+	//flags, uncoded size and coded size
+	int size = 1 + 2 * getSizeFieldSize(streamHeader);
+
+	//size of the search index
+	if (streamHeader.m_flags & FLAG_SEARCH_INDEX) size += sizeof(uint32_t);
+
+	//checksum of the uncoded block
+	if (streamHeader.m_flags & FLAG_CHECKSUM) size += sizeof(uint32_t);
+
+	//ID of the shared entropy model
+	if (streamHeader.m_flags & FLAG_MODEL) size += sizeof(uint32_t);
+
+	return size;
+}
+
+uint64_t StreamFormat::getMaxBlockSize(uint16_t flags) const
+{
+	return (flags & FLAG_LARGE_BLOCKS) ? MAX_LARGE_BLOCK_SIZE : MAX_BLOCK_SIZE;
+}
+
+std::string StreamFormat::encodeStreamHeader(const StreamHeader& streamHeader) const
+{
+	std::string output;
+	output.reserve(STREAM_HEADER_SIZE);
+
+	output.append(STREAM_MAGIC, MAGIC_SIZE);
+	output += encodeNumber(VERSION, 1);
+	output += encodeNumber(streamHeader.m_flags, sizeof(uint16_t));
+	output += encodeNumber(streamHeader.m_blockSize, sizeof(uint64_t));
+
+	return output;
+}
+
+bool StreamFormat::readStreamHeader(std::istream& inputStream, StreamHeader& streamHeader) const
+{
+	std::string header;
+	if (!readBytes(inputStream, header, STREAM_HEADER_SIZE)) return false;
+
+	//check that this is an encoded stream at all
+	if (header.compare(0, MAGIC_SIZE, STREAM_MAGIC, MAGIC_SIZE) != 0) return false;
+
+	streamHeader.m_version = decodeNumber(header.substr(MAGIC_SIZE, 1));
+	streamHeader.m_flags = decodeNumber(header.substr(MAGIC_SIZE + 1, sizeof(uint16_t)));
+	streamHeader.m_blockSize = decodeNumber(header.substr(MAGIC_SIZE + 1 + sizeof(uint16_t), sizeof(uint64_t)));
+
+	//streams written by a newer version or with unknown codec flags can't be decoded
+	if (streamHeader.m_version == 0 || streamHeader.m_version > VERSION) return false;
+	if ((streamHeader.m_flags & ~SUPPORTED_FLAGS) != 0) return false;
+	if (streamHeader.m_blockSize == 0 || streamHeader.m_blockSize > getMaxBlockSize(streamHeader.m_flags)) return false;
+
+	//the search index can only address blocks with 32-bit positions
+	if ((streamHeader.m_flags & FLAG_LARGE_BLOCKS) && (streamHeader.m_flags & FLAG_SEARCH_INDEX)) return false;
+
+	return true;
+}
+
+std::string StreamFormat::encodeBlockHeader(const StreamHeader& streamHeader, const BlockHeader& blockHeader) const
+{
+	std::string output;
+	output.reserve(getBlockHeaderSize(streamHeader));
+
+	const int sizeFieldSize = getSizeFieldSize(streamHeader);
+
+	output += encodeNumber(blockHeader.m_flags, 1);
+	output += encodeNumber(blockHeader.m_uncodedSize, sizeFieldSize);
+	output += encodeNumber(blockHeader.m_codedSize, sizeFieldSize);
+
+	if (streamHeader.m_flags & FLAG_SEARCH_INDEX)
+	{
+		output += encodeNumber(blockHeader.m_searchIndexSize, sizeof(uint32_t));
+	}
+
+	if (streamHeader.m_flags & FLAG_CHECKSUM)
+	{
+		output += encodeNumber(blockHeader.m_checksum, sizeof(uint32_t));
+	}
+
+	if (streamHeader.m_flags & FLAG_MODEL)
+	{
+		output += encodeNumber(blockHeader.m_modelID, sizeof(uint32_t));
+	}
+
+	return output;
+}
+
+bool StreamFormat::readBlockHeader(std::istream& inputStream, const StreamHeader& streamHeader, BlockHeader& blockHeader) const
+{
+	std::string header;
+	if (!readBytes(inputStream, header, getBlockHeaderSize(streamHeader))) return false;
+
+	const int sizeFieldSize = getSizeFieldSize(streamHeader);
+
+	blockHeader.m_flags = decodeNumber(header.substr(0, 1));
+	blockHeader.m_uncodedSize = decodeNumber(header.substr(1, sizeFieldSize));
+	blockHeader.m_codedSize = decodeNumber(header.substr(1 + sizeFieldSize, sizeFieldSize));
+	blockHeader.m_searchIndexSize = 0;
+	blockHeader.m_checksum = 0;
+	blockHeader.m_modelID = 0;
+
+	//position of the optional fields
+	size_t position = 1 + 2 * sizeFieldSize;
+
+	if (streamHeader.m_flags & FLAG_SEARCH_INDEX)
+	{
+		blockHeader.m_searchIndexSize = decodeNumber(header.substr(position, sizeof(uint32_t)));
+		position += sizeof(uint32_t);
+	}
+
+	if (streamHeader.m_flags & FLAG_CHECKSUM)
+	{
+		blockHeader.m_checksum = decodeNumber(header.substr(position, sizeof(uint32_t)));
+		position += sizeof(uint32_t);
+	}
+
+	if (streamHeader.m_flags & FLAG_MODEL)
+	{
+		blockHeader.m_modelID = decodeNumber(header.substr(position, sizeof(uint32_t)));
+		position += sizeof(uint32_t);
+	}
+
+	if (blockHeader.m_flags & BLOCK_END)
+	{
+		return blockHeader.m_uncodedSize == 0 && blockHeader.m_codedSize == 0 && blockHeader.m_modelID == 0;
+	}
+
+	if (blockHeader.m_searchIndexSize > blockHeader.m_codedSize) return false;
+
+	//references contain just the number of the repeated block
+	if (blockHeader.m_flags & BLOCK_REFERENCE)
+	{
+		if (!(streamHeader.m_flags & FLAG_DEDUP) || (blockHeader.m_flags & ~BLOCK_REFERENCE) != 0) return false;
+		if (blockHeader.m_codedSize != REFERENCE_SIZE || blockHeader.m_searchIndexSize != 0 || blockHeader.m_modelID != 0) return false;
+	}
+
+	//raw blocks contain just the uncoded data
+	if ((blockHeader.m_flags & BLOCK_RAW) && (blockHeader.m_codedSize != blockHeader.m_uncodedSize || blockHeader.m_searchIndexSize != 0 || blockHeader.m_modelID != 0)) return false;
+
+	//a block can't be empty or larger than the block size of the stream
+	return blockHeader.m_uncodedSize > 0 && blockHeader.m_uncodedSize <= streamHeader.m_blockSize;
+}
+
+std::string StreamFormat::encodeFooter(const std::vector<BlockIndexEntry>& index) const
+{
+	std::string output;
+	output.reserve(sizeof(uint64_t) + index.size() * INDEX_ENTRY_SIZE + FOOTER_TRAILER_SIZE);
+
+	output += encodeNumber(index.size(), sizeof(uint64_t));
+
+	for (const BlockIndexEntry& entry : index)
+	{
+		output += encodeNumber(entry.m_offset, sizeof(uint64_t));
+		output += encodeNumber(entry.m_uncodedSize, sizeof(uint64_t));
+		output += encodeNumber(entry.m_codedSize, sizeof(uint64_t));
+	}
+
+	//size of the whole footer including itself and the magic, so that the footer can be found from the end of the stream
+	output += encodeNumber(output.size() + FOOTER_TRAILER_SIZE, sizeof(uint64_t));
+	output.append(FOOTER_MAGIC, MAGIC_SIZE);
+
+	return output;
+}
+
+bool StreamFormat::readFooter(std::istream& inputStream, std::vector<BlockIndexEntry>& index) const
+{
+	std::string footer;
+	if (!readBytes(inputStream, footer, sizeof(uint64_t))) return false;
+
+	uint64_t blockCount = decodeNumber(footer);
+
+	index.clear();
+
+	//read the entries one by one, so that a corrupted block count can't make us allocate a huge buffer
+	for (uint64_t i = 0; i < blockCount; ++i)
+	{
+		if (!readBytes(inputStream, footer, INDEX_ENTRY_SIZE)) return false;
+
+		BlockIndexEntry entry;
+		entry.m_offset = decodeNumber(footer.substr(0, sizeof(uint64_t)));
+		entry.m_uncodedSize = decodeNumber(footer.substr(sizeof(uint64_t), sizeof(uint64_t)));
+		entry.m_codedSize = decodeNumber(footer.substr(2 * sizeof(uint64_t), sizeof(uint64_t)));
+		index.push_back(entry);
+	}
+
+	if (!readBytes(inputStream, footer, FOOTER_TRAILER_SIZE)) return false;
+
+	uint64_t footerSize = decodeNumber(footer.substr(0, sizeof(uint64_t)));
+
+	return footerSize == sizeof(uint64_t) + blockCount * INDEX_ENTRY_SIZE + FOOTER_TRAILER_SIZE
+		&& footer.compare(sizeof(uint64_t), MAGIC_SIZE, FOOTER_MAGIC, MAGIC_SIZE) == 0;
+}
+
+bool StreamFormat::readIndex(std::istream& inputStream, StreamHeader& streamHeader, std::vector<BlockIndexEntry>& index) const
+{
+	//position of the stream header, all offsets in the index are relative to it
+	std::streampos streamStart = inputStream.tellg();
+	if (streamStart == std::streampos(-1)) return false;
+
+	if (!readStreamHeader(inputStream, streamHeader)) return false;
+
+	const int blockHeaderSize = getBlockHeaderSize(streamHeader);
+
+	//try the footer at the end of the stream first
+	std::string trailer;
+	inputStream.seekg(-FOOTER_TRAILER_SIZE, std::ios::end);
+	std::streampos streamEnd = inputStream.tellg() + std::streamoff(FOOTER_TRAILER_SIZE);
+
+	if (inputStream && readBytes(inputStream, trailer, FOOTER_TRAILER_SIZE)
+		&& trailer.compare(sizeof(uint64_t), MAGIC_SIZE, FOOTER_MAGIC, MAGIC_SIZE) == 0)
+	{
+		uint64_t footerSize = decodeNumber(trailer.substr(0, sizeof(uint64_t)));
+		std::streampos footerStart = streamEnd - std::streamoff(footerSize);
+
+		if (footerSize <= static_cast<uint64_t>(streamEnd - streamStart) && inputStream.seekg(footerStart) && readFooter(inputStream, index))
+		{
+			//the footer belongs to this stream only if the end of its last block is right in front of it
+			uint64_t blocksEnd = STREAM_HEADER_SIZE;
+			if (!index.empty())
+			{
+				blocksEnd = index.back().m_offset + blockHeaderSize + index.back().m_codedSize;
+			}
+
+			if (streamStart + std::streamoff(blocksEnd + blockHeaderSize) == footerStart)
+			{
+				uint64_t uncodedOffset = 0;
+				for (BlockIndexEntry& entry : index)
+				{
+					entry.m_uncodedOffset = uncodedOffset;
+					uncodedOffset += entry.m_uncodedSize;
+				}
+
+				return true;
+			}
+		}
+	}
+
+	//no usable footer, build the index by skipping from one block header to the next
+	inputStream.clear();
+	inputStream.seekg(streamStart + std::streamoff(STREAM_HEADER_SIZE));
+	index.clear();
+
+	BlockHeader blockHeader;
+	uint64_t offset = STREAM_HEADER_SIZE;
+	uint64_t uncodedOffset = 0;
+
+	while (readBlockHeader(inputStream, streamHeader, blockHeader))
+	{
+		//the index doesn't cover another stream which follows the footer
+		if (blockHeader.m_flags & BLOCK_END)
+		{
+			std::vector<BlockIndexEntry> footer;
+			return !readFooter(inputStream, footer) || inputStream.peek() == std::char_traits<char>::eof();
+		}
+
+		index.push_back({ offset, blockHeader.m_uncodedSize, blockHeader.m_codedSize, uncodedOffset });
+
+		offset += blockHeaderSize + blockHeader.m_codedSize;
+		uncodedOffset += blockHeader.m_uncodedSize;
+
+		if (!inputStream.seekg(blockHeader.m_codedSize, std::ios::cur)) return false;
+	}
+
+	return false;
+}
+
+bool StreamFormat::findLastStream(std::istream& inputStream, std::streampos& streamStart) const
+{
+	std::streampos inputStart = inputStream.tellg();
+	if (inputStart == std::streampos(-1)) return false;
+
+	//the trailer at the end of the input gives the size of the footer of the last stream
+	std::string trailer;
+	inputStream.seekg(-FOOTER_TRAILER_SIZE, std::ios::end);
+	std::streampos inputEnd = inputStream.tellg() + std::streamoff(FOOTER_TRAILER_SIZE);
+
+	if (!inputStream || !readBytes(inputStream, trailer, FOOTER_TRAILER_SIZE)
+		|| trailer.compare(sizeof(uint64_t), MAGIC_SIZE, FOOTER_MAGIC, MAGIC_SIZE) != 0) return false;
+
+	uint64_t footerSize = decodeNumber(trailer.substr(0, sizeof(uint64_t)));
+	if (footerSize > static_cast<uint64_t>(inputEnd - inputStart)) return false;
+
+	std::streampos footerStart = inputEnd - std::streamoff(footerSize);
+	std::vector<BlockIndexEntry> index;
+	if (!inputStream.seekg(footerStart) || !readFooter(inputStream, index)) return false;
+
+	//the stream ends with its blocks and the block header with BLOCK_END, whose size depends on the flags of the stream,
+	//so the stream header is looked for in front of them for every combination of the flags which change the size
+	const uint16_t sizeFlags[] = { FLAG_LARGE_BLOCKS, FLAG_SEARCH_INDEX, FLAG_CHECKSUM, FLAG_MODEL };
+	const int sizeFlagCount = sizeof(sizeFlags) / sizeof(sizeFlags[0]);
+
+	for (int combination = 0; combination < (1 << sizeFlagCount); ++combination)
+	{
+		StreamHeader flags;
+		for (int i = 0; i < sizeFlagCount; ++i)
+		{
+			if (combination & (1 << i)) flags.m_flags |= sizeFlags[i];
+		}
+
+		const int blockHeaderSize = getBlockHeaderSize(flags);
+		uint64_t blocksEnd = STREAM_HEADER_SIZE;
+		if (!index.empty())
+		{
+			blocksEnd = index.back().m_offset + blockHeaderSize + index.back().m_codedSize;
+		}
+		if (blocksEnd + blockHeaderSize > static_cast<uint64_t>(footerStart - inputStart)) continue;
+
+		//the stream header found there must give the same size of block headers
+		std::streampos candidateStart = footerStart - std::streamoff(blocksEnd + blockHeaderSize);
+		StreamHeader streamHeader;
+		inputStream.clear();
+		if (inputStream.seekg(candidateStart) && readStreamHeader(inputStream, streamHeader) && getBlockHeaderSize(streamHeader) == blockHeaderSize)
+		{
+			streamStart = candidateStart;
+			inputStream.clear();
+
+			return static_cast<bool>(inputStream.seekg(inputStart));
+		}
+	}
+
+	return false;
+}
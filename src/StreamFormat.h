@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Coder.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+*   header at the beginning of an encoded stream
+*/
+struct StreamHeader
+{
+	uint8_t m_version = 0;    //!< version of the format the stream was written in
+	uint16_t m_flags = 0;     //!< codec flags, combination of StreamFormat::FLAG_* values
+	uint64_t m_blockSize = 0; //!< maximum number of uncoded bytes in a single block
+};
+
+/**
+*   header in front of the encoded data of every block
+*/
+struct BlockHeader
+{
+	uint8_t m_flags = 0;            //!< block flags, combination of StreamFormat::BLOCK_* values
+	uint64_t m_uncodedSize = 0;     //!< number of bytes of the block before encoding
+	uint64_t m_codedSize = 0;       //!< number of bytes of encoded data which follow the header, including the search index
+	uint64_t m_searchIndexSize = 0; //!< number of bytes at the end of the encoded data which contain the FM-index of the block
+	uint32_t m_checksum = 0;        //!< CRC-32C of the uncoded block
+	uint32_t m_modelID = 0;         //!< ID of the EntropyModel the Huffman stage used instead of a histogram, 0 if the block stores its own histogram
+};
+
+/**
+*   entry of the block index which is stored in the footer of an encoded stream
+*/
+struct BlockIndexEntry
+{
+	uint64_t m_offset = 0;        //!< position of the block header relative to the beginning of the stream
+	uint64_t m_uncodedSize = 0;   //!< number of bytes of the block before encoding
+	uint64_t m_codedSize = 0;     //!< number of bytes of encoded data which follow the block header
+	uint64_t m_uncodedOffset = 0; //!< position of the first uncoded byte of the block in the uncoded data, not stored, computed from the sizes
+};
+
+/**
+*   Reads and writes the container of an encoded stream:
+*
+*   stream header: magic "BWTD", version (1 byte), codec flags (2 bytes), block size (8 bytes)
+*   blocks:        block header - flags (1 byte), uncoded size (4 bytes), coded size (4 bytes) - followed by the coded data
+*                  with FLAG_LARGE_BLOCKS both sizes, the BWT index and the Huffman counts in the coded data take 8 bytes,
+*                  such streams can't have a search index
+*                  with FLAG_SEARCH_INDEX the block header also contains the size of the FM-index (4 bytes),
+*                  which is stored at the end of the coded data
+*                  with FLAG_CHECKSUM the block header also contains CRC-32C of the uncoded block (4 bytes)
+*                  with FLAG_MODEL the block header also contains the ID of the shared entropy model used by the Huffman stage (4 bytes),
+*                  0 if the block stores its own histogram
+*                  blocks with the BLOCK_RAW flag contain the uncoded data instead of the coded data
+*                  blocks with the BLOCK_SKIP_* flags were encoded without the given stages
+*                  with FLAG_DEDUP blocks with the BLOCK_REFERENCE flag repeat an earlier block of the same stream,
+*                  their coded data is the number of that block (8 bytes), counted from 0 at the first block of the stream,
+*                  the block must be one of the blocks reachable by DeduplicationCache with DEDUP_WINDOW
+*   end of blocks: block header with the BLOCK_END flag and both sizes 0
+*   footer:        number of blocks (8 bytes), for every block its offset, uncoded size and coded size (8 bytes each),
+*                  size of the whole footer (8 bytes), magic "BWTI"
+*
+*   The footer can be found by reading the last bytes of the stream, so a reader can jump directly to any block.
+*   All numbers are stored in big-endian order.
+*/
+class StreamFormat : public Coder
+{
+public:
+
+	static constexpr char STREAM_MAGIC[] = "BWTD"; //!< first bytes of every encoded stream
+	static constexpr char FOOTER_MAGIC[] = "BWTI"; //!< last bytes of every encoded stream
+	static constexpr int MAGIC_SIZE = 4;           //!< size of both magic values in bytes
+
+	static constexpr uint8_t VERSION = 1; //!< version of the format written by this implementation
+
+	static constexpr uint16_t FLAG_SEARCH_INDEX = 0x0001; //!< every block carries an FM-index for substring search
+	static constexpr uint16_t FLAG_CHECKSUM = 0x0002;     //!< every block header carries a checksum of the uncoded block
+	static constexpr uint16_t FLAG_LARGE_BLOCKS = 0x0004; //!< sizes in block headers, BWT indices and Huffman counts take 8 bytes instead of 4
+	static constexpr uint16_t FLAG_MODEL = 0x0008;        //!< every block header carries the ID of the shared entropy model its Huffman stage used
+	static constexpr uint16_t FLAG_DEDUP = 0x0010;        //!< blocks may refer to an earlier identical block of the stream instead of encoding it again
+
+	static constexpr uint16_t SUPPORTED_FLAGS = FLAG_SEARCH_INDEX | FLAG_CHECKSUM | FLAG_LARGE_BLOCKS | FLAG_MODEL | FLAG_DEDUP; //!< combination of all codec flags known to this implementation
+
+	static constexpr uint64_t MAX_BLOCK_SIZE = 1 << 30;                  //!< maximum block size, so that the sizes of encoded blocks fit into the block header
+	static constexpr uint64_t MAX_LARGE_BLOCK_SIZE = uint64_t(1) << 40; //!< maximum block size with FLAG_LARGE_BLOCKS
+
+	static constexpr uint8_t BLOCK_RAW = 0x01;       //!< the block is stored without encoding, it has no search index
+	static constexpr uint8_t BLOCK_SKIP_MTF = 0x02;  //!< the MTF stage was skipped when encoding the block
+	static constexpr uint8_t BLOCK_SKIP_RLE0 = 0x04; //!< the RLE stage was skipped when encoding the block
+	static constexpr uint8_t BLOCK_REFERENCE = 0x08; //!< the block repeats an earlier block of the stream, it contains the number of that block
+	static constexpr uint8_t BLOCK_END = 0x80;       //!< marks the end of blocks, footer follows
+
+	static constexpr int STREAM_HEADER_SIZE = MAGIC_SIZE + 1 + 2 + 8;         //!< size of the stream header in bytes
+	static constexpr int INDEX_ENTRY_SIZE = 3 * sizeof(uint64_t);             //!< size of one entry of the block index in bytes
+	static constexpr int FOOTER_TRAILER_SIZE = sizeof(uint64_t) + MAGIC_SIZE; //!< size of the footer size and the footer magic in bytes
+	static constexpr int REFERENCE_SIZE = sizeof(uint64_t);                   //!< coded size of a block with the BLOCK_REFERENCE flag in bytes
+
+	static constexpr uint64_t DEDUP_WINDOW = uint64_t(1) << 26; //!< total uncoded size of the earlier blocks a reference can reach, which a decoder keeps in memory
+
+	/**
+	*   \brief Reads exactly the given number of bytes from the input stream
+	*   \param inputStream input stream
+	*   \param str read bytes get saved here
+	*   \param count number of bytes to read
+	*   \return true on success, false if fewer bytes than count could be read
+	*/
+	bool readBytes(std::istream& inputStream, std::string& str, uint64_t count) const;
+
+	/**
+	*   \brief Returns the maximum block size allowed with the given codec flags
+	*   \param flags codec flags, combination of FLAG_* values
+	*   \return maximum number of uncoded bytes in a single block
+	*/
+	uint64_t getMaxBlockSize(uint16_t flags) const;
+
+	/**
+	*   \brief Returns the size of the fields which depend on the block size: sizes in block headers, BWT indices and Huffman counts
+	*   \param streamHeader header of the stream
+	*   \return size of the fields in bytes
+	*/
+	int getSizeFieldSize(const StreamHeader& streamHeader) const;
+
+	/**
+	*   \brief Returns the size of the block header in bytes
+	*   \param streamHeader header of the stream the block belongs to
+	*   \return size of the block header in bytes
+	*/
+	int getBlockHeaderSize(const StreamHeader& streamHeader) const;
+
+	/**
+	*   \brief Encodes the stream header
+	*   \param streamHeader stream header to encode
+	*   \return stream header encoded as a string of bytes
+	*/
+	std::string encodeStreamHeader(const StreamHeader& streamHeader) const;
+
+	/**
+	*   \brief Reads and validates the stream header
+	*   \param inputStream stream positioned at the beginning of the stream header
+	*   \param streamHeader decoded stream header gets saved here
+	*   \return true on success, false if the header couldn't be read or isn't valid
+	*/
+	bool readStreamHeader(std::istream& inputStream, StreamHeader& streamHeader) const;
+
+	/**
+	*   \brief Encodes the header of a block
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader block header to encode
+	*   \return block header encoded as a string of bytes
+	*/
+	std::string encodeBlockHeader(const StreamHeader& streamHeader, const BlockHeader& blockHeader) const;
+
+	/**
+	*   \brief Reads and validates the header of a block
+	*   \param inputStream stream positioned at the beginning of the block header
+	*   \param streamHeader header of the stream the block belongs to
+	*   \param blockHeader decoded block header gets saved here
+	*   \return true on success, false if the header couldn't be read or isn't valid
+	*/
+	bool readBlockHeader(std::istream& inputStream, const StreamHeader& streamHeader, BlockHeader& blockHeader) const;
+
+	/**
+	*   \brief Encodes the footer with the block index
+	*   \param index entries of all blocks of the stream in order
+	*   \return footer encoded as a string of bytes
+	*/
+	std::string encodeFooter(const std::vector<BlockIndexEntry>& index) const;
+
+	/**
+	*   \brief Reads and validates the footer with the block index
+	*   \param inputStream stream positioned right after the block header with the BLOCK_END flag
+	*   \param index entries of all blocks of the stream get saved here
+	*   \return true on success, false if the footer couldn't be read or isn't valid
+	*/
+	bool readFooter(std::istream& inputStream, std::vector<BlockIndexEntry>& index) const;
+
+	/**
+	*   \brief Reads the stream header and the block index of a seekable stream
+	*   The index is taken from the footer, if the footer is missing or doesn't belong to this stream,
+	*   it is built by a single pass over the block headers
+	*   \param inputStream seekable stream positioned at the beginning of the stream header
+	*   \param streamHeader decoded stream header gets saved here
+	*   \param index entries of all blocks of the stream get saved here, including their uncoded offsets
+	*   \return true on success, false if the stream isn't seekable, its headers aren't valid or another stream follows it
+	*/
+	bool readIndex(std::istream& inputStream, StreamHeader& streamHeader, std::vector<BlockIndexEntry>& index) const;
+
+	/**
+	*   \brief Finds the beginning of the last of concatenated streams from the footer at the end of the input
+	*   \param inputStream seekable stream positioned at the beginning of the first stream
+	*   \param streamStart beginning of the last stream gets saved here, the beginning of the input if it is a single stream
+	*   \return true on success, false if the input isn't seekable or ends without a valid footer
+	*/
+	bool findLastStream(std::istream& inputStream, std::streampos& streamStart) const;
+};
@@ -0,0 +1,55 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+
+	m_threads.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+	{
+		m_threads.emplace_back(&ThreadPool::run, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+unsigned ThreadPool::getThreadCount() const
+{
+	return m_threads.size();
+}
+
+void ThreadPool::run()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+			//remaining tasks are finished before stopping
+			if (m_tasks.empty()) return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+
+		task();
+	}
+}
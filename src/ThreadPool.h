@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+*   Fixed number of worker threads which execute submitted tasks in the order of submission
+*/
+class ThreadPool
+{
+private:
+
+	std::vector<std::thread> m_threads;        //!< worker threads
+	std::queue<std::function<void()>> m_tasks; //!< tasks waiting for execution
+	std::mutex m_mutex;                        //!< protects m_tasks and m_stop
+	std::condition_variable m_condition;       //!< signals new tasks and stopping to the workers
+	bool m_stop = false;                       //!< set when the pool is being destroyed
+
+	/**
+	*   \brief Main loop of a worker thread, executes tasks until the pool is destroyed
+	*/
+	void run();
+
+public:
+
+	static constexpr unsigned MAX_THREAD_COUNT = 1024; //!< maximum reasonable number of worker threads
+
+	/**
+	*   \brief Starts the worker threads
+	*   \param threadCount number of worker threads, at least one thread is always started
+	*/
+	explicit ThreadPool(unsigned threadCount);
+
+	ThreadPool(const ThreadPool& other) = delete;
+
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	/**
+	*   \brief Finishes all submitted tasks and stops the worker threads
+	*/
+	~ThreadPool();
+
+	/**
+	*   \brief Returns the number of worker threads
+	*   \return number of worker threads
+	*/
+	unsigned getThreadCount() const;
+
+	/**
+	*   \brief Submits a task for execution
+	*   \param task callable object without parameters
+	*   \return future which holds the result of the task once it has been executed
+	*/
+	template
+	<typename Function>
+	std::future<std::invoke_result_t<Function>> submit(Function task);
+};
+
+template<typename Function>
+std::future<std::invoke_result_t<Function>> ThreadPool::submit(Function task)
+{
+	using result_type = std::invoke_result_t<Function>;
+
+	//std::function must be copyable, so the packaged task is shared
+	auto packagedTask = std::make_shared<std::packaged_task<result_type()>>(std::move(task));
+	std::future<result_type> result = packagedTask->get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push([packagedTask]() { (*packagedTask)(); });
+	}
+
+	m_condition.notify_one();
+
+	return result;
+}
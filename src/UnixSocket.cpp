@@ -0,0 +1,378 @@
+#include "UnixSocket.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+	/**
+	*   \brief Fills the address of a socket file
+	*   \param path path of the socket file
+	*   \param address address gets saved here
+	*   \return true on success, false if the path doesn't fit into the address
+	*/
+	bool getAddress(const std::string& path, sockaddr_un& address)
+	{
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+
+		//the path must be terminated by 0 within the address
+		if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+		std::memcpy(address.sun_path, path.data(), path.size());
+
+		return true;
+	}
+
+#if defined(__linux__)
+	const int SEND_FLAGS = MSG_NOSIGNAL;   //a closed connection is reported by an error instead of SIGPIPE
+	const int RECEIVE_FLAGS = MSG_CMSG_CLOEXEC;
+#else
+	const int SEND_FLAGS = 0;
+	const int RECEIVE_FLAGS = 0;
+#endif
+}
+#endif
+
+UnixSocket::UnixSocket(int descriptor)
+	: m_descriptor(descriptor)
+{
+}
+
+UnixSocket::UnixSocket(UnixSocket&& other) noexcept
+	: m_descriptor(other.m_descriptor)
+{
+	other.m_descriptor = NO_DESCRIPTOR;
+}
+
+UnixSocket& UnixSocket::operator=(UnixSocket&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		m_descriptor = other.m_descriptor;
+		other.m_descriptor = NO_DESCRIPTOR;
+	}
+
+	return *this;
+}
+
+UnixSocket::~UnixSocket()
+{
+	close();
+}
+
+bool UnixSocket::listen(const std::string& path)
+{
+	close();
+
+#if defined(_WIN32)
+	return false;
+#else
+	sockaddr_un address;
+	if (!getAddress(path, address)) return false;
+
+	m_descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (m_descriptor < 0)
+	{
+		m_descriptor = NO_DESCRIPTOR;
+		return false;
+	}
+
+	if (bind(m_descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		//a socket file which nobody listens at is left over from a process which didn't remove it, it can be replaced
+		struct stat status;
+		UnixSocket probe;
+		if (errno != EADDRINUSE || lstat(path.c_str(), &status) != 0 || !S_ISSOCK(status.st_mode)
+			|| probe.connect(path) || errno != ECONNREFUSED
+			|| unlink(path.c_str()) != 0 || bind(m_descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			close();
+			return false;
+		}
+	}
+
+	if (::listen(m_descriptor, SOMAXCONN) != 0)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+bool UnixSocket::connect(const std::string& path)
+{
+	close();
+
+#if defined(_WIN32)
+	return false;
+#else
+	sockaddr_un address;
+	if (!getAddress(path, address)) return false;
+
+	m_descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (m_descriptor < 0)
+	{
+		m_descriptor = NO_DESCRIPTOR;
+		return false;
+	}
+
+	int result;
+	do
+	{
+		result = ::connect(m_descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+	} while (result != 0 && errno == EINTR);
+
+	if (result != 0)
+	{
+		//the error of connect is kept for the caller
+		int error = errno;
+		close();
+		errno = error;
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+UnixSocket UnixSocket::accept() const
+{
+#if defined(_WIN32)
+	return UnixSocket();
+#else
+	int descriptor;
+	do
+	{
+		descriptor = ::accept(m_descriptor, nullptr, nullptr);
+	} while (descriptor < 0 && errno == EINTR);
+
+	if (descriptor < 0) return UnixSocket();
+
+	fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+
+	return UnixSocket(descriptor);
+#endif
+}
+
+bool UnixSocket::setNonBlocking()
+{
+#if defined(_WIN32)
+	return false;
+#else
+	int flags = fcntl(m_descriptor, F_GETFL);
+
+	return flags >= 0 && fcntl(m_descriptor, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+long long UnixSocket::send(const char* data, size_t size, int descriptor) const
+{
+#if defined(_WIN32)
+	return -1;
+#else
+	iovec vector;
+	vector.iov_base = const_cast<char*>(data);
+	vector.iov_len = size;
+
+	msghdr message;
+	std::memset(&message, 0, sizeof(message));
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+
+	//the descriptor travels in a control message of the first byte
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+	if (descriptor != NO_DESCRIPTOR)
+	{
+		std::memset(control, 0, sizeof(control));
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		cmsghdr* header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int));
+		std::memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+	}
+
+	ssize_t result;
+	do
+	{
+		result = sendmsg(m_descriptor, &message, SEND_FLAGS);
+	} while (result < 0 && errno == EINTR);
+
+	return result;
+#endif
+}
+
+long long UnixSocket::receive(char* data, size_t size, std::vector<int>& descriptors) const
+{
+#if defined(_WIN32)
+	return -1;
+#else
+	iovec vector;
+	vector.iov_base = data;
+	vector.iov_len = size;
+
+	alignas(cmsghdr) char control[CMSG_SPACE(MAX_PASSED_DESCRIPTORS * sizeof(int))];
+
+	msghdr message;
+	std::memset(&message, 0, sizeof(message));
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t result;
+	do
+	{
+		result = recvmsg(m_descriptor, &message, RECEIVE_FLAGS);
+	} while (result < 0 && errno == EINTR);
+
+	if (result < 0) return result;
+
+	for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+	{
+		if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+
+		const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (size_t i = 0; i < count; ++i)
+		{
+			int descriptor;
+			std::memcpy(&descriptor, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+			descriptors.push_back(descriptor);
+		}
+	}
+
+	return result;
+#endif
+}
+
+bool UnixSocket::sendAll(const char* data, size_t size, int descriptor) const
+{
+	while (size > 0)
+	{
+		long long sent = send(data, size, descriptor);
+		if (sent <= 0) return false;
+
+		//the descriptor went with the first piece
+		descriptor = NO_DESCRIPTOR;
+		data += sent;
+		size -= static_cast<size_t>(sent);
+	}
+
+	return true;
+}
+
+bool UnixSocket::receiveAll(char* data, size_t size, std::vector<int>& descriptors) const
+{
+	while (size > 0)
+	{
+		long long received = receive(data, size, descriptors);
+		if (received <= 0) return false;
+
+		data += received;
+		size -= static_cast<size_t>(received);
+	}
+
+	return true;
+}
+
+bool UnixSocket::isOpen() const
+{
+	return m_descriptor != NO_DESCRIPTOR;
+}
+
+int UnixSocket::getDescriptor() const
+{
+	return m_descriptor;
+}
+
+void UnixSocket::close()
+{
+#if !defined(_WIN32)
+	if (m_descriptor != NO_DESCRIPTOR) ::close(m_descriptor);
+#endif
+
+	m_descriptor = NO_DESCRIPTOR;
+}
+
+bool UnixSocket::createMemoryFile(const std::string& data, int& descriptor)
+{
+	descriptor = NO_DESCRIPTOR;
+
+#if defined(__linux__)
+	int file = memfd_create("bwted", MFD_CLOEXEC);
+	if (file < 0) return false;
+
+	//the data is copied into the pages of the file once, instead of through the buffers of the socket
+	for (size_t offset = 0; offset < data.size();)
+	{
+		ssize_t written = pwrite(file, data.data() + offset, data.size() - offset, static_cast<off_t>(offset));
+		if (written < 0 && errno == EINTR) continue;
+
+		if (written <= 0)
+		{
+			::close(file);
+			return false;
+		}
+
+		offset += static_cast<size_t>(written);
+	}
+
+	descriptor = file;
+
+	return true;
+#else
+	(void)data;
+	return false;
+#endif
+}
+
+bool UnixSocket::readMemoryFile(int descriptor, uint64_t size, std::string& data)
+{
+	data.clear();
+
+#if defined(_WIN32)
+	(void)descriptor;
+	return size == 0;
+#else
+	//the file comes from another process, which could shrink a mapped file under our hands, so it is read instead
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode) || static_cast<uint64_t>(status.st_size) < size) return false;
+
+	data.resize(size);
+	for (uint64_t offset = 0; offset < size;)
+	{
+		ssize_t received = pread(descriptor, &data[offset], size - offset, static_cast<off_t>(offset));
+		if (received < 0 && errno == EINTR) continue;
+
+		if (received <= 0)
+		{
+			data.clear();
+			return false;
+		}
+
+		offset += static_cast<uint64_t>(received);
+	}
+
+	return true;
+#endif
+}
+
+void UnixSocket::closeDescriptor(int descriptor)
+{
+#if !defined(_WIN32)
+	if (descriptor != NO_DESCRIPTOR) ::close(descriptor);
+#endif
+}
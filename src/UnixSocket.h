@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+*   Stream socket in the Unix domain, which can pass file descriptors along with the data
+*
+*   The socket owns its descriptor and closes it when it is destroyed. Unix domain sockets need a POSIX system and memory files
+*   (memfd) need Linux, elsewhere the functions which use them fail.
+*/
+class UnixSocket
+{
+public:
+
+	static constexpr int NO_DESCRIPTOR = -1;        //!< value of a missing descriptor
+	static constexpr int MAX_PASSED_DESCRIPTORS = 4; //!< maximum number of descriptors received with a single piece of data
+
+private:
+
+	int m_descriptor = NO_DESCRIPTOR; //!< descriptor of the socket, NO_DESCRIPTOR if it isn't open
+
+public:
+
+	UnixSocket() = default;
+
+	/**
+	*   \brief Takes over an open socket
+	*   \param descriptor descriptor of the socket, it gets closed by the new object
+	*/
+	explicit UnixSocket(int descriptor);
+
+	UnixSocket(UnixSocket&& other) noexcept;
+
+	UnixSocket& operator=(UnixSocket&& other) noexcept;
+
+	UnixSocket(const UnixSocket& other) = delete;
+
+	UnixSocket& operator=(const UnixSocket& other) = delete;
+
+	~UnixSocket();
+
+	/**
+	*   \brief Creates a socket listening at the given path
+	*   A socket file left behind by a process which no longer listens at it is replaced, a socket which is in use isn't.
+	*   \param path path of the socket file
+	*   \return true on success, false on error
+	*/
+	bool listen(const std::string& path);
+
+	/**
+	*   \brief Connects to a socket listening at the given path
+	*   \param path path of the socket file
+	*   \return true on success, false on error
+	*/
+	bool connect(const std::string& path);
+
+	/**
+	*   \brief Accepts a connection of a listening socket
+	*   \return socket of the connection, not open if there is no waiting connection or on error
+	*/
+	UnixSocket accept() const;
+
+	/**
+	*   \brief Makes the functions of the socket return instead of waiting
+	*   \return true on success, false on error
+	*/
+	bool setNonBlocking();
+
+	/**
+	*   \brief Sends a piece of data, which may be sent only partially
+	*   \param data data to send
+	*   \param size number of bytes to send, at least 1 if a descriptor is passed
+	*   \param descriptor descriptor passed with the data, NO_DESCRIPTOR for none, the caller still has to close it
+	*   \return number of sent bytes, -1 on error or if a non-blocking socket would block (errno tells which)
+	*/
+	long long send(const char* data, size_t size, int descriptor) const;
+
+	/**
+	*   \brief Receives at most the given number of bytes
+	*   \param data received bytes get saved here
+	*   \param size maximum number of bytes to receive
+	*   \param descriptors descriptors passed with the data get appended here, the caller has to close them
+	*   \return number of received bytes, 0 at the end of the connection, -1 on error or if a non-blocking socket would block (errno tells which)
+	*/
+	long long receive(char* data, size_t size, std::vector<int>& descriptors) const;
+
+	/**
+	*   \brief Sends all given bytes, waits until the socket takes them
+	*   \param data data to send
+	*   \param size number of bytes to send
+	*   \param descriptor descriptor passed with the first byte, NO_DESCRIPTOR for none
+	*   \return true on success, false on error
+	*/
+	bool sendAll(const char* data, size_t size, int descriptor) const;
+
+	/**
+	*   \brief Receives exactly the given number of bytes, waits until they arrive
+	*   \param data received bytes get saved here
+	*   \param size number of bytes to receive
+	*   \param descriptors descriptors passed with the data get appended here, the caller has to close them
+	*   \return true on success, false on error or if the connection ends first
+	*/
+	bool receiveAll(char* data, size_t size, std::vector<int>& descriptors) const;
+
+	/**
+	*   \brief Returns whether the socket is open
+	*   \return true if the socket is open, false otherwise
+	*/
+	bool isOpen() const;
+
+	/**
+	*   \brief Returns the descriptor of the socket, e.g. to wait for it with poll(2)
+	*   \return descriptor of the socket, NO_DESCRIPTOR if it isn't open
+	*/
+	int getDescriptor() const;
+
+	/**
+	*   \brief Closes the socket
+	*/
+	void close();
+
+	/**
+	*   \brief Creates an anonymous memory file with the given data
+	*   \param data content of the file
+	*   \param descriptor descriptor of the file gets saved here, the caller has to close it
+	*   \return true on success, false on error or if memory files aren't supported
+	*/
+	static bool createMemoryFile(const std::string& data, int& descriptor);
+
+	/**
+	*   \brief Reads the beginning of a memory file received from another process
+	*   \param descriptor descriptor of the file
+	*   \param size number of bytes to read, the file may be larger
+	*   \param data content of the file gets saved here
+	*   \return true on success, false on error or if the file is smaller
+	*/
+	static bool readMemoryFile(int descriptor, uint64_t size, std::string& data);
+
+	/**
+	*   \brief Closes a descriptor which isn't a socket, e.g. a received memory file
+	*   \param descriptor descriptor to close, NO_DESCRIPTOR is ignored
+	*/
+	static void closeDescriptor(int descriptor);
+};
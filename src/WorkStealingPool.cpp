@@ -0,0 +1,167 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	thread_local const WorkStealingPool* currentPool = nullptr; //pool of the calling worker thread
+	thread_local unsigned currentWorker = 0;                   //index of the calling worker thread in its pool
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+
+	for (unsigned i = 0; i < threadCount; ++i)
+	{
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+
+	m_threads.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+	{
+		m_threads.emplace_back(&WorkStealingPool::run, this, i);
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	wait();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+unsigned WorkStealingPool::getThreadCount() const
+{
+	//the queues all exist before the first thread starts, unlike the threads
+	return m_workers.size();
+}
+
+unsigned WorkStealingPool::getWorkerIndex() const
+{
+	return (currentPool == this) ? currentWorker : getThreadCount();
+}
+
+uint64_t WorkStealingPool::getStolenCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_stolenCount;
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+	unsigned index = getWorkerIndex();
+
+	//the counters are increased first, so that a worker which finds the task can't decrease them below zero
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queuedCount++;
+		m_pendingCount++;
+
+		if (index == getThreadCount())
+		{
+			index = m_nextWorker;
+			m_nextWorker = (m_nextWorker + 1) % getThreadCount();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_workers[index]->m_mutex);
+		m_workers[index]->m_tasks.push_back(std::move(task));
+	}
+
+	m_condition.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCondition.wait(lock, [this]() { return m_pendingCount == 0; });
+}
+
+bool WorkStealingPool::takeTask(unsigned index, std::function<void()>& task)
+{
+	//the newest task of the own queue, its data is most likely still in the cache
+	{
+		Worker& worker = *m_workers[index];
+		std::lock_guard<std::mutex> lock(worker.m_mutex);
+
+		if (!worker.m_tasks.empty())
+		{
+			task = std::move(worker.m_tasks.back());
+			worker.m_tasks.pop_back();
+			return true;
+		}
+	}
+
+	//the oldest task of another worker, starting with the next one, so that the thieves don't all go for the same queue
+	for (unsigned i = 1; i < getThreadCount(); ++i)
+	{
+		Worker& victim = *m_workers[(index + i) % getThreadCount()];
+		std::lock_guard<std::mutex> lock(victim.m_mutex);
+
+		if (!victim.m_tasks.empty())
+		{
+			task = std::move(victim.m_tasks.front());
+			victim.m_tasks.pop_front();
+
+			std::lock_guard<std::mutex> countLock(m_mutex);
+			m_stolenCount++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void WorkStealingPool::run(unsigned index)
+{
+	currentPool = this;
+	currentWorker = index;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stop || m_queuedCount > 0; });
+
+			//all tasks are finished before stopping
+			if (m_queuedCount == 0) return;
+		}
+
+		//a counted task may not be in its queue yet, then the worker looks again
+		std::function<void()> task;
+		if (!takeTask(index, task))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queuedCount--;
+		}
+
+		task();
+
+		bool idle = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pendingCount--;
+			idle = m_pendingCount == 0;
+		}
+
+		if (idle) m_idleCondition.notify_all();
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+*   Fixed number of worker threads with a queue of tasks each, idle workers steal the tasks of busy ones
+*
+*   A task submitted by a worker goes to the back of its own queue and the worker takes the newest task first, so work
+*   which a task splits up is usually done by the same thread. A worker whose queue is empty takes the oldest task of
+*   another worker, which is the largest remaining piece of work if the tasks split it recursively. Tasks submitted
+*   from outside the pool are spread over the workers in turn.
+*/
+class WorkStealingPool
+{
+private:
+
+	/**
+	*   queue of a single worker
+	*/
+	struct Worker
+	{
+		std::deque<std::function<void()>> m_tasks; //!< tasks of the worker, its own ones are taken from the back, stolen ones from the front
+		std::mutex m_mutex;                        //!< protects m_tasks
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers; //!< queue of every worker
+	std::vector<std::thread> m_threads;             //!< worker threads, m_threads[i] takes from m_workers[i] first
+	std::mutex m_mutex;                             //!< protects the counters and m_stop
+	std::condition_variable m_condition;            //!< signals queued tasks and stopping to the workers
+	std::condition_variable m_idleCondition;        //!< signals that all tasks were executed
+	uint64_t m_queuedCount = 0;                     //!< number of tasks in the queues
+	uint64_t m_pendingCount = 0;                    //!< number of submitted tasks which weren't finished yet
+	uint64_t m_stolenCount = 0;                     //!< number of tasks executed by another worker than the one they were queued at
+	unsigned m_nextWorker = 0;                      //!< worker which gets the next task submitted from outside the pool
+	bool m_stop = false;                            //!< set when the pool is being destroyed
+
+	/**
+	*   \brief Main loop of a worker thread, executes tasks until the pool is destroyed
+	*   \param index index of the worker
+	*/
+	void run(unsigned index);
+
+	/**
+	*   \brief Takes a task from the own queue of a worker or steals one from another worker
+	*   \param index index of the worker
+	*   \param task the task gets saved here
+	*   \return true if a task was taken, false if all queues are empty
+	*/
+	bool takeTask(unsigned index, std::function<void()>& task);
+
+public:
+
+	/**
+	*   \brief Starts the worker threads
+	*   \param threadCount number of worker threads, at least one thread is always started
+	*/
+	explicit WorkStealingPool(unsigned threadCount);
+
+	WorkStealingPool(const WorkStealingPool& other) = delete;
+
+	WorkStealingPool& operator=(const WorkStealingPool& other) = delete;
+
+	/**
+	*   \brief Finishes all submitted tasks and stops the worker threads
+	*/
+	~WorkStealingPool();
+
+	/**
+	*   \brief Returns the number of worker threads
+	*   \return number of worker threads
+	*/
+	unsigned getThreadCount() const;
+
+	/**
+	*   \brief Returns the index of the worker which executes the calling task, e.g. to pick the memory of the worker
+	*   \return index of the worker between 0 and getThreadCount() - 1, getThreadCount() if not called from a worker of this pool
+	*/
+	unsigned getWorkerIndex() const;
+
+	/**
+	*   \brief Returns the number of tasks which were stolen so far
+	*   \return number of tasks executed by another worker than the one they were queued at
+	*/
+	uint64_t getStolenCount();
+
+	/**
+	*   \brief Submits a task for execution, may be called by a task of the pool
+	*   \param task callable object without parameters
+	*/
+	void submit(std::function<void()> task);
+
+	/**
+	*   \brief Waits until all submitted tasks, including the ones submitted by other tasks, were executed
+	*   Mustn't be called by a task of the pool.
+	*/
+	void wait();
+};
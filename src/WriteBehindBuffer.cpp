@@ -0,0 +1,98 @@
+#include "WriteBehindBuffer.h"
+
+#include <algorithm>
+
+WriteBehindBuffer::WriteBehindBuffer(std::streambuf* target, size_t chunkSize)
+	: m_target(target), m_chunkSize(std::max<size_t>(chunkSize, 1))
+{
+	m_current.resize(m_chunkSize);
+	setp(&m_current[0], &m_current[0] + m_chunkSize);
+
+	m_thread = std::thread(&WriteBehindBuffer::run, this);
+}
+
+WriteBehindBuffer::~WriteBehindBuffer()
+{
+	sync();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+	m_thread.join();
+}
+
+void WriteBehindBuffer::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_condition.wait(lock, [this]() { return m_stop || !m_chunks.empty(); });
+		if (m_chunks.empty()) return;
+
+		//the chunk stays in the queue while it is written, so that the writer can wait for it
+		std::string& chunk = m_chunks.front();
+		m_writing = true;
+		lock.unlock();
+
+		bool written = m_target->sputn(chunk.data(), chunk.size()) == static_cast<std::streamsize>(chunk.size());
+
+		lock.lock();
+		m_writing = false;
+		m_failed = m_failed || !written;
+		m_chunks.pop_front();
+		m_condition.notify_all();
+	}
+}
+
+bool WriteBehindBuffer::handOver()
+{
+	size_t size = pptr() - pbase();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (size > 0)
+	{
+		m_condition.wait(lock, [this]() { return m_chunks.size() < CHUNK_COUNT; });
+
+		m_current.resize(size);
+		m_chunks.push_back(std::move(m_current));
+		m_condition.notify_all();
+
+		m_current = std::string();
+		m_current.resize(m_chunkSize);
+	}
+
+	setp(&m_current[0], &m_current[0] + m_chunkSize);
+
+	return !m_failed;
+}
+
+WriteBehindBuffer::int_type WriteBehindBuffer::overflow(int_type character)
+{
+	if (!handOver()) return traits_type::eof();
+
+	if (!traits_type::eq_int_type(character, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(character);
+		pbump(1);
+	}
+
+	return traits_type::not_eof(character);
+}
+
+int WriteBehindBuffer::sync()
+{
+	handOver();
+
+	//wait until everything is written, so that the caller can rely on the target having all data
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this]() { return m_chunks.empty() && !m_writing; });
+
+	if (m_failed || m_target->pubsync() != 0) return -1;
+
+	return 0;
+}
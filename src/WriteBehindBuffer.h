@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+/**
+*   Stream buffer which writes to another stream buffer in a background thread
+*
+*   Written data is collected in chunks, full chunks are written by the background thread while the writer goes on.
+*   At most CHUNK_COUNT chunks wait for writing, then the writer waits. Flushing the stream waits until all data is
+*   written to the target and reports errors of the background writes.
+*/
+class WriteBehindBuffer : public std::streambuf
+{
+private:
+
+	static constexpr size_t CHUNK_COUNT = 2; //!< maximum number of chunks waiting for writing
+
+	std::streambuf* m_target;            //!< stream buffer which is written, not owned
+	size_t m_chunkSize;                  //!< number of bytes in a full chunk
+	std::deque<std::string> m_chunks;    //!< chunks waiting for writing, in order
+	std::string m_current;               //!< chunk being filled by the put area
+	std::mutex m_mutex;                  //!< protects m_chunks, m_writing, m_failed and m_stop
+	std::condition_variable m_condition; //!< signals new chunks to the background thread and written chunks to the writer
+	bool m_writing = false;              //!< set while the background thread writes a chunk
+	bool m_failed = false;               //!< set when the target didn't accept all data
+	bool m_stop = false;                 //!< set when the buffer is being destroyed
+	std::thread m_thread;                //!< writes the chunks to the target
+
+	/**
+	*   \brief Main loop of the background thread, writes chunks until stopped
+	*/
+	void run();
+
+	/**
+	*   \brief Hands the filled part of the current chunk over to the background thread and starts a new chunk
+	*   \return false if an earlier write failed
+	*/
+	bool handOver();
+
+protected:
+
+	int_type overflow(int_type character) override;
+
+	int sync() override;
+
+public:
+
+	static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20; //!< number of bytes in a full chunk if none is given
+
+	/**
+	*   \brief Starts the background thread
+	*   \param target stream buffer to write, it mustn't be used by anything else while this buffer exists
+	*   \param chunkSize number of bytes in a full chunk, at most CHUNK_COUNT + 1 chunks are in memory, including the one being filled
+	*/
+	explicit WriteBehindBuffer(std::streambuf* target, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+	WriteBehindBuffer(const WriteBehindBuffer& other) = delete;
+
+	WriteBehindBuffer& operator=(const WriteBehindBuffer& other) = delete;
+
+	/**
+	*   \brief Writes the remaining data and stops the background thread
+	*/
+	~WriteBehindBuffer() override;
+};
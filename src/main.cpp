@@ -1,20 +1,133 @@
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <csignal>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "ArchiveCoder.h"
 #include "BWT_MTF_RLE_Huffman_Coder.h"
+#include "CompressionClient.h"
+#include "CompressionServer.h"
+#include "FileDescriptorBuffer.h"
+#include "LogWriter.h"
+#include "MemoryUsage.h"
+#include "ReadAheadBuffer.h"
+#include "StageTimer.h"
+#include "ThreadPool.h"
+#include "WriteBehindBuffer.h"
+
+/**
+*   \brief Parses an unsigned decimal number
+*   \param str string to parse
+*   \param value parsed number gets saved here
+*   \return true if the whole string is a valid number, false otherwise
+*/
+bool parseNumber(const std::string& str, uint64_t& value)
+{
+	if (str.empty() || !std::isdigit(static_cast<unsigned char>(str[0]))) return false;
+
+	char* end = nullptr;
+	errno = 0;
+	value = std::strtoull(str.c_str(), &end, 10);
+
+	return errno == 0 && *end == '\0';
+}
+
+/**
+*   \brief Sends the whole input to a compression server and writes its response to the output
+*   \param path path of the socket file of the server
+*   \param op type of the request, CompressionServer::OP_* value
+*   \param input input stream, read until its end
+*   \param output output stream
+*   \param memoryFile true to pass the data in memory files instead of through the socket
+*   \param log sizes of the uncoded and the encoded data get saved here
+*   \return true on success, false on error, which gets printed
+*/
+bool requestServer(const std::string& path, uint8_t op, std::istream& input, std::ostream& output, bool memoryFile, Log& log)
+{
+	std::string payload;
+	if (op != CompressionServer::OP_STATS) payload.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+	CompressionClient client;
+	std::string result;
+	if (!client.connect(path) || !client.request(op, payload, result, memoryFile))
+	{
+		std::cout << "The request to the server at \"" << path << "\" failed: " << client.getError() << "\n";
+		return false;
+	}
+
+	output.write(result.data(), result.size());
+
+	if (op == CompressionServer::OP_ENCODE)
+	{
+		log.m_uncodedSize = payload.size();
+		log.m_codedSize = result.size();
+	}
+	else if (op == CompressionServer::OP_DECODE)
+	{
+		log.m_uncodedSize = result.size();
+		log.m_codedSize = payload.size();
+	}
+
+	return static_cast<bool>(output);
+}
+
+CompressionServer* runningServer = nullptr; //server which is stopped by SIGINT and SIGTERM
+
+/**
+*   \brief Stops the running server, so that it removes its socket file before the program exits
+*   \param signal number of the received signal
+*/
+extern "C" void stopServer(int signal)
+{
+	(void)signal;
+	if (runningServer != nullptr) runningServer->stop();
+}
+
+const uint64_t MEBIBYTE = 1 << 20;                 //number of bytes in MiB
+const uint64_t MAX_MEMORY_BUDGET = uint64_t(1) << 24; //maximum memory budget in MiB
+const uint64_t MAX_FLUSH_DELAY = 3600000;            //maximum flush delay in milliseconds
+const uint64_t IO_BUFFER_COUNT = 9;                   //maximum number of I/O buffers in memory: one for each standard stream, four for reading ahead and three for writing behind
+const uint64_t IO_BUDGET_FRACTION = 64;               //a single I/O buffer takes at most this fraction of the memory budget
 
 int main(int argc, char *argv[])
 {
-	char action = 0; //action to perform ('c' - code, 'x' - decode, 'h' - help)
+	char action = 0; //action to perform ('c' - code, 'x' - decode, 't' - test, 's' - search, 'm' - train a model, 'd' - serve, 'q' - query the server, 'a' - archive, 'e' - extract from an archive, 'l' - list an archive, 'h' - help)
 	std::ifstream inputStream; 
 	std::ofstream outputStream; 
+	std::fstream appendStream; //output file with an existing stream, read and written by --append
 	std::ofstream logStream; 
 	BWT_MTF_RLE_Huffman_Coder coder;
 	Log log; 
 	log.m_uncodedSize = 0;
 	log.m_codedSize = 0;
 	bool success = true;
+	bool decodeRange = false; //decode only a range of the uncoded data
+	uint64_t rangeOffset = 0; //position of the first byte of the range in the uncoded data
+	uint64_t rangeLength = 0; //number of bytes of the range
+	std::string pattern;      //pattern to search for
+	int level = BWT_MTF_RLE_Huffman_Coder::DEFAULT_LEVEL; //compression level
+	uint64_t blockSize = 0;   //block size overriding the compression level, 0 if not specified
+	uint64_t threadCount = 0; //number of threads, 0 if not specified
+	uint64_t memoryBudget = 0; //memory budget in MiB, 0 if not specified
+	uint64_t flushDelay = 0;  //maximum delay of the encoded output in milliseconds, 0 if not specified
+	uint64_t minBlockSize = 0; //minimum size of blocks ended early at a shift of the content, 0 for blocks of fixed size
+	bool JSONLog = false;     //write the log as JSON instead of plain text
+	bool asyncIO = true;      //read ahead and write behind in background threads
+	std::string socketPath;   //socket file of the server to run with 'd' or to send the requests to, empty to encode and decode in this process
+	bool memoryFile = false;  //pass the data to the server in memory files
+	std::string archiveSource; //directory or list of files to archive with 'a'
+	std::string archiveName;  //name of the file to extract from the archive with 'e'
+	std::string outputPath;   //name of the output file, opened once all options are known, because --append mustn't truncate it
+	bool append = false;      //encode into new blocks at the end of the stream in the output file
     
     for (int i = 1; i < argc; ++i)
 	{
@@ -32,91 +145,497 @@ int main(int argc, char *argv[])
 				return -1;
 			}
 		}
-		else if (arg == "-o" && i < argc - 1) //name of output file follows, open it
+		else if (arg == "-o" && i < argc - 1) //name of output file follows
 		{
-			outputStream.open(argv[i + 1], std::ofstream::out | std::ifstream::binary);
+			outputPath = argv[i + 1];
 		}
 		else if (arg == "-l" && i < argc - 1) //name of log file follows, open it
 		{
 			logStream.open(argv[i + 1]);
 		}
-		else if (arg == "-c" || arg == "-x" || arg == "-h") //encode, decode or print help
+		else if (arg == "--model" && i < argc - 1) //name of the file with the shared entropy model follows, read it
+		{
+			std::ifstream modelStream(argv[i + 1], std::ifstream::in | std::ifstream::binary);
+			std::shared_ptr<EntropyModel> model = std::make_shared<EntropyModel>();
+
+			if (!modelStream.is_open() || !model->read(modelStream))
+			{
+				//unable to read given model, close everything, print error and exit program
+				if (inputStream.is_open()) inputStream.close();
+				if (outputStream.is_open()) outputStream.close();
+				if (logStream.is_open()) logStream.close();
+				std::cout << "The specified model file \"" << argv[i + 1] << "\" couldn't be read!\n";
+				return -1;
+			}
+
+			coder.setModel(model);
+		}
+		else if (arg == "--range" && i < argc - 1) //range of uncoded data to decode follows in the format offset:length
+		{
+			std::string range = argv[i + 1];
+			std::string::size_type separator = range.find(':');
+
+			if (separator == std::string::npos
+				|| !parseNumber(range.substr(0, separator), rangeOffset)
+				|| !parseNumber(range.substr(separator + 1), rangeLength))
+			{
+				//invalid range, close everything, print error and exit program
+				if (inputStream.is_open()) inputStream.close();
+				if (outputStream.is_open()) outputStream.close();
+				if (logStream.is_open()) logStream.close();
+				std::cout << "The specified range \"" << argv[i + 1] << "\" isn't in the format offset:length!\n";
+				return -1;
+			}
+
+			decodeRange = true;
+		}
+		else if (arg.size() == 2 && arg[0] == '-' && arg[1] >= '1' && arg[1] <= '9') //compression level
+		{
+			level = arg[1] - '0';
+		}
+		else if ((arg == "-b" || arg == "--threads" || arg == "-m" || arg == "--flush-ms" || arg == "--adaptive-blocks") && i < argc - 1) //block size, number of threads, memory budget, flush delay or minimum block size follows
+		{
+			uint64_t value = 0;
+			uint64_t maxValue = ThreadPool::MAX_THREAD_COUNT;
+			if (arg == "-b" || arg == "--adaptive-blocks") maxValue = StreamFormat::MAX_LARGE_BLOCK_SIZE;
+			if (arg == "-m") maxValue = MAX_MEMORY_BUDGET;
+			if (arg == "--flush-ms") maxValue = MAX_FLUSH_DELAY;
+
+			if (!parseNumber(argv[i + 1], value) || value == 0 || value > maxValue)
+			{
+				//invalid number, close everything, print error and exit program
+				if (inputStream.is_open()) inputStream.close();
+				if (outputStream.is_open()) outputStream.close();
+				if (logStream.is_open()) logStream.close();
+				std::cout << "The value \"" << argv[i + 1] << "\" of " << arg << " must be a number between 1 and " << maxValue << "!\n";
+				return -1;
+			}
+
+			if (arg == "-b")
+			{
+				blockSize = value;
+			}
+			else if (arg == "--threads")
+			{
+				threadCount = value;
+			}
+			else if (arg == "-m")
+			{
+				memoryBudget = value;
+			}
+			else if (arg == "--adaptive-blocks")
+			{
+				minBlockSize = value;
+			}
+			else
+			{
+				flushDelay = value;
+			}
+		}
+		else if (arg == "--search-index") //store the search index with the encoded blocks
+		{
+			coder.setSearchIndex(true);
+		}
+		else if (arg == "--large-blocks") //store 64-bit sizes of the blocks
+		{
+			coder.setLargeBlocks(true);
+		}
+		else if (arg == "--json") //write the log as JSON
+		{
+			JSONLog = true;
+		}
+		else if (arg == "--no-checksum") //don't store the checksums of the blocks
+		{
+			coder.setChecksum(false);
+		}
+		else if (arg == "--dedup") //refer to earlier identical blocks instead of encoding them again
+		{
+			coder.setDeduplication(true);
+		}
+		else if (arg == "--sync-io") //read and write in the thread of the coder
+		{
+			asyncIO = false;
+		}
+		else if (arg == "--append") //add the encoded input to the stream in the output file
+		{
+			append = true;
+		}
+		else if (arg == "-s" && i < argc - 1) //search for the pattern which follows
+		{
+			action = 's';
+			pattern = argv[i + 1];
+		}
+		else if (arg == "-c" || arg == "-x" || arg == "-t" || arg == "-h") //encode, decode, test or print help
 		{
 			action = arg[1]; 
 		}
+		else if (arg == "--train") //train a shared entropy model
+		{
+			action = 'm';
+		}
+		else if (arg == "--serve" && i < argc - 1) //run the server at the socket which follows
+		{
+			action = 'd';
+			socketPath = argv[i + 1];
+		}
+		else if (arg == "--connect" && i < argc - 1) //send the requests to the server at the socket which follows
+		{
+			socketPath = argv[i + 1];
+		}
+		else if (arg == "--memfd") //pass the data to the server in memory files
+		{
+			memoryFile = true;
+		}
+		else if (arg == "--stats") //print the statistics of the server
+		{
+			action = 'q';
+		}
+		else if (arg == "--archive" && i < argc - 1) //archive the directory or the list of files which follows
+		{
+			action = 'a';
+			archiveSource = argv[i + 1];
+		}
+		else if (arg == "--extract" && i < argc - 1) //extract the file of the archive which follows
+		{
+			action = 'e';
+			archiveName = argv[i + 1];
+		}
+		else if (arg == "--list") //list the files of the archive
+		{
+			action = 'l';
+		}
     }
 
+	//the new blocks are added to the stream in the output file, which is read too
+	if (append && (action != 'c' || outputPath.empty() || !socketPath.empty()))
+	{
+		if (inputStream.is_open()) inputStream.close();
+		if (logStream.is_open()) logStream.close();
+		std::cout << "--append needs -c and the output file given by -o, it can't be sent to a server!\n";
+		return -1;
+	}
+
+	if (append)
+	{
+		//a missing output file is created empty and gets a new stream
+		if (!std::ifstream(outputPath).is_open()) std::ofstream(outputPath, std::ofstream::out | std::ofstream::binary);
+		appendStream.open(outputPath, std::fstream::in | std::fstream::out | std::fstream::binary);
+
+		if (!appendStream.is_open())
+		{
+			if (inputStream.is_open()) inputStream.close();
+			if (logStream.is_open()) logStream.close();
+			std::cout << "The specified output file \"" << outputPath << "\" couldn't be opened!\n";
+			return -1;
+		}
+	}
+	else if (!outputPath.empty())
+	{
+		outputStream.open(outputPath, std::ofstream::out | std::ofstream::binary);
+	}
+
+	//the statistics are kept by the server
+	if (action == 'q' && socketPath.empty())
+	{
+		if (inputStream.is_open()) inputStream.close();
+		if (outputStream.is_open()) outputStream.close();
+		if (logStream.is_open()) logStream.close();
+		std::cout << "--stats needs the socket of the server given by --connect <socket>!\n";
+		return -1;
+	}
+
+	//the buffers of the standard streams and of the background I/O are taken from the memory budget,
+	//up to IO_BUFFER_COUNT of them are in memory at once
+	size_t IOBufferSize = FileDescriptorBuffer::DEFAULT_BUFFER_SIZE;
+	if (memoryBudget > 0) IOBufferSize = static_cast<size_t>(std::min<uint64_t>(IOBufferSize, memoryBudget * MEBIBYTE / IO_BUDGET_FRACTION));
+
+	//explicit options override the parameters chosen by the compression level
+	coder.setLevel(level);
+	if (blockSize > 0) coder.setBlockSize(blockSize);
+	if (threadCount > 0) coder.setThreadCount(threadCount);
+	coder.setMemoryBudget(memoryBudget * MEBIBYTE - std::min<uint64_t>(memoryBudget * MEBIBYTE, IO_BUFFER_COUNT * IOBufferSize));
+	coder.setFlushDelay(std::chrono::milliseconds(flushDelay));
+	coder.setMinBlockSize(minBlockSize);
+
+	//the search index can only address blocks with 32-bit positions
+	if (action == 'c' && coder.getSearchIndex() && (coder.getLargeBlocks() || coder.getBlockSize() > StreamFormat::MAX_BLOCK_SIZE))
+	{
+		if (inputStream.is_open()) inputStream.close();
+		if (outputStream.is_open()) outputStream.close();
+		if (logStream.is_open()) logStream.close();
+		std::cout << "The search index can't be stored with blocks larger than " << StreamFormat::MAX_BLOCK_SIZE << " bytes!\n";
+		return -1;
+	}
+
+	//use standard input and output if input or output file isn't specified,
+	//they are read and written directly instead of through std::cin and std::cout, which are synchronized with stdio
+	std::unique_ptr<FileDescriptorBuffer> standardInputBuffer;
+	std::unique_ptr<FileDescriptorBuffer> standardOutputBuffer;
+	if (!inputStream.is_open()) standardInputBuffer = std::make_unique<FileDescriptorBuffer>(0, std::ios_base::in, IOBufferSize);
+	if (!outputStream.is_open()) standardOutputBuffer = std::make_unique<FileDescriptorBuffer>(1, std::ios_base::out, IOBufferSize);
+	std::istream standardInput(standardInputBuffer.get());
+	std::ostream standardOutput(standardOutputBuffer.get());
+	std::istream& directInput = inputStream.is_open() ? static_cast<std::istream&>(inputStream) : standardInput;
+	std::ostream& directOutput = outputStream.is_open() ? static_cast<std::ostream&>(outputStream) : standardOutput;
+
+	//an archive isn't a single stream, the actions for streams would only fail on it
+	if ((action == 'x' || action == 't' || action == 's') && ArchiveCoder::isArchive(directInput))
+	{
+		if (inputStream.is_open()) inputStream.close();
+		if (outputStream.is_open()) outputStream.close();
+		if (logStream.is_open()) logStream.close();
+		std::cout << "The input is an archive, use --list to print its files and --extract <name> to decode one of them!\n";
+		return -1;
+	}
+
+	//the index of an archive is at its end, so listing and extracting seek in the input
+	if ((action == 'l' || action == 'e') && directInput.tellg() == std::streampos(-1))
+	{
+		if (inputStream.is_open()) inputStream.close();
+		if (outputStream.is_open()) outputStream.close();
+		if (logStream.is_open()) logStream.close();
+		std::cout << "The archive must be seekable, give it by -i <ifile> or redirect it from a file instead of a pipe!\n";
+		return -1;
+	}
+
+	//sequential actions read ahead and write behind in background threads, so that the coder doesn't wait for the I/O,
+	//decoding a range and reading an archive seek in the input, so they read directly, encoding with a flush delay reads ahead by itself,
+	//creating an archive reads the files by itself
+	std::unique_ptr<ReadAheadBuffer> readAheadBuffer;
+	std::unique_ptr<WriteBehindBuffer> writeBehindBuffer;
+	if (asyncIO && action != 0 && action != 'h' && action != 'd')
+	{
+		if (!decodeRange && action != 'q' && action != 'a' && action != 'e' && action != 'l' && !(action == 'c' && flushDelay > 0)) readAheadBuffer = std::make_unique<ReadAheadBuffer>(directInput.rdbuf(), IOBufferSize);
+		writeBehindBuffer = std::make_unique<WriteBehindBuffer>(directOutput.rdbuf(), IOBufferSize);
+	}
+	std::istream readAheadInput(readAheadBuffer.get());
+	std::ostream writeBehindOutput(writeBehindBuffer.get());
+	std::istream& input = readAheadBuffer ? readAheadInput : directInput;
+	std::ostream& output = writeBehindBuffer ? writeBehindOutput : directOutput;
+
+	//the whole action is timed for the log, the stages are timed by the coder
+	std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+	double CPUStart = StageTimer::getProcessCPUTime();
+
 	switch (action) //action to perform 
 	{
 	case 'c': //encode
-        //input and output file are specified
-		if (inputStream.is_open() && outputStream.is_open())
+		if (!socketPath.empty())
 		{
-	        success = coder.encode(log, inputStream, outputStream);
+			success = requestServer(socketPath, CompressionServer::OP_ENCODE, input, output, memoryFile, log);
 		}
-        //output file isn't specified, use standard output
-		else if (inputStream.is_open())
+		else if (append)
 		{
-			success = coder.encode(log, inputStream, std::cout);
+			success = coder.append(log, input, appendStream);
+			if (!success) std::cout << "The output file \"" << outputPath << "\" doesn't end with a complete stream or the new blocks couldn't be written!\n";
 		}
-		//input file isn't specified, use standard input
-		else if (outputStream.is_open())
-	    {
-			success = coder.encode(log, std::cin, outputStream);
-		}
-		//input and output file aren't specified, use standard input and output
 		else
 		{
-			success = coder.encode(log, std::cin, std::cout);
+			success = coder.encode(log, input, output);
 		}
 		break;
 	case 'x': //decode
-		//input and output file are specified
-		if (inputStream.is_open() && outputStream.is_open())
+		if (!socketPath.empty())
 		{
-			success = coder.decode(log, inputStream, outputStream);
+			success = requestServer(socketPath, CompressionServer::OP_DECODE, input, output, memoryFile, log);
 		}
-		//output file isn't specified, use standard output
-		else if (inputStream.is_open())
+		else if (decodeRange)
 		{
-			success = coder.decode(log, inputStream, std::cout);
+			success = coder.decodeRange(log, input, output, rangeOffset, rangeLength);
 		}
-		//input file isn't specified, use standard input
-		else if (outputStream.is_open())
+		else
 		{
-			success = coder.decode(log, std::cin, outputStream);
+			success = coder.decode(log, input, output);
 		}
-		//input and output file aren't specified, use standard input and output
-		else
+		break;
+	case 't': //test
+		success = coder.verify(log, input);
+		break;
+	case 's': //search
 		{
-			success = coder.decode(log, std::cin, std::cout);
+			std::vector<uint64_t> positions;
+			success = coder.search(log, input, pattern, positions);
+
+			if (success)
+			{
+				//number of occurences followed by their positions in the uncoded data
+				output << positions.size() << "\n";
+				for (uint64_t position : positions)
+				{
+					output << position << "\n";
+				}
+			}
+		}
+		break;
+	case 'm': //train a model
+		{
+			EntropyModel model;
+			success = coder.train(log, input, model) && model.write(output);
+		}
+		break;
+	case 'd': //serve
+		{
+			CompressionServer server(coder);
+			if (!server.listen(socketPath))
+			{
+				std::cout << "The socket \"" << socketPath << "\" couldn't be created!\n";
+				success = false;
+				break;
+			}
+
+			runningServer = &server;
+			std::signal(SIGINT, stopServer);
+			std::signal(SIGTERM, stopServer);
+			success = server.run();
+			std::signal(SIGINT, SIG_DFL);
+			std::signal(SIGTERM, SIG_DFL);
+			runningServer = nullptr;
+
+			//the log of the server is the statistics of its requests
+			if (logStream.is_open())
+			{
+				server.writeStats(logStream);
+				logStream.close();
+			}
+		}
+		break;
+	case 'q': //query the server
+		success = requestServer(socketPath, CompressionServer::OP_STATS, input, output, false, log);
+		break;
+	case 'a': //archive
+		{
+			ArchiveCoder archiveCoder(coder);
+			std::vector<ArchiveCoder::ArchiveInput> inputs;
+			if (!archiveCoder.collectFiles(archiveSource, inputs))
+			{
+				std::cout << "The files to archive couldn't be collected from \"" << archiveSource << "\"!\n";
+				success = false;
+				break;
+			}
+
+			success = archiveCoder.create(log, inputs, output);
+		}
+		break;
+	case 'e': //extract from an archive
+		{
+			//the index is read first to tell a missing file from a corrupted archive
+			ArchiveCoder archiveCoder(coder);
+			StreamHeader streamHeader;
+			std::vector<ArchiveCoder::ArchiveEntry> entries;
+			const std::streampos archiveStart = input.tellg();
+			if (!archiveCoder.readIndex(input, streamHeader, entries))
+			{
+				std::cout << "The input isn't a valid archive!\n";
+				success = false;
+				break;
+			}
+
+			if (std::none_of(entries.begin(), entries.end(), [&archiveName](const ArchiveCoder::ArchiveEntry& entry) { return entry.m_name == archiveName; }))
+			{
+				std::cout << "There is no file \"" << archiveName << "\" in the archive!\n";
+				success = false;
+				break;
+			}
+
+			input.clear();
+			success = input.seekg(archiveStart) && archiveCoder.extract(log, input, archiveName, output);
+		}
+		break;
+	case 'l': //list an archive
+		{
+			StreamHeader streamHeader;
+			std::vector<ArchiveCoder::ArchiveEntry> entries;
+			success = ArchiveCoder(coder).readIndex(input, streamHeader, entries);
+			if (!success) std::cout << "The input isn't a valid archive!\n";
+
+			if (success)
+			{
+				//uncoded and coded size of every file followed by its name
+				for (const ArchiveCoder::ArchiveEntry& entry : entries)
+				{
+					uint64_t codedSize = 0;
+					for (const BlockIndexEntry& block : entry.m_blocks)
+					{
+						codedSize += block.m_codedSize;
+					}
+
+					output << entry.m_uncodedSize << " " << codedSize << " " << entry.m_name << "\n";
+				}
+			}
 		}
 		break;
 	case 'h': //print help
-		std::cout << "app_name [-i <ifile>] [-o <ofile>] [-l <logFile>] {-c | -x | -h}\n";
+		std::cout << "app_name [-i <ifile>] [-o <ofile>] [-l <logFile>] [--json] [-1 ... -9] [-b <size>] [--adaptive-blocks <minSize>] [--threads <count>] [-m <MiB>] [--flush-ms <ms>] [--range <offset>:<length>] [--model <modelFile>] [--search-index] [--large-blocks] [--no-checksum] [--dedup] [--sync-io] [--append] [--connect <socket>] [--memfd] {-c | -x | -t | -s <pattern> | --train | --serve <socket> | --stats | --archive <source> | --list | --extract <name> | -h}\n";
         std::cout << "-i <ifile>: input file name <ifile>. If not specified, standard input is used.\n";
 		std::cout << "-o <ofile>: output file name <ofile>. If not specified, standard output is used.\n";
 		std::cout << "-l <logfile>: log file name <logfile>. If not specified, log is not generated.\n";
+		std::cout << "--json: write the log as JSON instead of plain text.\n";
+		std::cout << "-1 ... -9: compression level, -1 is the fastest, -9 gives the best ratio, -5 is the default. Any level can be decoded.\n";
+		std::cout << "-b <size>: maximum number of bytes in a single block, overrides the block size of the compression level.\n";
+		std::cout << "--adaptive-blocks <minSize>: when encoding, end a block early where the byte statistics of the data change, e.g. between text and binary data, once it has at least <minSize> bytes. -b stays the maximum block size.\n";
+		std::cout << "--threads <count>: number of blocks encoded or verified in parallel. If not specified, all hardware threads are used.\n";
+		std::cout << "-m <MiB>: memory budget, the BWT sorter needing the least memory, then fewer threads and then smaller blocks are used when encoding, fewer threads when verifying.\n";
+		std::cout << "--flush-ms <ms>: when encoding, end the current block early and write it out if its oldest byte has waited <ms> milliseconds, so that a slow input can be decoded as it arrives.\n";
+		std::cout << "--range <offset>:<length>: decode only <length> bytes starting at <offset> of the uncoded data.\n";
+		std::cout << "--model <modelFile>: shared entropy model written by --train. When encoding, blocks use it instead of their own Huffman histogram if that makes them smaller. Streams encoded with a model need the same model for decoding.\n";
+		std::cout << "--search-index: store an FM-index with every encoded block, so that the encoded file can be searched.\n";
+		std::cout << "--large-blocks: store 64-bit sizes, used automatically for blocks larger than " << StreamFormat::MAX_BLOCK_SIZE << " bytes.\n";
+		std::cout << "--no-checksum: don't store CRC-32C checksums of the uncoded blocks.\n";
+		std::cout << "--dedup: when encoding, store a block which is identical to one of the recent earlier blocks of the stream as a reference to it instead of encoding it again. Decoding keeps up to " << StreamFormat::DEDUP_WINDOW / (1 << 20) << " MiB of recent blocks for the references.\n";
+		std::cout << "--sync-io: read the input and write the output in the coding thread instead of reading ahead and writing behind in background threads.\n";
+		std::cout << "--append: with -c, add the encoded input as new blocks to the end of the stream in the output file, whose blocks aren't encoded again. The new blocks use the block size and flags of the existing stream. A missing or empty output file gets a new stream.\n";
+		std::cout << "--connect <socket>: send -c, -x and --stats as requests to the server running at <socket> instead of encoding and decoding in this process.\n";
+		std::cout << "--memfd: pass the data to and from the server in memory files instead of through the socket.\n";
 		std::cout << "-c: encode the input file.\n";
 		std::cout << "-x: decode the input file.\n";
+		std::cout << "-t: decode all blocks of the input file in parallel and check them, nothing is written.\n";
+		std::cout << "-s <pattern>: print the number and positions of occurences of <pattern> in the input file encoded with the search index.\n";
+		std::cout << "--train: train a shared entropy model on the input file, which is a sample of the data to encode, and write it to the output file. Use -b close to the size of the messages the model is meant for.\n";
+		std::cout << "--serve <socket>: run a server which encodes and decodes the requests of local clients at the Unix domain socket <socket> with the given parameters until it gets SIGINT or SIGTERM. The log gets the statistics and latency histograms of the requests.\n";
+		std::cout << "--stats: print the statistics and latency histograms of the server given by --connect.\n";
+		std::cout << "--archive <source>: encode all regular files of the directory <source>, or the files listed one per line in the file <source>, into a single archive written to the output file. The blocks of all files are encoded in parallel.\n";
+		std::cout << "--list: print the uncoded size, coded size and name of every file in the input archive.\n";
+		std::cout << "--extract <name>: decode only the file <name> of the input archive, the other files aren't read.\n";
 		std::cout << "-h: print help information on the standard output.\n";
 		break;
 	default:
 		break;
 	}
 
+	//the buffered output belongs to the action, so that its time and errors are included,
+	//flushing the write-behind buffer waits until its background thread has written everything
+	if (!output.flush()) success = false;
+	if (writeBehindBuffer && !directOutput.flush()) success = false;
+	if (appendStream.is_open() && !appendStream.flush()) success = false;
+
+	//the background threads must be stopped before the files are closed
+	readAheadBuffer.reset();
+	writeBehindBuffer.reset();
+
     //generate log file if it is required and then close it
 	if (logStream.is_open())
 	{
-		logStream << "uncodedSize = " << log.m_uncodedSize << "\n";
-	    logStream << "codedSize = " << log.m_codedSize << "\n";
-		
+		log.m_peakMemory = MemoryUsage::getPeak();
+		log.m_wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+		log.m_CPUTime = StageTimer::getProcessCPUTime() - CPUStart;
+
+		LogWriter logWriter;
+		if (JSONLog)
+		{
+			logWriter.writeJSON(logStream, log);
+		}
+		else
+		{
+			logWriter.writeText(logStream, log);
+		}
+
 		logStream.close();
 	}
 
     //close input and output file if they are open
 	if (inputStream.is_open()) inputStream.close();
 	if (outputStream.is_open()) outputStream.close();
+	if (appendStream.is_open()) appendStream.close();
     
 	if (success == false)
 	{
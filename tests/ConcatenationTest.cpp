@@ -0,0 +1,151 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/BWT_MTF_RLE_Huffman_Coder.h"
+
+/**
+*   \brief Prints the result of a check
+*   \param name what was checked
+*   \param passed result of the check
+*   \return passed
+*/
+bool check(const std::string& name, bool passed)
+{
+	std::cout << (passed ? "passed: " : "FAILED: ") << name << "\n";
+
+	return passed;
+}
+
+/**
+*   \brief Encodes data into a new stream
+*   \param coder coder with the parameters of the stream
+*   \param data uncoded data
+*   \param stream encoded stream gets saved here
+*   \return true on success, false on error
+*/
+bool encode(const BWT_MTF_RLE_Huffman_Coder& coder, const std::string& data, std::string& stream)
+{
+	Log log;
+	std::istringstream inputStream(data);
+	std::ostringstream outputStream;
+	if (!coder.encode(log, inputStream, outputStream)) return false;
+
+	stream = outputStream.str();
+
+	return true;
+}
+
+/**
+*   \brief Appends data to an existing stream as new blocks
+*   \param coder coder which appends the blocks, the parameters of the existing stream are used
+*   \param data uncoded data
+*   \param stream existing stream, the new blocks are added to it
+*   \return true on success, false on error
+*/
+bool append(const BWT_MTF_RLE_Huffman_Coder& coder, const std::string& data, std::string& stream)
+{
+	Log log;
+	std::istringstream inputStream(data);
+	std::stringstream appendStream(stream, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+	if (!coder.append(log, inputStream, appendStream)) return false;
+
+	stream = appendStream.str();
+
+	return true;
+}
+
+/**
+*   \brief Decodes a range of the uncoded data
+*   \param coder coder which decodes the range
+*   \param stream encoded data
+*   \param offset position of the first byte of the range
+*   \param length number of bytes of the range
+*   \param data decoded range gets saved here
+*   \return true on success, false on error
+*/
+bool decodeRange(const BWT_MTF_RLE_Huffman_Coder& coder, const std::string& stream, uint64_t offset, uint64_t length, std::string& data)
+{
+	Log log;
+	std::istringstream inputStream(stream);
+	std::ostringstream outputStream;
+	if (!coder.decodeRange(log, inputStream, outputStream, offset, length)) return false;
+
+	data = outputStream.str();
+
+	return true;
+}
+
+int main()
+{
+	std::ifstream file(BWTED_TEST_FILE, std::ios_base::binary);
+	std::stringstream fileContent;
+	fileContent << file.rdbuf();
+	const std::string text = fileContent.str();
+	if (text.size() < 3 * 100000)
+	{
+		std::cout << "The test file \"" << BWTED_TEST_FILE << "\" couldn't be read!\n";
+		return EXIT_FAILURE;
+	}
+
+	//three parts of the text, every one of them spans several blocks
+	const std::string first = text.substr(0, 100000);
+	const std::string second = text.substr(100000, 70000);
+	const std::string appended = text.substr(170000, 50000);
+	const std::string expected = first + second + appended;
+
+	BWT_MTF_RLE_Huffman_Coder coder;
+	coder.setBlockSize(16384);
+	coder.setThreadCount(2);
+
+	//two independently encoded streams, the second one gets the appended blocks, the streams differ in their parameters
+	std::string firstStream;
+	std::string secondStream;
+	coder.setChecksum(false);
+	bool success = check("encode the first stream", encode(coder, first, firstStream));
+	coder.setBlockSize(24000);
+	coder.setChecksum(true);
+	success = check("encode the second stream", encode(coder, second, secondStream)) && success;
+	success = check("append to the second stream", append(coder, appended, secondStream)) && success;
+	if (!success) return EXIT_FAILURE;
+
+	const std::string concatenated = firstStream + secondStream;
+
+	//-x
+	Log log;
+	std::istringstream decodeInput(concatenated);
+	std::ostringstream decodeOutput;
+	success = check("decode the concatenated streams", coder.decode(log, decodeInput, decodeOutput) && decodeOutput.str() == expected) && success;
+
+	//-t
+	std::istringstream verifyInput(concatenated);
+	success = check("verify the concatenated streams", coder.verify(log, verifyInput)) && success;
+
+	//a corrupted block of the second stream must be found as well, its blocks have checksums
+	std::string corrupted = concatenated;
+	corrupted[firstStream.size() + secondStream.size() / 2] ^= 0x10;
+	std::istringstream corruptedInput(corrupted);
+	success = check("reject a corrupted second stream", !coder.verify(log, corruptedInput)) && success;
+
+	//--range across the boundary of the two streams and across the boundary of the appended blocks
+	std::string range;
+	success = check("decode a range across the streams",
+		decodeRange(coder, concatenated, first.size() - 5000, 10000, range) && range == expected.substr(first.size() - 5000, 10000)) && success;
+	success = check("decode a range across the appended blocks",
+		decodeRange(coder, concatenated, first.size() + second.size() - 100, 200, range) && range == expected.substr(first.size() + second.size() - 100, 200)) && success;
+	success = check("decode a range reaching past the end",
+		decodeRange(coder, concatenated, expected.size() - 1000, 5000, range) && range == expected.substr(expected.size() - 1000)) && success;
+
+	//--append to the concatenation adds the blocks to the last stream, the first one stays as it is
+	std::string appendedConcatenation = concatenated;
+	success = check("append to the concatenated streams", append(coder, first, appendedConcatenation)
+		&& appendedConcatenation.compare(0, firstStream.size(), firstStream) == 0) && success;
+	std::istringstream appendedInput(appendedConcatenation);
+	std::ostringstream appendedOutput;
+	success = check("decode the appended concatenation", coder.decode(log, appendedInput, appendedOutput) && appendedOutput.str() == expected + first) && success;
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+/**
+*   \brief Prints the result of a check
+*   \param name what was checked
+*   \param passed result of the check
+*   \return passed
+*/
+bool check(const std::string& name, bool passed)
+{
+	std::cout << (passed ? "passed: " : "FAILED: ") << name << "\n";
+
+	return passed;
+}
+
+/**
+*   \brief Reads a whole file
+*   \param path path of the file
+*   \return content of the file, empty if it can't be read
+*/
+std::string readFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios_base::binary);
+	std::stringstream content;
+	content << file.rdbuf();
+
+	return content.str();
+}
+
+/**
+*   \brief Waits until a file has the given size
+*   \param path path of the file
+*   \param size expected size of the file in bytes
+*   \param timeout maximum time to wait
+*   \return true if the file reached the size in time, false otherwise
+*/
+bool waitForSize(const std::string& path, uintmax_t size, std::chrono::milliseconds timeout)
+{
+	const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		std::error_code error;
+		if (std::filesystem::file_size(path, error) >= size && !error) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return false;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2)
+	{
+		std::cout << "Usage: bwted_pipe_test <bwted>\n";
+		return EXIT_FAILURE;
+	}
+
+	const std::string text = readFile(BWTED_TEST_FILE);
+	if (text.size() < 20000)
+	{
+		std::cout << "The test file \"" << BWTED_TEST_FILE << "\" couldn't be read!\n";
+		return EXIT_FAILURE;
+	}
+
+	//the input arrives in two parts with a pause between them, the pipe stays open during the pause
+	const std::string first = text.substr(0, 10000);
+	const std::string second = text.substr(10000, 10000);
+	const std::string outputPath = "bwted_pipe_test.out";
+	std::filesystem::remove(outputPath);
+
+	const std::string bwted = "\"" + std::string(argv[1]) + "\"";
+	const std::string command = bwted + " -c --flush-ms 50 | " + bwted + " -x -o " + outputPath;
+	std::FILE* pipe = popen(command.c_str(), "w");
+	if (pipe == nullptr)
+	{
+		std::cout << "The command \"" << command << "\" couldn't be started!\n";
+		return EXIT_FAILURE;
+	}
+
+	bool success = std::fwrite(first.data(), 1, first.size(), pipe) == first.size() && std::fflush(pipe) == 0;
+
+	//the encoder flushes the first part after its delay, the decoder must write it out before the rest of the input arrives
+	success = check("decode the first part while the pipe is open", success && waitForSize(outputPath, first.size(), std::chrono::seconds(10))) && success;
+	success = check("decode nothing more than the first part", readFile(outputPath) == first) && success;
+
+	success = std::fwrite(second.data(), 1, second.size(), pipe) == second.size() && success;
+	success = check("finish the pipe", pclose(pipe) == 0) && success;
+	success = check("decode all parts", readFile(outputPath) == first + second) && success;
+
+	std::filesystem::remove(outputPath);
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}